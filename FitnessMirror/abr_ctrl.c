@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件实现板端视频码率自适应的决策部分：汇总中继反馈，判断拥塞，在档位表内升降。
+ * 档位的实际生效(VPSS尺寸、VENC参数、发送限速)由调用方完成。
+ *
+ * This file implements the decision part of the board video bitrate adaptation: it gathers the relay
+ * feedback, detects congestion and moves within the level table. Applying a level (VPSS size,
+ * VENC parameters, send pacing) is left to the caller.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sample_media_ai.h"
+#include "abr_ctrl.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define ABR_LOSS_HIGH_PERMILLE  50 // Frame loss above 5% is congestion
+#define ABR_LOSS_LOW_PERMILLE   10 // Frame loss below 1% counts as a clean period
+#define ABR_RTT_RISE_US         80000 // RTT this far above the baseline means queues are building up
+#define ABR_FB_STALE_US         3000000 // Without a report for 3s only local drops are used
+#define ABR_DOWN_HOLD_US        2000000 // At most one step down per 2s, let the last one take effect
+#define ABR_PROBE_CLEAN         5 // Clean periods before the first probe up
+#define ABR_PROBE_MAX           60
+#define ABR_PROBE_FAIL_US       5000000 // Congestion within 5s of stepping up fails the probe
+#define ABR_MIN_RTT_CREEP       64 // The baseline creeps up 1/64 of the gap per report to follow route changes
+#define PERMILLE                1000
+#define FB_FIELDS               4
+
+void AbrCtrlInit(AbrCtrl* self, const AbrLevel ladder[], HI_U32 levelNum)
+{
+    HI_ASSERT(self && ladder && levelNum > 0);
+    if (memset_s(self, sizeof(*self), 0, sizeof(*self)) != EOK) {
+        HI_ASSERT(0);
+    }
+    pthread_mutex_init(&self->lock, NULL);
+    self->ladder = ladder;
+    self->levelNum = levelNum;
+    self->probeNeed = ABR_PROBE_CLEAN;
+}
+
+HI_BOOL AbrCtrlFeedback(AbrCtrl* self, const char* msg, HI_U64 nowUs)
+{
+    unsigned int frames, lost, fecFixed, rttUs;
+
+    if (strncmp(msg, "FB ", strlen("FB ")) != 0 ||
+        sscanf(msg + strlen("FB "), "%u %u %u %u", &frames, &lost, &fecFixed, &rttUs) != FB_FIELDS) {
+        return HI_FALSE;
+    }
+    pthread_mutex_lock(&self->lock);
+    self->fbFrames += frames;
+    self->fbLost += lost;
+    self->fbRttUs = rttUs > self->fbRttUs ? rttUs : self->fbRttUs;
+    self->fbLastUs = nowUs;
+    pthread_mutex_unlock(&self->lock);
+    return HI_TRUE;
+}
+
+/*
+ * 取走本周期的反馈，判断链路是否拥塞、是否通畅；没有新反馈时两者都由本地丢包决定
+ * Take the feedback of this period and tell whether the link is congested or clean;
+ * without a fresh report both follow the local drops alone
+ */
+static HI_VOID AbrCtrlJudge(AbrCtrl* self, HI_U32 localDrops, HI_U64 nowUs, HI_BOOL* congested, HI_BOOL* clean)
+{
+    HI_U32 frames, lost, rttUs;
+    HI_BOOL fresh;
+
+    pthread_mutex_lock(&self->lock);
+    frames = self->fbFrames;
+    lost = self->fbLost;
+    rttUs = self->fbRttUs;
+    fresh = self->fbLastUs != 0 && nowUs - self->fbLastUs < ABR_FB_STALE_US;
+    self->fbFrames = 0;
+    self->fbLost = 0;
+    self->fbRttUs = 0;
+    pthread_mutex_unlock(&self->lock);
+
+    *congested = localDrops > 0 ? HI_TRUE : HI_FALSE;
+    *clean = !*congested;
+    if (!fresh || frames + lost == 0) {
+        return;
+    }
+    self->lossPermille = lost * PERMILLE / (frames + lost);
+    if (rttUs > 0) {
+        self->rttUs = rttUs;
+        if (self->minRttUs == 0 || rttUs < self->minRttUs) {
+            self->minRttUs = rttUs;
+        } else {
+            self->minRttUs += (rttUs - self->minRttUs) / ABR_MIN_RTT_CREEP;
+        }
+    }
+    if (self->lossPermille > ABR_LOSS_HIGH_PERMILLE ||
+        (rttUs > 0 && rttUs > self->minRttUs + ABR_RTT_RISE_US)) {
+        *congested = HI_TRUE;
+    }
+    *clean = !*congested && self->lossPermille < ABR_LOSS_LOW_PERMILLE;
+}
+
+int AbrCtrlStep(AbrCtrl* self, HI_U32 localDrops, HI_U64 nowUs)
+{
+    HI_BOOL congested, clean;
+
+    AbrCtrlJudge(self, localDrops, nowUs, &congested, &clean);
+
+    /* A probe that held for ABR_PROBE_FAIL_US succeeded, the next one may come sooner */
+    if (self->lastUpUs != 0 && nowUs - self->lastUpUs >= ABR_PROBE_FAIL_US) {
+        self->probeNeed = self->probeNeed / 2 > ABR_PROBE_CLEAN ? self->probeNeed / 2 : ABR_PROBE_CLEAN;
+        self->lastUpUs = 0;
+    }
+
+    if (congested) {
+        self->cleanCnt = 0;
+        if (self->lastUpUs != 0) {
+            self->probeNeed = self->probeNeed * 2 < ABR_PROBE_MAX ? self->probeNeed * 2 : ABR_PROBE_MAX;
+            self->lastUpUs = 0;
+        }
+        if (self->level + 1 >= self->levelNum || nowUs - self->lastChangeUs < ABR_DOWN_HOLD_US) {
+            return -1;
+        }
+        self->level++;
+        self->lastChangeUs = nowUs;
+        __atomic_fetch_add(&self->downCnt, 1, __ATOMIC_RELAXED);
+        return (int)self->level;
+    }
+
+    self->cleanCnt = clean ? self->cleanCnt + 1 : 0;
+    if (self->level == 0 || self->cleanCnt < self->probeNeed) {
+        return -1;
+    }
+    self->level--;
+    self->cleanCnt = 0;
+    self->lastChangeUs = nowUs;
+    self->lastUpUs = nowUs;
+    __atomic_fetch_add(&self->upCnt, 1, __ATOMIC_RELAXED);
+    return (int)self->level;
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ABR_CTRL_H
+#define ABR_CTRL_H
+
+#include <pthread.h>
+#include "hi_type.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 视频码率自适应：按中继反馈(丢帧、往返时延)和本地发送丢包，在一组预设档位间升降
+ * 档位从0(最高画质)到levelNum-1(最低)，每档同时给定编码尺寸、帧率、JPEG QFactor和发送限速
+ * 拥塞时立即降一档(有最短间隔)，持续通畅若干周期后才试探升一档；刚升档就又拥塞说明试探失败，
+ * 下次升档所需的通畅周期加倍，避免在两档之间来回振荡
+ *
+ * Video bitrate adaptation: moves between preset levels following the relay feedback (frame loss,
+ * round trip time) and local send drops. Level 0 is the best quality and levelNum-1 the lowest, each
+ * level sets the encoded size, frame rate, JPEG QFactor and send pacing together.
+ * On congestion it steps down one level at once (with a minimum spacing), and only probes one level up
+ * after a number of clean periods. Congestion right after stepping up means the probe failed, and the
+ * clean periods needed for the next probe double, so it does not oscillate between two levels.
+ *
+ * 中继反馈走应答端口，每秒一次: "FB frames lost fecFixed rttUs"，均为上次反馈以来的增量
+ * The relay feedback comes over the ack port once a second: "FB frames lost fecFixed rttUs",
+ * counts being deltas since the previous report
+ */
+typedef struct AbrLevel {
+    HI_U32 width;
+    HI_U32 height;
+    HI_U32 fps;
+    HI_U32 qfactor;
+    HI_U32 kbps; // UDP pacing rate
+} AbrLevel;
+
+typedef struct AbrCtrl {
+    pthread_mutex_t lock;
+    const AbrLevel* ladder;
+    HI_U32 levelNum;
+    HI_U32 level; // Current level, written by AbrCtrlStep only
+
+    /* Feedback since the last step, under lock */
+    HI_U32 fbFrames;
+    HI_U32 fbLost;
+    HI_U32 fbRttUs; // Largest RTT reported
+    HI_U64 fbLastUs; // Time of the latest report, 0: never
+
+    HI_U32 minRttUs; // Baseline RTT, 0: unknown
+    HI_U32 cleanCnt; // Clean periods in a row
+    HI_U32 probeNeed; // Clean periods needed before stepping up
+    HI_U64 lastChangeUs;
+    HI_U64 lastUpUs;
+
+    HI_U32 lossPermille; // Frame loss of the latest period, for the stats printer
+    HI_U32 rttUs; // RTT of the latest period, for the stats printer
+    HI_U32 downCnt; // Read and cleared by the stats printer
+    HI_U32 upCnt; // Read and cleared by the stats printer
+} AbrCtrl;
+
+void AbrCtrlInit(AbrCtrl* self, const AbrLevel ladder[], HI_U32 levelNum);
+
+/*
+ * 处理应答端口收到的数据报，是反馈时返回HI_TRUE
+ * Handle a datagram from the ack port, HI_TRUE when it was a feedback report
+ */
+HI_BOOL AbrCtrlFeedback(AbrCtrl* self, const char* msg, HI_U64 nowUs);
+
+/*
+ * 周期调用(约每秒一次)，localDrops为本周期本地丢弃的分片和帧数；档位改变时返回新档位，否则返回-1
+ * Call periodically (about once a second), localDrops being the fragments and frames dropped locally in
+ * the period. Returns the new level when it changes, otherwise -1
+ */
+int AbrCtrlStep(AbrCtrl* self, HI_U32 localDrops, HI_U64 nowUs);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件提供了LED和舵机的执行线程，推理线程不再同步写GPIO和串口。
+ *
+ * This file provides the actuation thread for the LEDs and servos, so the inference thread no longer
+ * writes GPIOs and the UART synchronously.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "sample_media_ai.h"
+#include "gpio_user.h"
+#include "servo_link.h"
+#include "actuator.h"
+#include "pipe_stats.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define ACT_SERVO_VALID     (1ULL << 63)
+#define ACT_SERVO_SHIFT(i)  (16 * (i))
+#define ACT_SERVO_MASK      0xFFFFULL
+#define ACT_REFRESH_MS      500 // Resend unchanged angles this often, the MCU may have missed the last frame
+#define US_PER_MS           1000
+
+typedef void (*ActLedFn)(void);
+
+static const ActLedFn g_ledOn[ACT_LED_NUM] = { LED1_ON, LED2_ON };
+static const ActLedFn g_ledOff[ACT_LED_NUM] = { LED1_OFF, LED2_OFF };
+
+int ActuatorInit(Actuator* self)
+{
+    HI_ASSERT(self);
+    if (memset_s(self, sizeof(*self), 0, sizeof(*self)) != EOK) {
+        HI_ASSERT(0);
+    }
+    return AiEventInit(&self->event);
+}
+
+void ActuatorDeinit(Actuator* self)
+{
+    HI_ASSERT(self);
+    AiEventDeinit(&self->event);
+}
+
+void ActuatorSetLeds(Actuator* self, HI_U32 mask, HI_U32 on)
+{
+    HI_U32 old = __atomic_load_n(&self->leds, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(&self->leds, &old, (old & ~mask) | (on & mask),
+        HI_FALSE, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    __atomic_fetch_add(&self->ledPosts, 1, __ATOMIC_RELEASE);
+    AiEventSignal(&self->event);
+}
+
+void ActuatorSetServo(Actuator* self, const uint16_t angle[ACT_SERVO_NUM])
+{
+    HI_U64 val = ACT_SERVO_VALID;
+
+    for (int i = 0; i < ACT_SERVO_NUM; i++) {
+        val |= (HI_U64)angle[i] << ACT_SERVO_SHIFT(i);
+    }
+    __atomic_store_n(&self->servo, val, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&self->servoPosts, 1, __ATOMIC_RELEASE);
+    AiEventSignal(&self->event);
+}
+
+int ActuatorGetServo(const Actuator* self, uint16_t angle[ACT_SERVO_NUM])
+{
+    HI_U64 val = __atomic_load_n(&self->servo, __ATOMIC_ACQUIRE);
+
+    if (!(val & ACT_SERVO_VALID)) {
+        return HI_FAILURE;
+    }
+    for (int i = 0; i < ACT_SERVO_NUM; i++) {
+        angle[i] = (uint16_t)((val >> ACT_SERVO_SHIFT(i)) & ACT_SERVO_MASK);
+    }
+    return HI_SUCCESS;
+}
+
+/*
+ * 只写状态变化了的LED；第一次全部写一遍，与GPIO的实际状态对齐
+ * Only write the LEDs whose state changed; the first pass writes all of them to sync with the real GPIO state
+ */
+static void ActuatorApplyLeds(Actuator* self)
+{
+    HI_U32 posts = __atomic_exchange_n(&self->ledPosts, 0, __ATOMIC_ACQUIRE);
+    HI_U32 leds = __atomic_load_n(&self->leds, __ATOMIC_ACQUIRE);
+    HI_U32 changed = self->ledOutValid ? (leds ^ self->ledOut) : ((1U << ACT_LED_NUM) - 1);
+
+    if (posts == 0) {
+        return;
+    }
+    for (int i = 0; i < ACT_LED_NUM; i++) {
+        if (changed & (1U << i)) {
+            if (leds & (1U << i)) {
+                g_ledOn[i]();
+            } else {
+                g_ledOff[i]();
+            }
+            __atomic_fetch_add(&self->gpioCnt, 1, __ATOMIC_RELAXED);
+        }
+    }
+    self->ledOut = leds;
+    self->ledOutValid = HI_TRUE;
+    __atomic_fetch_add(&self->coalesceCnt, changed ? posts - 1 : posts, __ATOMIC_RELAXED);
+}
+
+/*
+ * 角度变化时发送；没有变化时只按ACT_REFRESH_MS补发，防止MCU错过了最后一帧
+ * Send when an angle changed; unchanged angles are only resent every ACT_REFRESH_MS in case the MCU missed the last frame
+ */
+static void ActuatorApplyServo(Actuator* self)
+{
+    HI_U32 posts = __atomic_exchange_n(&self->servoPosts, 0, __ATOMIC_ACQUIRE);
+    HI_U64 val = __atomic_load_n(&self->servo, __ATOMIC_ACQUIRE);
+    HI_U64 now = PipeStatsNowUs() / US_PER_MS;
+    HI_BOOL changed = val != self->servoOut ? HI_TRUE : HI_FALSE;
+    ServoSetpoint sp[ACT_SERVO_NUM];
+    HI_U64 t0;
+
+    if (!(val & ACT_SERVO_VALID) || (!changed && now - self->servoOutTime < ACT_REFRESH_MS)) {
+        __atomic_fetch_add(&self->coalesceCnt, posts, __ATOMIC_RELAXED);
+        return;
+    }
+    for (int i = 0; i < ACT_SERVO_NUM; i++) {
+        sp[i].id = (uint8_t)i;
+        sp[i].angle = (uint16_t)((val >> ACT_SERVO_SHIFT(i)) & ACT_SERVO_MASK);
+    }
+    t0 = PipeStatsNowUs();
+    if (ServoLinkSend(&servoLink, sp, ACT_SERVO_NUM, HI_TRUE) != HI_SUCCESS) {
+        SAMPLE_PRT("servo send FAIL\n");
+    }
+    PIPE_STATS_SINCE(PIPE_STAGE_UART, t0);
+    self->servoOut = val;
+    self->servoOutTime = now;
+    __atomic_fetch_add(&self->uartCnt, 1, __ATOMIC_RELAXED);
+    if (posts > 1) {
+        __atomic_fetch_add(&self->coalesceCnt, posts - 1, __ATOMIC_RELAXED);
+    }
+}
+
+void ActuatorRun(Actuator* self, const AiEvent* stop)
+{
+    HI_ASSERT(self);
+    while (AiEventWait(&self->event, stop, ACT_REFRESH_MS) != AI_EVENT_STOPPED) {
+        ActuatorApplyLeds(self);
+        ActuatorApplyServo(self);
+    }
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ACTUATOR_H
+#define ACTUATOR_H
+
+#include "hi_type.h"
+#include "ai_event.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#define ACT_LED1            HI_BIT0
+#define ACT_LED2            HI_BIT1
+#define ACT_LED_NUM         2
+#define ACT_SERVO_NUM       2 // Index is the servo id on the MCU
+
+/*
+ * 执行线程的最新值邮箱。推理线程和UDP线程只写入想要的LED状态和舵机角度并唤醒执行线程，
+ * 执行线程只在状态变化时写GPIO、在角度变化时发串口，中间被覆盖或没有变化的写入计为合并。
+ *
+ * Latest-value mailbox of the actuation thread. The inference and UDP threads only store the wanted
+ * LED states and servo angles and wake the thread, which writes a GPIO only when its state changes and
+ * sends over UART only when an angle changes. Posts overwritten in between or without change count as coalesced.
+ */
+typedef struct Actuator {
+    AiEvent event;
+    HI_U32 leds; // Wanted LED states, bit set = on
+    HI_U64 servo; // Wanted angles, ACT_SERVO_VALID | angle[i] << 16 * i, 0.01 degree
+    HI_U32 ledPosts; // Posts not yet seen by the thread
+    HI_U32 servoPosts;
+
+    HI_U32 ledOut; // Owned by the thread
+    HI_BOOL ledOutValid;
+    HI_U64 servoOut;
+    HI_U64 servoOutTime; // Monotonic ms of the latest send
+
+    HI_U32 gpioCnt; // GPIO writes, read and cleared by the stats printer
+    HI_U32 uartCnt; // UART frames, read and cleared by the stats printer
+    HI_U32 coalesceCnt; // Posts that caused no write, read and cleared by the stats printer
+} Actuator;
+
+/*
+ * 初始化邮箱
+ * Init the mailbox
+ */
+int ActuatorInit(Actuator* self);
+
+/*
+ * 销毁邮箱
+ * Destroy the mailbox
+ */
+void ActuatorDeinit(Actuator* self);
+
+/*
+ * 设置mask中LED的状态，on中对应位为1表示点亮，可在任意线程调用
+ * Set the state of the LEDs in mask, a bit set in on turns it on, callable from any thread
+ */
+void ActuatorSetLeds(Actuator* self, HI_U32 mask, HI_U32 on);
+
+/*
+ * 设置全部舵机的目标角度(0.01度)，可在任意线程调用
+ * Set the target angles of all servos in 0.01 degree, callable from any thread
+ */
+void ActuatorSetServo(Actuator* self, const uint16_t angle[ACT_SERVO_NUM]);
+
+/*
+ * 最近一次设置的舵机角度，没有设置过时返回HI_FAILURE
+ * The servo angles set last, HI_FAILURE when never set
+ */
+int ActuatorGetServo(const Actuator* self, uint16_t angle[ACT_SERVO_NUM]);
+
+/*
+ * 执行线程主循环，直到stop被置位
+ * Main loop of the actuation thread, runs until stop is set
+ */
+void ActuatorRun(Actuator* self, const AiEvent* stop);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+#include "sample_media_ai.h"
+#include "ai_event.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+int AiEventInit(AiEvent* self)
+{
+    HI_ASSERT(self);
+    self->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (self->fd < 0) {
+        SAMPLE_PRT("eventfd FAIL, errno=%d\n", errno);
+        return HI_FAILURE;
+    }
+    return HI_SUCCESS;
+}
+
+void AiEventDeinit(AiEvent* self)
+{
+    HI_ASSERT(self);
+    if (self->fd >= 0) {
+        close(self->fd);
+        self->fd = -1;
+    }
+}
+
+void AiEventSignal(AiEvent* self)
+{
+    uint64_t one = 1;
+    if (write(self->fd, &one, sizeof(one)) != sizeof(one) && errno != EAGAIN) {
+        SAMPLE_PRT("eventfd write FAIL, errno=%d\n", errno);
+    }
+}
+
+int AiEventWait(AiEvent* self, const AiEvent* stop, int timeoutMs)
+{
+    struct pollfd fds[2];
+    nfds_t nfds = 0;
+    uint64_t cnt;
+    int ret;
+
+    if (self != NULL) {
+        fds[nfds].fd = self->fd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+    if (stop != NULL) {
+        fds[nfds].fd = stop->fd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+
+    do {
+        ret = poll(fds, nfds, timeoutMs);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        SAMPLE_PRT("poll FAIL, errno=%d\n", errno);
+        return AI_EVENT_STOPPED;
+    } else if (ret == 0) {
+        return AI_EVENT_TIMEOUT;
+    }
+
+    if (stop != NULL && (fds[nfds - 1].revents & POLLIN)) {
+        return AI_EVENT_STOPPED;
+    }
+    if (read(self->fd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN) {
+        SAMPLE_PRT("eventfd read FAIL, errno=%d\n", errno);
+    }
+    return AI_EVENT_SIGNALED;
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AI_EVENT_H
+#define AI_EVENT_H
+
+#include "hi_type.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#define AI_EVENT_SIGNALED    1
+#define AI_EVENT_TIMEOUT     0
+#define AI_EVENT_STOPPED     (-1)
+
+/*
+ * 线程间事件通知，基于eventfd，可与其他fd一起select/poll
+ * Inter-thread event notification based on eventfd, can be select()ed/poll()ed together with other fds
+ */
+typedef struct AiEvent {
+    int fd;
+} AiEvent;
+
+/*
+ * 跨线程共享的标志位，读写都带内存屏障
+ * Flags shared between threads, reads and writes carry memory barriers
+ */
+#define AI_FLAG_GET(flag)       __atomic_load_n(&(flag), __ATOMIC_ACQUIRE)
+#define AI_FLAG_SET(flag, val)  __atomic_store_n(&(flag), (val), __ATOMIC_RELEASE)
+
+/*
+ * 创建事件
+ * Create the event
+ */
+int AiEventInit(AiEvent* self);
+
+/*
+ * 销毁事件
+ * Destroy the event
+ */
+void AiEventDeinit(AiEvent* self);
+
+/*
+ * 通知等待者，多次通知在被取走前合并为一次
+ * Wake the waiter, several signals merge into one until it is consumed
+ */
+void AiEventSignal(AiEvent* self);
+
+/*
+ * 等待self被通知或stop被置位，timeoutMs<0表示一直等待
+ * self为NULL时只等待stop，stop的通知不会被取走，可同时唤醒所有线程
+ *
+ * Wait until self is signaled or stop is set, timeoutMs < 0 waits forever.
+ * With self NULL only stop is waited on. The stop signal is never consumed, so it wakes every thread.
+ * Returns AI_EVENT_SIGNALED, AI_EVENT_TIMEOUT or AI_EVENT_STOPPED
+ */
+int AiEventWait(AiEvent* self, const AiEvent* stop, int timeoutMs);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
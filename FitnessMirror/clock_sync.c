@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件实现板子与中继之间的NTP式对时：应答对时请求，并用最小时延滤波和最小二乘
+ * 维护板子PTS时钟到中继墙钟的偏移与漂移；换算由中继用同一组时间戳自行完成，板子只打印估计。
+ *
+ * This file implements the NTP style clock sync between the board and the relay: it answers sync
+ * requests and keeps the offset and drift from the board PTS clock to the relay wall clock with a
+ * minimum delay filter and a least squares fit. The relay converts board PTS values itself from the same
+ * timestamps; the board only prints its estimate.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sample_media_ai.h"
+#include "clock_sync.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define PPB_PER_1               1e9
+#define DRIFT_MIN_PICKS         4
+#define DRIFT_MIN_SPAN_US       10000000ULL // Fit the drift only over at least 10s of samples
+#define SYNC_REQ_FIELDS         5
+
+void ClockSyncInit(ClockSync* self)
+{
+    HI_ASSERT(self);
+    if (memset_s(self, sizeof(*self), 0, sizeof(*self)) != EOK) {
+        HI_ASSERT(0);
+    }
+    pthread_mutex_init(&self->lock, NULL);
+}
+
+/*
+ * 对选中样本做最小二乘，斜率即漂移，调用时已持锁
+ * Least squares over the picked samples, the slope is the drift, called with the lock held
+ */
+static HI_S32 ClockSyncFitDrift(const ClockSync* self)
+{
+    const ClockSample *s = self->picked;
+    HI_U32 n = self->pickedCnt < CLOCK_SYNC_DRIFT_NUM ? self->pickedCnt : CLOCK_SYNC_DRIFT_NUM;
+    HI_U64 x0 = s[0].boardUs;
+    HI_U64 x1 = s[0].boardUs;
+    double mx = 0, my = 0, sxy = 0, sxx = 0;
+
+    if (n < DRIFT_MIN_PICKS) {
+        return 0;
+    }
+    for (HI_U32 i = 1; i < n; i++) {
+        x0 = s[i].boardUs < x0 ? s[i].boardUs : x0;
+        x1 = s[i].boardUs > x1 ? s[i].boardUs : x1;
+    }
+    if (x1 - x0 < DRIFT_MIN_SPAN_US) {
+        return 0;
+    }
+    for (HI_U32 i = 0; i < n; i++) {
+        mx += (double)(s[i].boardUs - x0);
+        my += (double)(s[i].offsetUs - s[0].offsetUs);
+    }
+    mx /= n;
+    my /= n;
+    for (HI_U32 i = 0; i < n; i++) {
+        double dx = (double)(s[i].boardUs - x0) - mx;
+        double dy = (double)(s[i].offsetUs - s[0].offsetUs) - my;
+        sxy += dx * dy;
+        sxx += dx * dx;
+    }
+    return sxx > 0 ? (HI_S32)(sxy / sxx * PPB_PER_1) : 0;
+}
+
+void ClockSyncAdd(ClockSync* self, HI_U64 t1, HI_U64 t2, HI_U64 t3, HI_U64 t4)
+{
+    ClockSample sample;
+    const ClockSample *best = NULL;
+    HI_U32 n;
+
+    if (t4 < t1 || t3 < t2 || t4 - t1 < t3 - t2) {
+        return;
+    }
+    sample.boardUs = t2 + (t3 - t2) / 2; // 2: midpoint
+    sample.offsetUs = ((HI_S64)(t1 - t2) + (HI_S64)(t4 - t3)) / 2; // 2: NTP offset
+    sample.delayUs = (t4 - t1) - (t3 - t2);
+
+    pthread_mutex_lock(&self->lock);
+    self->filt[self->filtCnt++ % CLOCK_SYNC_FILTER_NUM] = sample;
+    __atomic_fetch_add(&self->sampleCnt, 1, __ATOMIC_RELAXED);
+    n = self->filtCnt < CLOCK_SYNC_FILTER_NUM ? self->filtCnt : CLOCK_SYNC_FILTER_NUM;
+    for (HI_U32 i = 0; i < n; i++) {
+        if (best == NULL || self->filt[i].delayUs < best->delayUs) {
+            best = &self->filt[i];
+        }
+    }
+    if (best->boardUs != self->lastPickUs) {
+        self->lastPickUs = best->boardUs;
+        self->picked[self->pickedCnt++ % CLOCK_SYNC_DRIFT_NUM] = *best;
+        self->best = *best;
+        self->driftPpb = ClockSyncFitDrift(self);
+        self->synced = HI_TRUE;
+    }
+    pthread_mutex_unlock(&self->lock);
+}
+
+int ClockSyncHandle(ClockSync* self, const char* msg, HI_U64 rxUs, char* reply, int size)
+{
+    unsigned long long t1, p1, p2, p3, p4;
+    HI_U64 txUs = 0;
+    int len;
+
+    if (strncmp(msg, "SYNC ", strlen("SYNC ")) != 0 ||
+        sscanf(msg + strlen("SYNC "), "%llu %llu %llu %llu %llu", &t1, &p1, &p2, &p3, &p4) != SYNC_REQ_FIELDS) {
+        return -1;
+    }
+    if (p1 != 0) {
+        ClockSyncAdd(self, p1, p2, p3, p4);
+    }
+    HI_MPI_SYS_GetCurPTS(&txUs);
+    len = snprintf(reply, size, "SYNCR %llu %llu %llu", t1, (unsigned long long)rxUs, (unsigned long long)txUs);
+    return (len < 0 || len >= size) ? -1 : len;
+}
+
+HI_BOOL ClockSyncGet(ClockSync* self, ClockSample* best, HI_S32* driftPpb)
+{
+    HI_BOOL synced;
+
+    pthread_mutex_lock(&self->lock);
+    synced = self->synced;
+    *best = self->best;
+    *driftPpb = self->driftPpb;
+    pthread_mutex_unlock(&self->lock);
+    return synced;
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
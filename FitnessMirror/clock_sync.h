@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <pthread.h>
+#include "hi_type.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 板子与中继之间的NTP式对时，走应答端口(9999)，与 smart-fitness-web/clock_sync.py 保持一致
+ * 中继发起: "SYNC t1 p1 p2 p3 p4"，板子应答: "SYNCR t1 t2 t3"
+ * t1/t4为中继墙钟，t2/t3为板子PTS时钟，单位us；p1..p4为上一轮完整的四个时间戳(没有则为0)，
+ * 这样两端都拿到全部时间戳，用同一个滤波器各自维护偏移估计
+ *
+ * NTP style clock sync between the board and the relay over the ack port (9999),
+ * must match smart-fitness-web/clock_sync.py.
+ * The relay sends "SYNC t1 p1 p2 p3 p4" and the board answers "SYNCR t1 t2 t3".
+ * t1/t4 are on the relay wall clock and t2/t3 on the board PTS clock, in us. p1..p4 are the four
+ * timestamps of the previous complete exchange (0 if none), so both ends see every timestamp and
+ * keep their own offset estimate with the same filter.
+ *
+ * 滤波：最近CLOCK_SYNC_FILTER_NUM个样本中取往返时延最小者作为当前偏移(时延越小误差越小)，
+ * 再对最近CLOCK_SYNC_DRIFT_NUM个选中样本做最小二乘得到漂移
+ * Filter: the sample with the smallest round trip delay among the latest CLOCK_SYNC_FILTER_NUM gives
+ * the offset (the smaller the delay, the smaller the error), and a least squares fit over the latest
+ * CLOCK_SYNC_DRIFT_NUM picked samples gives the drift.
+ */
+#define CLOCK_SYNC_FILTER_NUM   8
+#define CLOCK_SYNC_DRIFT_NUM    32
+#define CLOCK_SYNC_MSG_MAX      128
+
+typedef struct ClockSample {
+    HI_U64 boardUs; // Board time the sample was taken at, midpoint of t2 and t3
+    HI_S64 offsetUs; // relay - board
+    HI_U64 delayUs; // Round trip delay without the board turnaround
+} ClockSample;
+
+typedef struct ClockSync {
+    pthread_mutex_t lock;
+    ClockSample filt[CLOCK_SYNC_FILTER_NUM];
+    HI_U32 filtCnt;
+    ClockSample picked[CLOCK_SYNC_DRIFT_NUM];
+    HI_U32 pickedCnt;
+    HI_U64 lastPickUs; // boardUs of the latest picked sample
+    HI_BOOL synced; // The fields below are valid
+    ClockSample best; // Current pick, the conversion reference
+    HI_S32 driftPpb; // Relay clock rate minus board clock rate, parts per billion
+    HI_U32 sampleCnt; // Read and cleared by the stats printer
+} ClockSync;
+
+void ClockSyncInit(ClockSync* self);
+
+/*
+ * 加入一轮完整的时间戳，t1/t4为中继时钟，t2/t3为板子时钟
+ * Add one complete exchange, t1/t4 on the relay clock and t2/t3 on the board clock
+ */
+void ClockSyncAdd(ClockSync* self, HI_U64 t1, HI_U64 t2, HI_U64 t3, HI_U64 t4);
+
+/*
+ * 处理应答端口收到的数据报，rxUs为收到时的板子时间；是对时请求时写入应答并返回其长度，否则返回-1
+ * Handle a datagram from the ack port, rxUs being the board time it arrived at. For a sync request
+ * the answer is written to reply and its length returned, otherwise -1
+ */
+int ClockSyncHandle(ClockSync* self, const char* msg, HI_U64 rxUs, char* reply, int size);
+
+/*
+ * 当前估计，供统计打印
+ * Current estimate for the stats printer
+ */
+HI_BOOL ClockSyncGet(ClockSync* self, ClockSample* best, HI_S32* driftPpb);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
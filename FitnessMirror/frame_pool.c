@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件实现私有VB池中的固定格式帧的取还，以及向池中帧的VGS缩放
+ *
+ * This file implements acquire/release of fixed format frames from a private VB pool,
+ * and VGS scaling into pooled frames.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sample_media_ai.h"
+#include "frame_pool.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define FRAME_POOL_ALIGN    16 // VGS needs 16 byte aligned strides and plane addresses
+#define YUV420_UV_DIV       2
+
+int FramePoolInit(FramePool* self, HI_U32 width, HI_U32 height, HI_U32 blkCnt)
+{
+    VB_POOL_CONFIG_S poolCfg;
+    HI_S32 ret;
+
+    HI_ASSERT(self && blkCnt > 0);
+    if (memset_s(self, sizeof(*self), 0, sizeof(*self)) != EOK ||
+        memset_s(&poolCfg, sizeof(poolCfg), 0, sizeof(poolCfg)) != EOK) {
+        HI_ASSERT(0);
+    }
+    self->width = width;
+    self->height = height;
+    self->stride = HI_ALIGN_UP(width, FRAME_POOL_ALIGN);
+    self->blkSize = self->stride * height * 3 / YUV420_UV_DIV; // 3/2: Y plane + interleaved VU plane
+    self->blkCnt = blkCnt;
+
+    poolCfg.u64BlkSize = self->blkSize;
+    poolCfg.u32BlkCnt = blkCnt;
+    poolCfg.enRemapMode = VB_REMAP_MODE_CACHED;
+    self->poolId = HI_MPI_VB_CreatePool(&poolCfg);
+    if (self->poolId == (VB_POOL)VB_INVALID_POOLID) {
+        SAMPLE_PRT("HI_MPI_VB_CreatePool %ux%u x %u FAIL\n", width, height, blkCnt);
+        return HI_FAILURE;
+    }
+    ret = HI_MPI_VB_MmapPool(self->poolId);
+    if (ret != HI_SUCCESS) {
+        SAMPLE_PRT("HI_MPI_VB_MmapPool(%d) FAIL, ret=%#x\n", self->poolId, ret);
+        HI_MPI_VB_DestroyPool(self->poolId);
+        self->poolId = VB_INVALID_POOLID;
+        return ret;
+    }
+    return HI_SUCCESS;
+}
+
+void FramePoolDeinit(FramePool* self)
+{
+    HI_ASSERT(self);
+    if (self->poolId == (VB_POOL)VB_INVALID_POOLID) {
+        return;
+    }
+    HI_MPI_VB_MunmapPool(self->poolId);
+    if (HI_MPI_VB_DestroyPool(self->poolId) != HI_SUCCESS) {
+        SAMPLE_PRT("HI_MPI_VB_DestroyPool(%d) FAIL, frames still in use?\n", self->poolId);
+    }
+    self->poolId = VB_INVALID_POOLID;
+}
+
+int FramePoolAcquire(FramePool* self, VIDEO_FRAME_INFO_S* frm)
+{
+    VIDEO_FRAME_S *vFrm = &frm->stVFrame;
+    HI_U32 lumaSize = self->stride * self->height;
+    HI_VOID *virAddr = NULL;
+    HI_U64 phyAddr;
+    VB_BLK blk;
+
+    blk = HI_MPI_VB_GetBlock(self->poolId, self->blkSize, NULL);
+    if (blk == VB_INVALID_HANDLE) {
+        self->emptyCnt++;
+        return HI_FAILURE;
+    }
+    phyAddr = HI_MPI_VB_Handle2PhysAddr(blk);
+    if (HI_MPI_VB_GetBlockVirAddr(self->poolId, phyAddr, &virAddr) != HI_SUCCESS) {
+        HI_MPI_VB_ReleaseBlock(blk);
+        return HI_FAILURE;
+    }
+
+    if (memset_s(frm, sizeof(*frm), 0, sizeof(*frm)) != EOK) {
+        HI_ASSERT(0);
+    }
+    frm->u32PoolId = (HI_U32)self->poolId;
+    frm->enModId = HI_ID_VB;
+    vFrm->u32Width = self->width;
+    vFrm->u32Height = self->height;
+    vFrm->enField = VIDEO_FIELD_FRAME;
+    vFrm->enPixelFormat = PIXEL_FORMAT_YVU_SEMIPLANAR_420;
+    vFrm->enVideoFormat = VIDEO_FORMAT_LINEAR;
+    vFrm->enCompressMode = COMPRESS_MODE_NONE;
+    vFrm->enDynamicRange = DYNAMIC_RANGE_SDR8;
+    vFrm->enColorGamut = COLOR_GAMUT_BT709;
+    vFrm->u32Stride[0] = self->stride;
+    vFrm->u32Stride[1] = self->stride;
+    vFrm->u64PhyAddr[0] = phyAddr;
+    vFrm->u64PhyAddr[1] = phyAddr + lumaSize;
+    vFrm->u64VirAddr[0] = (HI_U64)(uintptr_t)virAddr;
+    vFrm->u64VirAddr[1] = vFrm->u64VirAddr[0] + lumaSize;
+    return HI_SUCCESS;
+}
+
+void FramePoolRelease(FramePool* self, VIDEO_FRAME_INFO_S* frm)
+{
+    VB_BLK blk = HI_MPI_VB_PhysAddr2Handle(frm->stVFrame.u64PhyAddr[0]);
+
+    HI_ASSERT(frm->u32PoolId == (HI_U32)self->poolId);
+    if (blk == VB_INVALID_HANDLE || HI_MPI_VB_ReleaseBlock(blk) != HI_SUCCESS) {
+        SAMPLE_PRT("release pooled frame FAIL, phy=%#llx\n", (unsigned long long)frm->stVFrame.u64PhyAddr[0]);
+    }
+}
+
+/*
+ * 只改地址和尺寸，生成src中roi区域的视图，不拷贝数据
+ * Build a view of the roi area of src by adjusting addresses and size only, no data is copied
+ */
+static void FrmRoiView(const VIDEO_FRAME_INFO_S* src, const RECT_S* roi, VIDEO_FRAME_INFO_S* view)
+{
+    const VIDEO_FRAME_S *sFrm = &src->stVFrame;
+    VIDEO_FRAME_S *vFrm = &view->stVFrame;
+    HI_S32 x0 = HI_ALIGN_DOWN(roi->s32X < 0 ? 0 : roi->s32X, FRAME_POOL_ALIGN);
+    HI_S32 y0 = HI_ALIGN_DOWN(roi->s32Y < 0 ? 0 : roi->s32Y, YUV420_UV_DIV);
+    HI_S32 x1 = HI_ALIGN_UP(roi->s32X + (HI_S32)roi->u32Width, YUV420_UV_DIV);
+    HI_S32 y1 = HI_ALIGN_UP(roi->s32Y + (HI_S32)roi->u32Height, YUV420_UV_DIV);
+
+    x1 = x1 > (HI_S32)sFrm->u32Width ? (HI_S32)sFrm->u32Width : x1;
+    y1 = y1 > (HI_S32)sFrm->u32Height ? (HI_S32)sFrm->u32Height : y1;
+    *view = *src;
+    vFrm->u32Width = (HI_U32)(x1 - x0);
+    vFrm->u32Height = (HI_U32)(y1 - y0);
+    vFrm->u64PhyAddr[0] += (HI_U64)y0 * sFrm->u32Stride[0] + x0;
+    vFrm->u64VirAddr[0] += (HI_U64)y0 * sFrm->u32Stride[0] + x0;
+    vFrm->u64PhyAddr[1] += (HI_U64)(y0 / YUV420_UV_DIV) * sFrm->u32Stride[1] + x0;
+    vFrm->u64VirAddr[1] += (HI_U64)(y0 / YUV420_UV_DIV) * sFrm->u32Stride[1] + x0;
+}
+
+int FramePoolScale(FramePool* self, const VIDEO_FRAME_INFO_S* src, const RECT_S* roi, VIDEO_FRAME_INFO_S* dst)
+{
+    VGS_TASK_ATTR_S task;
+    VGS_HANDLE job = -1;
+    HI_S32 ret;
+
+    HI_ASSERT(src->stVFrame.enCompressMode == COMPRESS_MODE_NONE || roi == NULL);
+    ret = FramePoolAcquire(self, dst);
+    if (ret != HI_SUCCESS) {
+        return ret;
+    }
+
+    if (memset_s(&task, sizeof(task), 0, sizeof(task)) != EOK) {
+        HI_ASSERT(0);
+    }
+    if (roi != NULL) {
+        FrmRoiView(src, roi, &task.stImgIn);
+    } else {
+        task.stImgIn = *src;
+    }
+    task.stImgOut = *dst;
+    if (task.stImgIn.stVFrame.u32Width == 0 || task.stImgIn.stVFrame.u32Height == 0) {
+        ret = HI_FAILURE;
+        goto FAIL;
+    }
+
+    ret = HI_MPI_VGS_BeginJob(&job);
+    SAMPLE_CHECK_EXPR_GOTO(ret != HI_SUCCESS, FAIL, "HI_MPI_VGS_BeginJob FAIL, ret=%#x\n", ret);
+    ret = HI_MPI_VGS_AddScaleTask(job, &task, VGS_SCLCOEF_NORMAL);
+    SAMPLE_CHECK_EXPR_GOTO(ret != HI_SUCCESS, CANCEL, "HI_MPI_VGS_AddScaleTask FAIL, ret=%#x\n", ret);
+    ret = HI_MPI_VGS_EndJob(job);
+    SAMPLE_CHECK_EXPR_GOTO(ret != HI_SUCCESS, CANCEL, "HI_MPI_VGS_EndJob FAIL, ret=%#x\n", ret);
+    dst->stVFrame.u64PTS = src->stVFrame.u64PTS;
+    dst->stVFrame.u32TimeRef = src->stVFrame.u32TimeRef;
+    return HI_SUCCESS;
+
+CANCEL:
+    HI_MPI_VGS_CancelJob(job);
+FAIL:
+    FramePoolRelease(self, dst);
+    return ret;
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
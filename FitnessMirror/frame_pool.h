@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include "hi_type.h"
+#include "hi_comm_video.h"
+#include "hi_comm_vb.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 私有VB池，存放固定尺寸的YVU420SP中间帧
+ * 初始化时按流水线同时在用的帧数一次性分配并映射，运行中取还帧不再申请MMZ
+ *
+ * Private VB pool of fixed size YVU420SP intermediate frames.
+ * Blocks are allocated and mapped once at init, sized by the number of frames in flight,
+ * so acquiring and releasing frames at run time does no MMZ allocation.
+ */
+typedef struct FramePool {
+    VB_POOL poolId;
+    HI_U32 width;
+    HI_U32 height;
+    HI_U32 stride;
+    HI_U32 blkSize;
+    HI_U32 blkCnt;
+    HI_U32 emptyCnt; // Acquires that found the pool exhausted
+} FramePool;
+
+/*
+ * 创建池，blkCnt为同时在用的最大帧数
+ * Create the pool, blkCnt is the largest number of frames in use at the same time
+ */
+int FramePoolInit(FramePool* self, HI_U32 width, HI_U32 height, HI_U32 blkCnt);
+
+/*
+ * 销毁池，所有帧须已归还
+ * Destroy the pool, every frame must have been released
+ */
+void FramePoolDeinit(FramePool* self);
+
+/*
+ * 取一帧，池空时返回HI_FAILURE
+ * Acquire a frame, HI_FAILURE when the pool is exhausted
+ */
+int FramePoolAcquire(FramePool* self, VIDEO_FRAME_INFO_S* frm);
+
+/*
+ * 归还FramePoolAcquire取得的帧
+ * Release a frame got from FramePoolAcquire
+ */
+void FramePoolRelease(FramePool* self, VIDEO_FRAME_INFO_S* frm);
+
+/*
+ * 从池中取一帧，用VGS将src中roi区域缩放到该帧，roi为NULL时缩放整帧
+ * roi按VGS地址对齐要求向外取整，成功时dst须由FramePoolRelease归还
+ *
+ * Acquire a frame and VGS scale the roi area of src into it, the whole src when roi is NULL.
+ * roi is widened to the VGS address alignment. On success dst must be given back with FramePoolRelease
+ */
+int FramePoolScale(FramePool* self, const VIDEO_FRAME_INFO_S* src, const RECT_S* roi, VIDEO_FRAME_INFO_S* dst);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
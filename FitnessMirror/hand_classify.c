@@ -40,7 +40,11 @@
 #include "vgs_img.h"
 #include "ive_img.h"
 #include "misc_util.h"
-#include "gpio_user.h"
+#include "frame_pool.h"
+#include "hand_track.h"
+#include "servo_ctrl.h"
+#include "actuator.h"
+#include "pipe_stats.h"
 
 #ifdef __cplusplus
 #if __cplusplus
@@ -58,6 +62,23 @@ extern "C" {
 #define IMAGE_WIDTH        224  // The resolution of the model IMAGE sent to the classification is 224*224
 #define IMAGE_HEIGHT       224
 #define MODEL_FILE_GESTURE    "/userdata/hand_gesture.wk" // darknet framework wk model
+#define HAND_CLASSIFY_ENABLE  0 // 1: run the gesture classifier on the biggest hand, needs MODEL_FILE_GESTURE
+#define CLS_FRM_INFLIGHT      1 // Classifier input frames in use at once, the classifier runs synchronously
+#define TRACK_DT_DEF          (1.0f / 30) // Frame interval used when the PTS is missing or jumps, seconds
+#define TRACK_DT_MAX          0.2f
+#define US_PER_S              1000000
+#define ROI_DETECT_ENABLE     1 // 1: re-detect in a window around the target hand cut from the full resolution frame
+#define ROI_SCALE             4 // Window size relative to the target hand box
+#define ROI_WIN_MAX_DIV       3 // Search the whole frame when the window is wider than 2/3 of it, little to gain
+#define ROI_FULL_INTERVAL     8 // Every this many detections search the whole frame for new hands
+#define ROI_PTS_SKEW_MAX      40000 // Largest PTS gap between the inference and full resolution frames, us
+#define ROI_FRM_INFLIGHT      1
+#define CAM_HFOV_DEG          60.0 // Camera field of view across the inference frame, degrees
+#define CAM_VFOV_DEG          34.0
+#define SERVO_ID_PAN          0 // Servo indexes on the MCU
+#define SERVO_ID_TILT         1
+#define SERVO_CDEG_PER_DEG    100
+#define SERVO_ACT_LATENCY_US  30000 // UART, one 20 ms PWM period and servo travel after the angle is sent, us
 
 static int biggestBoxIndex1, biggestBoxIndex2;
 static IVE_IMAGE_S img;
@@ -67,10 +88,30 @@ static RectBox objBoxs[DETECT_OBJ_MAX] = {0};
 static RectBox remainingBoxs[DETECT_OBJ_MAX] = {0};
 // static RectBox cnnBoxs[DETECT_OBJ_MAX] = {0}; // Store the results of the classification network
 static RecogNumInfo numInfo[RET_NUM_MAX] = {0};
-static IVE_IMAGE_S imgIn;
 static IVE_IMAGE_S imgDst;
-static VIDEO_FRAME_INFO_S frmIn;
 static VIDEO_FRAME_INFO_S frmDst;
+static FramePool clsFrmPool; // IMAGE_WIDTH x IMAGE_HEIGHT classifier input frames
+static HandTracker handTracker;
+static HI_U64 trackLastPts;
+static FramePool roiFrmPool; // HAND_FRM_WIDTH x HAND_FRM_HEIGHT windows cut from the full resolution frame
+static VIDEO_FRAME_INFO_S roiFrm;
+static RectBox roiTarget; // Target hand of the previous frame, inference frame coordinates
+static HI_BOOL roiValid;
+static HI_U32 roiDetCnt;
+uint8_t angle1 = 90, angle2 = 140;
+static ServoAxis servoPan; // angle1, x
+static ServoAxis servoTilt; // angle2, y
+
+static const ServoAxisCfg servoPanCfg = {
+    .kp = SERVO_Q16(4.0), .ki = SERVO_Q16(1.0), .kff = SERVO_Q16(1.0), .velAlpha = SERVO_Q16(0.3),
+    .degPerPx = SERVO_Q16(CAM_HFOV_DEG / HAND_FRM_WIDTH), .dir = 1,
+    .angleMin = 10, .angleMax = 170, .rateMax = 180,
+};
+static const ServoAxisCfg servoTiltCfg = {
+    .kp = SERVO_Q16(4.0), .ki = SERVO_Q16(1.0), .kff = SERVO_Q16(1.0), .velAlpha = SERVO_Q16(0.3),
+    .degPerPx = SERVO_Q16(CAM_VFOV_DEG / HAND_FRM_HEIGHT), .dir = -1,
+    .angleMin = 80, .angleMax = 160, .rateMax = 180,
+};
 
 /*
  * 加载手部检测和手势分类模型
@@ -79,10 +120,25 @@ static VIDEO_FRAME_INFO_S frmDst;
 HI_S32 Yolo2HandDetectResnetClassifyLoad(uintptr_t* model)
 {
     SAMPLE_SVP_NNIE_CFG_S *self = NULL;
-    HI_S32 ret;
-    // ret = CnnCreate(&self, MODEL_FILE_GESTURE);
-    // *model = ret < 0 ? 0 : (uintptr_t)self;
+    HI_S32 ret = 0;
+#if HAND_CLASSIFY_ENABLE
+    ret = CnnCreate(&self, MODEL_FILE_GESTURE);
+    *model = ret < 0 ? 0 : (uintptr_t)self;
+    SAMPLE_CHECK_EXPR_RET(ret < 0, ret, "CnnCreate FAIL, ret=%#x\n", ret);
+    ret = FramePoolInit(&clsFrmPool, IMAGE_WIDTH, IMAGE_HEIGHT, CLS_FRM_INFLIGHT);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "classify frame pool init FAIL, ret=%#x\n", ret);
+#endif
+#if ROI_DETECT_ENABLE
+    ret = FramePoolInit(&roiFrmPool, HAND_FRM_WIDTH, HAND_FRM_HEIGHT, ROI_FRM_INFLIGHT);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "roi frame pool init FAIL, ret=%#x\n", ret);
+    roiValid = HI_FALSE;
+    roiDetCnt = 0;
+#endif
     HandDetectInit(); // Initialize the hand detection model
+    HandTrackerInit(&handTracker, NULL);
+    ServoAxisInit(&servoPan, &servoPanCfg, angle1);
+    ServoAxisInit(&servoTilt, &servoTiltCfg, angle2);
+    trackLastPts = 0;
     SAMPLE_PRT("Load hand detect claasify model success\n");
     return ret;
 }
@@ -93,7 +149,13 @@ HI_S32 Yolo2HandDetectResnetClassifyLoad(uintptr_t* model)
  */
 HI_S32 Yolo2HandDetectResnetClassifyUnload(uintptr_t model)
 {
-    // CnnDestroy((SAMPLE_SVP_NNIE_CFG_S*)model);
+#if HAND_CLASSIFY_ENABLE
+    CnnDestroy((SAMPLE_SVP_NNIE_CFG_S*)model);
+    FramePoolDeinit(&clsFrmPool);
+#endif
+#if ROI_DETECT_ENABLE
+    FramePoolDeinit(&roiFrmPool);
+#endif
     HandDetectExit(); // Uninitialize the hand detection model
     SAMPLE_PRT("Unload hand detect claasify model success\n");
     return 0;
@@ -165,11 +227,158 @@ static void GetBiggestHandIndex(RectBox boxs[], int detectNum)
     }
 }
 
+#if HAND_CLASSIFY_ENABLE
+/*
+ * 裁剪出来的手部区域由VGS直接缩放到池中的帧，送分类网进行推理
+ * The cropped hand area is VGS scaled straight into a pooled frame and sent to the classification network
+ */
+static HI_S32 HandClassifyCal(SAMPLE_SVP_NNIE_CFG_S *self, VIDEO_FRAME_INFO_S *srcFrm, const RectBox *box)
+{
+    RECT_S roi;
+    HI_S32 resLen = 0;
+    int ret;
+
+    roi.s32X = box->xmin;
+    roi.s32Y = box->ymin;
+    roi.u32Width = (HI_U32)(box->xmax - box->xmin + 1);
+    roi.u32Height = (HI_U32)(box->ymax - box->ymin + 1);
+    if ((roi.u32Width < WIDTH_LIMIT) || (roi.u32Height < HEIGHT_LIMIT)) {
+        return 0;
+    }
+
+    ret = FramePoolScale(&clsFrmPool, srcFrm, &roi, &frmDst);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "classify frame scale FAIL, ret=%#x\n", ret);
+    ret = FrmToOrigImg(&frmDst, &imgDst);
+    SAMPLE_CHECK_EXPR_GOTO(ret != HI_SUCCESS, RELEASE, "classify Frm to Img FAIL, ret=%#x\n", ret);
+    ret = CnnCalImg(self, &imgDst, numInfo, sizeof(numInfo) / sizeof((numInfo)[0]), &resLen);
+    SAMPLE_CHECK_EXPR_GOTO(ret < 0, RELEASE, "CnnCalImg FAIL, ret=%#x\n", ret);
+    HI_ASSERT(resLen <= sizeof(numInfo) / sizeof(numInfo[0]));
+    SAMPLE_PRT("hand gesture %u, score %u\n", numInfo[0].num, numInfo[0].score);
+
+RELEASE:
+    FramePoolRelease(&clsFrmPool, &frmDst);
+    return ret;
+}
+#endif
+
+#if ROI_DETECT_ENABLE
+/*
+ * 在全分辨率帧上以目标手为中心截取与检测输入同宽高比的窗口，缩放到检测尺寸后检测，
+ * 检测框换算回推理帧坐标。窗口过大时返回-1，由调用者改为整帧检测
+ *
+ * Cut a window with the detector aspect ratio around the target hand from the full resolution frame,
+ * scale it to the detector size, detect, and map the boxes back to inference frame coordinates.
+ * Returns -1 when the window would be too big, the caller then searches the whole frame
+ */
+static int HandDetectRoi(VIDEO_FRAME_INFO_S *fullFrm, const RectBox *target, RectBox dets[])
+{
+    HI_S32 fullW = (HI_S32)fullFrm->stVFrame.u32Width;
+    HI_S32 fullH = (HI_S32)fullFrm->stVFrame.u32Height;
+    HI_S32 boxW = (target->xmax - target->xmin + 1) * fullW / HAND_FRM_WIDTH;
+    HI_S32 boxH = (target->ymax - target->ymin + 1) * fullH / HAND_FRM_HEIGHT;
+    HI_S32 cx = (target->xmin + target->xmax) / 2 * fullW / HAND_FRM_WIDTH; // 2: center
+    HI_S32 cy = (target->ymin + target->ymax) / 2 * fullH / HAND_FRM_HEIGHT; // 2: center
+    HI_S32 winW, winH;
+    RECT_S roi;
+    int objNum;
+    int ret;
+    HI_U64 t0;
+
+    winW = boxW * ROI_SCALE;
+    winW = winW > boxH * ROI_SCALE * HAND_FRM_WIDTH / HAND_FRM_HEIGHT ?
+        winW : boxH * ROI_SCALE * HAND_FRM_WIDTH / HAND_FRM_HEIGHT;
+    winW = winW < HAND_FRM_WIDTH ? HAND_FRM_WIDTH : winW; // No more detail than the full resolution pixels
+    winW = HI_ALIGN_UP(winW, 16); // 16: VGS address alignment, keeps the window exactly as requested
+    winH = HI_ALIGN_UP(winW * HAND_FRM_HEIGHT / HAND_FRM_WIDTH, 2); // 2: YUV420 chroma alignment
+    if (winW * ROI_WIN_MAX_DIV > fullW * 2 || winH > fullH) { // 2: 2/3 of the frame
+        return -1;
+    }
+
+    roi.s32X = cx - winW / 2; // 2: center the window
+    roi.s32X = roi.s32X < 0 ? 0 : (roi.s32X > fullW - winW ? fullW - winW : roi.s32X);
+    roi.s32X = HI_ALIGN_DOWN(roi.s32X, 16); // 16: VGS address alignment
+    roi.s32Y = cy - winH / 2; // 2: center the window
+    roi.s32Y = roi.s32Y < 0 ? 0 : (roi.s32Y > fullH - winH ? fullH - winH : roi.s32Y);
+    roi.s32Y = HI_ALIGN_DOWN(roi.s32Y, 2); // 2: YUV420 chroma alignment
+    roi.u32Width = (HI_U32)winW;
+    roi.u32Height = (HI_U32)winH;
+
+    t0 = PipeStatsNowUs();
+    ret = FramePoolScale(&roiFrmPool, fullFrm, &roi, &roiFrm);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, -1, "roi frame scale FAIL, ret=%#x\n", ret);
+    PIPE_STATS_SINCE(PIPE_STAGE_RESIZE, t0);
+    t0 = PipeStatsNowUs();
+    ret = FrmToOrigImg(&roiFrm, &img);
+    if (ret != HI_SUCCESS) {
+        FramePoolRelease(&roiFrmPool, &roiFrm);
+        SAMPLE_PRT("roi Frm to Img FAIL, ret=%#x\n", ret);
+        return -1;
+    }
+    PIPE_STATS_SINCE(PIPE_STAGE_TO_IMG, t0);
+    t0 = PipeStatsNowUs();
+    objNum = HandDetectCal(&img, objs);
+    PIPE_STATS_SINCE(PIPE_STAGE_YOLO, t0);
+    FramePoolRelease(&roiFrmPool, &roiFrm);
+
+    for (int i = 0; i < objNum; i++) {
+        dets[i].xmin = (roi.s32X + objs[i].box.xmin * winW / HAND_FRM_WIDTH) * HAND_FRM_WIDTH / fullW;
+        dets[i].xmax = (roi.s32X + objs[i].box.xmax * winW / HAND_FRM_WIDTH) * HAND_FRM_WIDTH / fullW;
+        dets[i].ymin = (roi.s32Y + objs[i].box.ymin * winH / HAND_FRM_HEIGHT) * HAND_FRM_HEIGHT / fullH;
+        dets[i].ymax = (roi.s32Y + objs[i].box.ymax * winH / HAND_FRM_HEIGHT) * HAND_FRM_HEIGHT / fullH;
+    }
+    return objNum;
+}
+
+/*
+ * 有目标手、拿到了全分辨率帧且与推理帧时间相符，并且不是周期性整帧搜索时，才使用ROI检测
+ * ROI detection is used only with a target hand, a full resolution frame close in time to the
+ * inference frame, and when this is not one of the periodic whole frame searches
+ */
+static HI_BOOL HandDetectRoiUsable(const VIDEO_FRAME_INFO_S *srcFrm, const VIDEO_FRAME_INFO_S *fullFrm)
+{
+    HI_U64 srcPts = srcFrm->stVFrame.u64PTS;
+    HI_U64 fullPts = fullFrm->stVFrame.u64PTS;
+
+    if (!roiValid || fullFrm == srcFrm || fullFrm->stVFrame.u32Width <= srcFrm->stVFrame.u32Width) {
+        return HI_FALSE;
+    }
+    if ((srcPts > fullPts ? srcPts - fullPts : fullPts - srcPts) > ROI_PTS_SKEW_MAX) {
+        return HI_FALSE;
+    }
+    return (++roiDetCnt % ROI_FULL_INTERVAL) != 0 ? HI_TRUE : HI_FALSE;
+}
+#endif
+
+HI_BOOL Yolo2HandDetectRoiWanted(HI_VOID)
+{
+#if ROI_DETECT_ENABLE
+    return roiValid;
+#else
+    return HI_FALSE;
+#endif
+}
+
+/*
+ * 由帧PTS(us)得到与上一帧的间隔，PTS异常时使用默认帧间隔
+ * Get the interval since the previous frame from the frame PTS (us), the default interval when the PTS is bad
+ */
+static float TrackFrmDt(const VIDEO_FRAME_INFO_S *frm)
+{
+    HI_U64 pts = frm->stVFrame.u64PTS;
+    float dt = TRACK_DT_DEF;
+
+    if (trackLastPts != 0 && pts > trackLastPts) {
+        dt = (float)(pts - trackLastPts) / US_PER_S;
+        dt = dt > TRACK_DT_MAX ? TRACK_DT_DEF : dt;
+    }
+    trackLastPts = pts;
+    return dt;
+}
+
 /*
  * 手部检测和手势分类推理
  * Hand detect and classify calculation
  */
-uint8_t angle1 = 90, angle2 = 140;
 const short setpointX = 320;  // 目标X坐标
 const short setpointY = 192;  // 目标Y坐标
 HI_S32 Yolo2HandDetectResnetClassifyCal(uintptr_t model, VIDEO_FRAME_INFO_S *srcFrm, VIDEO_FRAME_INFO_S *dstFrm)
@@ -179,71 +388,97 @@ HI_S32 Yolo2HandDetectResnetClassifyCal(uintptr_t model, VIDEO_FRAME_INFO_S *src
     int objNum;
     int ret;
     int num = 0;
+    HI_U64 t0;
 
-    ret = FrmToOrigImg((VIDEO_FRAME_INFO_S*)srcFrm, &img);
-    if(ret != HI_SUCCESS)
-    {
-        printf("hand detect for YUV Frm to Img FAIL, ret=%#x\n", ret);
-        return ret;
-    }
+    /*
+     * 检测器只在需要时运行，其余帧用跟踪器预测的框驱动PID
+     * The detector only runs when needed, other frames drive the PID with the boxes predicted by the tracker
+     */
+    HandTrackerPredict(&handTracker, TrackFrmDt(srcFrm));
+    if (HandTrackerNeedDetect(&handTracker)) {
+        objNum = -1;
+#if ROI_DETECT_ENABLE
+        if (HandDetectRoiUsable(srcFrm, dstFrm)) {
+            objNum = HandDetectRoi(dstFrm, &roiTarget, boxs);
+        }
+#endif
+        if (objNum < 0) {
+            t0 = PipeStatsNowUs();
+            ret = FrmToOrigImg((VIDEO_FRAME_INFO_S*)srcFrm, &img);
+            if(ret != HI_SUCCESS)
+            {
+                printf("hand detect for YUV Frm to Img FAIL, ret=%#x\n", ret);
+                return ret;
+            }
+            PIPE_STATS_SINCE(PIPE_STAGE_TO_IMG, t0);
 
-    objNum = HandDetectCal(&img, objs); // Send IMG to the detection net for reasoning
-    for (int i = 0; i < objNum; i++) 
-    {
-        // cnnBoxs[i] = objs[i].box;
-        // RectBox *box = &objs[i].box;
-        // RectBoxTran(box, HAND_FRM_WIDTH, HAND_FRM_HEIGHT, dstFrm->stVFrame.u32Width, dstFrm->stVFrame.u32Height);
-        boxs[i] = objs[i].box;
-        // printf("yolo2:{%d, %d, %d, %d}\n", boxs->xmin, boxs->ymin, boxs->xmax, boxs->ymax);
-        // boxs[i] = *box;
+            t0 = PipeStatsNowUs();
+            objNum = HandDetectCal(&img, objs); // Send IMG to the detection net for reasoning
+            PIPE_STATS_SINCE(PIPE_STAGE_YOLO, t0);
+            for (int i = 0; i < objNum; i++) 
+            {
+                boxs[i] = objs[i].box;
+            }
+        }
+        HandTrackerUpdate(&handTracker, boxs, objNum);
     }
+    objNum = HandTrackerGetBoxes(&handTracker, boxs, DETECT_OBJ_MAX);
+    ret = HI_SUCCESS;
 
     GetBiggestHandIndex(boxs, objNum);
+    roiValid = objNum > 0 ? HI_TRUE : HI_FALSE; // Lost hands fall back to whole frame search
+    if (roiValid) {
+        roiTarget = boxs[biggestBoxIndex1];
+    }
 
     if(objNum > 0)
     {
         short xPoint, yPoint;
         if(objNum == 1)
         {
-            LED2_OFF();
-            LED1_ON();
+            ActuatorSetLeds(&actuator, ACT_LED1 | ACT_LED2, ACT_LED1);
             xPoint = (boxs[biggestBoxIndex1].xmin + boxs[biggestBoxIndex1].xmax) / 2;
             yPoint = (boxs[biggestBoxIndex1].ymin + boxs[biggestBoxIndex1].ymax) / 2;
         }
         else
         {
-            LED1_OFF();
-            LED2_ON();
+            ActuatorSetLeds(&actuator, ACT_LED1 | ACT_LED2, ACT_LED2);
             xPoint = (boxs[biggestBoxIndex1].xmin + boxs[biggestBoxIndex1].xmax + boxs[biggestBoxIndex2].xmin + boxs[biggestBoxIndex2].xmax) / 4;
             yPoint = (boxs[biggestBoxIndex1].ymin + boxs[biggestBoxIndex1].ymax + boxs[biggestBoxIndex2].ymin + boxs[biggestBoxIndex2].ymax) / 4;
         }
-        short deltaX = PID_Calculate(&servo1, setpointX, xPoint);
-        short deltaY = PID_Calculate(&servo2, setpointY, yPoint);
-        // printf("xPoint:%d, yPoint:%d, biggestIndex1:%d, biggestIndex2:%d, objNum:%d\n", 
-        //                                         xPoint, yPoint, biggestBoxIndex1, biggestBoxIndex2, objNum);
-        angle1 = (uint8_t)(angle1 + deltaX);
-        angle2 = (uint8_t)(angle2 - deltaY);
-
-        if(angle1 < 10) angle1 = 10;
-        if(angle1 > 170) angle1 = 170;
-        if(angle2 < 80) angle2 = 80;
-        if(angle2 > 160) angle2 = 160;
-
-        uint8_t uartSendBuf[4];
-        uartSendBuf[0] = 0xA5;
-        uartSendBuf[1] = angle1;
-        uartSendBuf[2] = angle2;
-        uartSendBuf[3] = (uint8_t)(uartSendBuf[0] + uartSendBuf[1] + uartSendBuf[2]);
-        ret = Uart1Send(uartSendBuf, sizeof(uartSendBuf));
-        if(ret != sizeof(uartSendBuf))
+        /*
+         * 预测到舵机到位的时刻：帧已等待的时间加上下发后的执行延迟
+         * Predict to when the servo gets there: the time the frame has waited plus the actuation delay
+         */
+        t0 = PipeStatsNowUs();
+        HI_U64 pts = srcFrm->stVFrame.u64PTS;
+        HI_U64 now = 0;
+        HI_U32 leadUs = SERVO_ACT_LATENCY_US;
+        if (HI_MPI_SYS_GetCurPTS(&now) == HI_SUCCESS && now > pts && now - pts < US_PER_S)
         {
-            printf("uart send fail:%d\n", ret);
+            leadUs += (HI_U32)(now - pts);
         }
+        angle1 = (uint8_t)ServoAxisUpdate(&servoPan, setpointX - xPoint, pts, leadUs);
+        angle2 = (uint8_t)ServoAxisUpdate(&servoTilt, setpointY - yPoint, pts, leadUs);
+
+        /*
+         * 交给执行线程发送，推理线程不等串口
+         * Hand over to the actuation thread, the inference thread does not wait on the UART
+         */
+        uint16_t sp[ACT_SERVO_NUM];
+        sp[SERVO_ID_PAN] = (uint16_t)SERVO_Q16_CDEG(servoPan.angle);
+        sp[SERVO_ID_TILT] = (uint16_t)SERVO_Q16_CDEG(servoTilt.angle);
+        ActuatorSetServo(&actuator, sp);
+        PIPE_STATS_SINCE(PIPE_STAGE_CTRL, t0);
+#if HAND_CLASSIFY_ENABLE
+        HandClassifyCal(self, srcFrm, &boxs[biggestBoxIndex1]);
+#endif
     }
     else
     {
-        LED1_OFF();
-        LED2_OFF();
+        ActuatorSetLeds(&actuator, ACT_LED1 | ACT_LED2, 0);
+        ServoAxisReset(&servoPan);
+        ServoAxisReset(&servoTilt);
     }
 
     /*
@@ -264,28 +499,6 @@ HI_S32 Yolo2HandDetectResnetClassifyCal(uintptr_t model, VIDEO_FRAME_INFO_S *src
     //             MppFrmDrawRects(dstFrm, remainingBoxs, objNum - 1, RGB888_RED, DRAW_RETC_THICK);
     //         }
     //     }
-
-        /*
-         * 裁剪出来的图像通过预处理送分类网进行推理
-         * The cropped image is preprocessed and sent to the classification network for inference
-         */
-        // ret = ImgYuvCrop(&img, &imgIn, &cnnBoxs[biggestBoxIndex]);
-        // SAMPLE_CHECK_EXPR_RET(ret < 0, ret, "ImgYuvCrop FAIL, ret=%#x\n", ret);
-
-        // if ((imgIn.u32Width >= WIDTH_LIMIT) && (imgIn.u32Height >= HEIGHT_LIMIT)) {
-        //     COMPRESS_MODE_E enCompressMode = srcFrm->stVFrame.enCompressMode;
-        //     ret = OrigImgToFrm(&imgIn, &frmIn);
-        //     frmIn.stVFrame.enCompressMode = enCompressMode;
-        //     SAMPLE_PRT("crop u32Width = %d, img.u32Height = %d\n", imgIn.u32Width, imgIn.u32Height);
-        //     ret = MppFrmResize(&frmIn, &frmDst, IMAGE_WIDTH, IMAGE_HEIGHT);
-        //     ret = FrmToOrigImg(&frmDst, &imgDst);
-        //     ret = CnnCalImg(self,  &imgDst, numInfo, sizeof(numInfo) / sizeof((numInfo)[0]), &resLen);
-        //     SAMPLE_CHECK_EXPR_RET(ret < 0, ret, "CnnCalImg FAIL, ret=%#x\n", ret);
-        //     HI_ASSERT(resLen <= sizeof(numInfo) / sizeof(numInfo[0]));
-        //     HandDetectFlag(numInfo[0]);
-        //     MppFrmDestroy(&frmDst);
-        // }
-        // IveImgDestroy(&imgIn);
     // }
 
     return ret;
@@ -293,15 +506,10 @@ HI_S32 Yolo2HandDetectResnetClassifyCal(uintptr_t model, VIDEO_FRAME_INFO_S *src
 
 void changeServoAngle(int8_t deltaAngle)
 {
-    uint8_t uartSendBuf[4];
-    uartSendBuf[0] = 0xA5;
-    uartSendBuf[1] = angle1;
-    uartSendBuf[2] = angle2 - deltaAngle;
-    uartSendBuf[3] = (uint8_t)(uartSendBuf[0] + uartSendBuf[1] + uartSendBuf[2]);
-    if(Uart1Send(uartSendBuf, sizeof(uartSendBuf)) != sizeof(uartSendBuf))
-    {
-        printf("changeServoAngle fail\n");
-    }
+    uint16_t sp[ACT_SERVO_NUM];
+    sp[SERVO_ID_PAN] = (uint16_t)(angle1 * SERVO_CDEG_PER_DEG);
+    sp[SERVO_ID_TILT] = (uint16_t)((angle2 - deltaAngle) * SERVO_CDEG_PER_DEG);
+    ActuatorSetServo(&actuator, sp);
 }
 
 #ifdef __cplusplus
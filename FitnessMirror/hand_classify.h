@@ -40,10 +40,20 @@ HI_S32 Yolo2HandDetectResnetClassifyUnload(uintptr_t model);
 
 /*
  * 手部检测和手势分类推理
- * Hand detect and classify calculation
+ * srcFrm为推理尺寸的整帧；dstFrm可为同一时刻的全分辨率帧，用于目标手附近的ROI检测，否则与srcFrm相同
+ *
+ * Hand detect and classify calculation.
+ * srcFrm is the whole frame at the inference size. dstFrm may be the full resolution frame of the same moment,
+ * used for ROI detection around the target hand, otherwise it is the same as srcFrm
  */
 HI_S32 Yolo2HandDetectResnetClassifyCal(uintptr_t model, VIDEO_FRAME_INFO_S *srcFrm, VIDEO_FRAME_INFO_S *dstFrm);
 
+/*
+ * 是否有目标手可做ROI检测，即下一次推理是否需要全分辨率帧
+ * Whether a target hand is available for ROI detection, that is whether the next inference wants a full resolution frame
+ */
+HI_BOOL Yolo2HandDetectRoiWanted(HI_VOID);
+
 void changeServoAngle(int8_t deltaAngle);
 
 #ifdef __cplusplus
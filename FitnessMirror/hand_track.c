@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件实现手部框的轻量多目标跟踪，检测器只需每隔几帧运行一次，
+ * 中间帧由卡尔曼预测提供框给PID
+ *
+ * This file implements lightweight multi object tracking of hand boxes, so the detector only runs
+ * every few frames and Kalman prediction feeds boxes to the PID in between.
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "sample_media_ai.h"
+#include "hand_track.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define KF_CX       0
+#define KF_CY       1
+#define KF_W        2
+#define KF_H        3
+#define KF_NUM      4
+#define VEL_VAR0    (400.0f * 400.0f) // Initial velocity variance, (pixels/s)^2
+#define SIZE_MIN    2.0f
+#define HAND_DET_CAP    32 // Same as DETECT_OBJ_MAX of the detector
+
+static const HandTrackCfg g_trackCfgDef = {
+    .detectInterval = 3,
+    .minHits = 1,
+    .maxMiss = 2,
+    .iouMin = 0.2f,
+    .stdMax = 24.0f,
+    .accelNoise = 800.0f,
+    .measNoise = 8.0f,
+};
+
+static void KfInit(HandKf* kf, float z, float measVar)
+{
+    kf->x[0] = z;
+    kf->x[1] = 0;
+    kf->p[0][0] = measVar;
+    kf->p[0][1] = 0;
+    kf->p[1][0] = 0;
+    kf->p[1][1] = VEL_VAR0;
+}
+
+/*
+ * x = F x, P = F P F' + Q, Q为离散白噪声加速度模型
+ * x = F x, P = F P F' + Q, Q is the discrete white noise acceleration model
+ */
+static void KfPredict(HandKf* kf, float dt, float accelVar)
+{
+    float dt2 = dt * dt;
+    float p00 = kf->p[0][0], p01 = kf->p[0][1], p10 = kf->p[1][0], p11 = kf->p[1][1];
+
+    kf->x[0] += kf->x[1] * dt;
+    kf->p[0][0] = p00 + dt * (p10 + p01) + dt2 * p11 + accelVar * dt2 * dt2 / 4; // 4: dt^4/4
+    kf->p[0][1] = p01 + dt * p11 + accelVar * dt2 * dt / 2; // 2: dt^3/2
+    kf->p[1][0] = p10 + dt * p11 + accelVar * dt2 * dt / 2; // 2: dt^3/2
+    kf->p[1][1] = p11 + accelVar * dt2;
+}
+
+static void KfUpdate(HandKf* kf, float z, float measVar)
+{
+    float p00 = kf->p[0][0], p01 = kf->p[0][1];
+    float s = p00 + measVar;
+    float k0 = p00 / s;
+    float k1 = kf->p[1][0] / s;
+    float y = z - kf->x[0];
+
+    kf->x[0] += k0 * y;
+    kf->x[1] += k1 * y;
+    kf->p[0][0] = (1 - k0) * p00;
+    kf->p[0][1] = (1 - k0) * p01;
+    kf->p[1][0] -= k1 * p00;
+    kf->p[1][1] -= k1 * p01;
+}
+
+static void BoxToMeas(const RectBox* box, float z[KF_NUM])
+{
+    z[KF_CX] = (box->xmin + box->xmax) / 2.0f; // 2: center
+    z[KF_CY] = (box->ymin + box->ymax) / 2.0f; // 2: center
+    z[KF_W] = (float)(box->xmax - box->xmin + 1);
+    z[KF_H] = (float)(box->ymax - box->ymin + 1);
+}
+
+static void TrackToBox(const HandTrack* trk, RectBox* box)
+{
+    float cx = trk->kf[KF_CX].x[0];
+    float cy = trk->kf[KF_CY].x[0];
+    float w = fmaxf(trk->kf[KF_W].x[0], SIZE_MIN);
+    float h = fmaxf(trk->kf[KF_H].x[0], SIZE_MIN);
+
+    box->xmin = (int)lroundf(cx - w / 2); // 2: half size
+    box->ymin = (int)lroundf(cy - h / 2); // 2: half size
+    box->xmax = box->xmin + (int)lroundf(w) - 1;
+    box->ymax = box->ymin + (int)lroundf(h) - 1;
+}
+
+static float BoxIou(const RectBox* a, const RectBox* b)
+{
+    int iw = (a->xmax < b->xmax ? a->xmax : b->xmax) - (a->xmin > b->xmin ? a->xmin : b->xmin) + 1;
+    int ih = (a->ymax < b->ymax ? a->ymax : b->ymax) - (a->ymin > b->ymin ? a->ymin : b->ymin) + 1;
+    float inter, areaA, areaB;
+
+    if (iw <= 0 || ih <= 0) {
+        return 0;
+    }
+    inter = (float)iw * ih;
+    areaA = (float)(a->xmax - a->xmin + 1) * (a->ymax - a->ymin + 1);
+    areaB = (float)(b->xmax - b->xmin + 1) * (b->ymax - b->ymin + 1);
+    return inter / (areaA + areaB - inter);
+}
+
+static void TrackStart(HandTracker* self, const RectBox* det)
+{
+    HandTrack *trk = NULL;
+    float z[KF_NUM];
+    float measVar = self->cfg.measNoise * self->cfg.measNoise;
+
+    if (self->trackNum >= HAND_TRACK_MAX) {
+        return;
+    }
+    trk = &self->tracks[self->trackNum++];
+    BoxToMeas(det, z);
+    for (int i = 0; i < KF_NUM; i++) {
+        KfInit(&trk->kf[i], z[i], measVar);
+    }
+    trk->id = self->nextId++;
+    trk->hits = 1;
+    trk->missCnt = 0;
+}
+
+void HandTrackerInit(HandTracker* self, const HandTrackCfg* cfg)
+{
+    HI_ASSERT(self);
+    if (memset_s(self, sizeof(*self), 0, sizeof(*self)) != EOK) {
+        HI_ASSERT(0);
+    }
+    self->cfg = cfg ? *cfg : g_trackCfgDef;
+    if (self->cfg.detectInterval == 0) {
+        self->cfg.detectInterval = 1;
+    }
+}
+
+void HandTrackerPredict(HandTracker* self, float dt)
+{
+    float accelVar = self->cfg.accelNoise * self->cfg.accelNoise;
+
+    for (int i = 0; i < self->trackNum; i++) {
+        for (int k = 0; k < KF_NUM; k++) {
+            KfPredict(&self->tracks[i].kf[k], dt, accelVar);
+        }
+    }
+    self->frmSinceDetect++;
+}
+
+/*
+ * 对外报告的轨迹：已确认且在最近一轮检测中关联上；检测间隔的判断与输出框都用这一条件，
+ * 只剩未关联轨迹时每帧都检测，跳过检测的帧不会没有框
+ * A reported track is confirmed and matched in the latest detection round. The detect decision and the
+ * box output share this rule, so with only unmatched tracks left every frame detects and no skipped
+ * frame goes without a box
+ */
+static HI_BOOL TrackReported(const HandTracker* self, const HandTrack* trk)
+{
+    return trk->hits >= self->cfg.minHits && trk->missCnt == 0 ? HI_TRUE : HI_FALSE;
+}
+
+HI_BOOL HandTrackerNeedDetect(const HandTracker* self)
+{
+    float varMax = self->cfg.stdMax * self->cfg.stdMax;
+    int reported = 0;
+
+    if (self->frmSinceDetect >= self->cfg.detectInterval) {
+        return HI_TRUE;
+    }
+    for (int i = 0; i < self->trackNum; i++) {
+        const HandTrack *trk = &self->tracks[i];
+        if (!TrackReported(self, trk)) {
+            continue;
+        }
+        reported++;
+        if (trk->kf[KF_CX].p[0][0] > varMax || trk->kf[KF_CY].p[0][0] > varMax) {
+            return HI_TRUE;
+        }
+    }
+    return reported == 0 ? HI_TRUE : HI_FALSE;
+}
+
+void HandTrackerUpdate(HandTracker* self, const RectBox dets[], int detNum)
+{
+    HI_BOOL trkUsed[HAND_TRACK_MAX] = { HI_FALSE };
+    HI_BOOL detUsed[HAND_DET_CAP] = { HI_FALSE };
+    RectBox pred[HAND_TRACK_MAX];
+    float measVar = self->cfg.measNoise * self->cfg.measNoise;
+    float z[KF_NUM];
+    int trkNum = self->trackNum;
+
+    detNum = detNum > HAND_DET_CAP ? HAND_DET_CAP : detNum;
+    for (int i = 0; i < trkNum; i++) {
+        TrackToBox(&self->tracks[i], &pred[i]);
+    }
+
+    /*
+     * 贪心关联：每次取IoU最大的一对，目标数很少时与匈牙利算法结果基本一致
+     * Greedy association: take the pair with the largest IoU each time,
+     * with this few objects it matches the Hungarian result in practice
+     */
+    for (;;) {
+        float best = self->cfg.iouMin;
+        int bestTrk = -1, bestDet = -1;
+        for (int i = 0; i < trkNum; i++) {
+            for (int j = 0; j < detNum && !trkUsed[i]; j++) {
+                float iou = detUsed[j] ? 0 : BoxIou(&pred[i], &dets[j]);
+                if (iou >= best) {
+                    best = iou;
+                    bestTrk = i;
+                    bestDet = j;
+                }
+            }
+        }
+        if (bestTrk < 0) {
+            break;
+        }
+        trkUsed[bestTrk] = HI_TRUE;
+        detUsed[bestDet] = HI_TRUE;
+        BoxToMeas(&dets[bestDet], z);
+        for (int k = 0; k < KF_NUM; k++) {
+            KfUpdate(&self->tracks[bestTrk].kf[k], z[k], measVar);
+        }
+        self->tracks[bestTrk].hits++;
+        self->tracks[bestTrk].missCnt = 0;
+    }
+
+    for (int i = 0; i < trkNum; i++) {
+        if (!trkUsed[i]) {
+            self->tracks[i].missCnt++;
+        }
+    }
+    for (int i = 0; i < self->trackNum;) {
+        if (self->tracks[i].missCnt > self->cfg.maxMiss) {
+            self->tracks[i] = self->tracks[--self->trackNum];
+        } else {
+            i++;
+        }
+    }
+    for (int j = 0; j < detNum; j++) {
+        if (!detUsed[j]) {
+            TrackStart(self, &dets[j]);
+        }
+    }
+    self->frmSinceDetect = 0;
+}
+
+int HandTrackerGetBoxes(const HandTracker* self, RectBox boxes[], int boxCap)
+{
+    int num = 0;
+
+    for (int i = 0; i < self->trackNum && num < boxCap; i++) {
+        if (TrackReported(self, &self->tracks[i])) {
+            TrackToBox(&self->tracks[i], &boxes[num++]);
+        }
+    }
+    return num;
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
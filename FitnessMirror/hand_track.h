@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HAND_TRACK_H
+#define HAND_TRACK_H
+
+#include "hi_type.h"
+#include "ai_infer_process.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#define HAND_TRACK_MAX      8
+
+/*
+ * 一维匀速卡尔曼滤波，状态为[位置, 速度]
+ * One-dimensional constant velocity Kalman filter, state is [position, velocity]
+ */
+typedef struct HandKf {
+    float x[2];
+    float p[2][2];
+} HandKf;
+
+/*
+ * 单个手部轨迹，框的中心和宽高各用一个HandKf
+ * One hand track, the box center and size each use a HandKf
+ */
+typedef struct HandTrack {
+    HI_U32 id;
+    HandKf kf[4]; // 4: cx, cy, w, h
+    HI_U32 hits; // Detections matched so far
+    HI_U32 missCnt; // Detection rounds in a row without a match
+} HandTrack;
+
+typedef struct HandTrackCfg {
+    HI_U32 detectInterval; // Run the detector at least every this many frames
+    HI_U32 minHits; // Matches before a track is reported
+    HI_U32 maxMiss; // Detection rounds without a match before a track is removed
+    float iouMin; // Smallest IoU accepted for an association
+    float stdMax; // Detect again when a reported track's center std exceeds this, in pixels
+    float accelNoise; // Process noise, pixels/s^2
+    float measNoise; // Detector box noise, pixels
+} HandTrackCfg;
+
+/*
+ * SORT风格的多目标跟踪：检测帧用IoU贪心关联并校正卡尔曼滤波，其余帧只做预测
+ * SORT style multi object tracker: detection frames associate by greedy IoU and correct the
+ * Kalman filters, other frames only predict
+ */
+typedef struct HandTracker {
+    HandTrackCfg cfg;
+    HandTrack tracks[HAND_TRACK_MAX];
+    int trackNum;
+    HI_U32 nextId;
+    HI_U32 frmSinceDetect;
+} HandTracker;
+
+/*
+ * 初始化跟踪器，cfg为NULL时使用默认参数
+ * Init the tracker, default parameters when cfg is NULL
+ */
+void HandTrackerInit(HandTracker* self, const HandTrackCfg* cfg);
+
+/*
+ * 将所有轨迹预测到dt秒之后
+ * Predict every track dt seconds ahead
+ */
+void HandTrackerPredict(HandTracker* self, float dt);
+
+/*
+ * 本帧是否需要运行检测器：到了检测间隔、没有可用轨迹或轨迹不确定度过大
+ * Whether this frame needs the detector: the interval is up, no track is reported, or a track got too uncertain
+ */
+HI_BOOL HandTrackerNeedDetect(const HandTracker* self);
+
+/*
+ * 用本帧的检测结果校正轨迹，新建未关联的检测，删除长期丢失的轨迹
+ * Correct the tracks with this frame's detections, start tracks for unmatched ones, drop tracks lost for too long
+ */
+void HandTrackerUpdate(HandTracker* self, const RectBox dets[], int detNum);
+
+/*
+ * 输出已确认且最近一轮检测关联上的轨迹的当前框，返回个数
+ * Output the current boxes of the confirmed tracks matched in the latest detection round, returns how many
+ */
+int HandTrackerGetBoxes(const HandTracker* self, RectBox boxes[], int boxCap);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
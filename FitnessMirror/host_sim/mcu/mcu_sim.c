@@ -0,0 +1,144 @@
+/*
+ * 舵机MCU SDK的主机端替身实现，见mcu/mcu_sim.h
+ * Host stand-in of the servo MCU SDK, see mcu/mcu_sim.h
+ */
+#include "mcu_sim.h"
+
+typedef struct {
+    bool armed;
+    uint64_t deadline;
+    timer_callback_t cb;
+    uintptr_t data;
+} SimTimer;
+
+static SimTimer g_timers[TIMER_INDEX_MAX];
+static uint8_t g_gpioLevel[MCU_SIM_PIN_NUM];
+static McuSimGpioHook g_gpioHook;
+static uint64_t g_nowUs;
+static uint32_t g_isrLatencyUs;
+
+void McuSimReset(void)
+{
+    memset(g_timers, 0, sizeof(g_timers));
+    memset(g_gpioLevel, 0, sizeof(g_gpioLevel));
+    g_gpioHook = NULL;
+    g_nowUs = 0;
+    g_isrLatencyUs = 0;
+}
+
+void McuSimSetGpioHook(McuSimGpioHook hook)
+{
+    g_gpioHook = hook;
+}
+
+void McuSimSetIsrLatency(uint32_t us)
+{
+    g_isrLatencyUs = us;
+}
+
+uint64_t McuSimNowUs(void)
+{
+    return g_nowUs;
+}
+
+void McuSimRunUntil(uint64_t us)
+{
+    for (;;) {
+        SimTimer *next = NULL;
+        for (int i = 0; i < TIMER_INDEX_MAX; i++) {
+            if (g_timers[i].armed && (next == NULL || g_timers[i].deadline < next->deadline)) {
+                next = &g_timers[i];
+            }
+        }
+        if (next == NULL || next->deadline + g_isrLatencyUs > us) {
+            break;
+        }
+        g_nowUs = next->deadline + g_isrLatencyUs;
+        next->armed = false; // One shot, the callback restarts it
+        next->cb(next->data);
+    }
+    g_nowUs = us;
+}
+
+errcode_t uapi_pin_set_mode(pin_t pin, pin_mode_t mode)
+{
+    unused(mode);
+    return pin < MCU_SIM_PIN_NUM ? ERRCODE_SUCC : ERRCODE_FAIL;
+}
+
+errcode_t uapi_gpio_set_dir(pin_t pin, gpio_direction_t dir)
+{
+    unused(dir);
+    return pin < MCU_SIM_PIN_NUM ? ERRCODE_SUCC : ERRCODE_FAIL;
+}
+
+errcode_t uapi_gpio_set_val(pin_t pin, gpio_level_t level)
+{
+    if (pin >= MCU_SIM_PIN_NUM) {
+        return ERRCODE_FAIL;
+    }
+    if (g_gpioLevel[pin] != level && g_gpioHook != NULL) {
+        g_gpioHook(pin, level, g_nowUs);
+    }
+    g_gpioLevel[pin] = (uint8_t)level;
+    return ERRCODE_SUCC;
+}
+
+errcode_t uapi_gpio_toggle(pin_t pin)
+{
+    return pin < MCU_SIM_PIN_NUM ?
+        uapi_gpio_set_val(pin, g_gpioLevel[pin] ? GPIO_LEVEL_LOW : GPIO_LEVEL_HIGH) : ERRCODE_FAIL;
+}
+
+errcode_t uapi_timer_init(void)
+{
+    return ERRCODE_SUCC;
+}
+
+errcode_t uapi_timer_adapter(timer_index_t index, uint32_t int_id, uint16_t int_priority)
+{
+    unused(int_id);
+    unused(int_priority);
+    return index < TIMER_INDEX_MAX ? ERRCODE_SUCC : ERRCODE_FAIL;
+}
+
+errcode_t uapi_timer_create(timer_index_t index, timer_handle_t *timer)
+{
+    if (index >= TIMER_INDEX_MAX) {
+        return ERRCODE_FAIL;
+    }
+    *timer = &g_timers[index];
+    return ERRCODE_SUCC;
+}
+
+errcode_t uapi_timer_start(timer_handle_t timer, uint32_t time_us, timer_callback_t callback, uintptr_t data)
+{
+    SimTimer *t = (SimTimer *)timer;
+
+    t->deadline = g_nowUs + time_us;
+    t->cb = callback;
+    t->data = data;
+    t->armed = true;
+    return ERRCODE_SUCC;
+}
+
+errcode_t uapi_timer_stop(timer_handle_t timer)
+{
+    ((SimTimer *)timer)->armed = false;
+    return ERRCODE_SUCC;
+}
+
+uint64_t uapi_tcxo_get_us(void)
+{
+    return g_nowUs;
+}
+
+void osal_msleep(uint32_t ms)
+{
+    McuSimRunUntil(g_nowUs + (uint64_t)ms * 1000); // 1000: ms to us
+}
+
+void osal_udelay(uint32_t us)
+{
+    g_nowUs += us; // Busy wait, timers do not run meanwhile
+}
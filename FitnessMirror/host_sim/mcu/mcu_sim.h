@@ -0,0 +1,73 @@
+/*
+ * 舵机MCU SDK(uapi_gpio/uapi_timer/osal)的主机端替身，只实现固件用到的接口。
+ * 时间是虚拟的：McuSimRunUntil按到期顺序调用定时器回调，GPIO翻转带着当前虚拟时间交给记录回调，
+ * 这样PWM时序可以在主机上逐微秒检查。
+ *
+ * Host stand-in for the servo MCU SDK (uapi_gpio/uapi_timer/osal), only the entry points the firmware uses.
+ * Time is virtual: McuSimRunUntil calls timer callbacks in deadline order and GPIO writes are handed to
+ * the recording hook with the current virtual time, so PWM timing can be checked to the microsecond on the host.
+ */
+#ifndef MCU_SIM_H
+#define MCU_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define unused(var)             ((void)(var))
+#define ERRCODE_SUCC            0
+#define ERRCODE_FAIL            ((errcode_t)-1)
+typedef uint32_t errcode_t;
+
+/* pinctrl.h */
+typedef uint32_t pin_t;
+typedef enum { PIN_MODE_0 = 0, PIN_MODE_1, PIN_MODE_2 } pin_mode_t;
+#define PIN_NONE                0xFFFFFFFF
+#define GPIO_02                 2
+#define GPIO_10                 10
+#define GPIO_12                 12
+#define GPIO_15                 15
+#define GPIO_16                 16
+#define MCU_SIM_PIN_NUM         32
+errcode_t uapi_pin_set_mode(pin_t pin, pin_mode_t mode);
+
+/* gpio.h */
+typedef enum { GPIO_LEVEL_LOW = 0, GPIO_LEVEL_HIGH } gpio_level_t;
+typedef enum { GPIO_DIRECTION_INPUT = 0, GPIO_DIRECTION_OUTPUT } gpio_direction_t;
+errcode_t uapi_gpio_set_dir(pin_t pin, gpio_direction_t dir);
+errcode_t uapi_gpio_set_val(pin_t pin, gpio_level_t level);
+errcode_t uapi_gpio_toggle(pin_t pin);
+
+/* timer.h */
+typedef enum { TIMER_INDEX_0 = 0, TIMER_INDEX_1, TIMER_INDEX_2, TIMER_INDEX_MAX } timer_index_t;
+#define TIMER_1_IRQN            27
+typedef void *timer_handle_t;
+typedef void (*timer_callback_t)(uintptr_t data);
+errcode_t uapi_timer_init(void);
+errcode_t uapi_timer_adapter(timer_index_t index, uint32_t int_id, uint16_t int_priority);
+errcode_t uapi_timer_create(timer_index_t index, timer_handle_t *timer);
+errcode_t uapi_timer_start(timer_handle_t timer, uint32_t time_us, timer_callback_t callback, uintptr_t data);
+errcode_t uapi_timer_stop(timer_handle_t timer);
+
+/* tcxo.h */
+uint64_t uapi_tcxo_get_us(void);
+
+/* soc_osal.h */
+#define osal_printk             printf
+void osal_msleep(uint32_t ms);
+void osal_udelay(uint32_t us);
+
+/*
+ * 仿真控制
+ * Simulation control
+ */
+typedef void (*McuSimGpioHook)(pin_t pin, gpio_level_t level, uint64_t nowUs);
+
+void McuSimReset(void);
+void McuSimSetGpioHook(McuSimGpioHook hook);
+void McuSimSetIsrLatency(uint32_t us); // Every timer callback runs this much after its deadline
+uint64_t McuSimNowUs(void);
+void McuSimRunUntil(uint64_t us);
+
+#endif
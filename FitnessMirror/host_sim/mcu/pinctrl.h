@@ -0,0 +1 @@
+#include "mcu_sim.h"
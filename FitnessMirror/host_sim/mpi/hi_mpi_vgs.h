@@ -0,0 +1 @@
+#include "mpi_sim.h"
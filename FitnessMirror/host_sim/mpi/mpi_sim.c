@@ -0,0 +1,1615 @@
+/*
+ * 海思MPI媒体部分(SYS/VB/VPSS/VGS/IVE/VENC/NNIE)的主机端替身实现，见mpi/mpi_sim.h
+ * 相机线程按SIM_FPS出帧，VPSS通道最近邻缩放到各自尺寸；每块缓冲带着"来自相机哪一帧的哪个窗口"的标记，
+ * VGS缩放时传递标记，Yolo2CalImg据此把预置检测框换算到输入图像的坐标。
+ *
+ * Host stand-in of the HiSilicon MPI media part (SYS/VB/VPSS/VGS/IVE/VENC/NNIE), see mpi/mpi_sim.h.
+ * A camera thread produces frames at SIM_FPS and every VPSS channel scales them (nearest neighbour) to its size.
+ * Every buffer carries a tag saying which window of which camera frame it shows, VGS scaling passes the tag on,
+ * and Yolo2CalImg uses it to map the canned boxes into the coordinates of its input image.
+ */
+#include <stdlib.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "mpi_sim.h"
+
+#define US_PER_S            1000000ULL
+#define NS_PER_US           1000ULL
+#define SIM_ALIGN           16
+#define SIM_POOL_MAX        16
+#define SIM_BLK_MAX         32
+#define SIM_BLK_SHIFT       8 // VB_BLK = pool << SIM_BLK_SHIFT | block index
+#define SIM_CHN_BLK_EXTRA   6 // Blocks of a VPSS channel beyond its depth: being written plus held by the app
+#define SIM_CHN_QUEUE_MAX   8
+#define SIM_VGS_JOB_MAX     8
+#define SIM_VGS_TASK_MAX    4
+#define SIM_VENC_SLOT_NUM   4
+#define SIM_JPEG_REF_Q      90 // QFactor that SIM_JPEG_KB refers to
+#define SIM_VENC_SLOT_MIN   (256 * 1024) // Room for an H.264/H.265 I frame at a high bitrate
+#define SIM_I_P_RATIO       8 // An I frame codes to about this many P frames
+#define SIM_PERMILLE        1000
+#define SIM_DET_MAX         65536
+#define SIM_ERR_EMPTY       0xA007800EU // HI_ERR_VPSS_BUF_EMPTY
+#define SIM_ERR_TIMEOUT     0xA0088027U // Generic "no data before the timeout"
+#define SIM_ERR_PARAM       0xA0078003U // Generic illegal parameter
+
+/*
+ * 缓冲标记：画面是相机第clipFrm帧中(x, y, w, h)窗口的内容，缩放成了width x height
+ * Buffer tag: the picture is the (x, y, w, h) window of camera frame clipFrm, scaled to width x height
+ */
+typedef struct {
+    HI_U32 clipFrm;
+    double x, y, w, h; // In clip pixels
+    HI_U32 width, height, stride;
+} SimFrmTag;
+
+typedef struct {
+    HI_U8 *data;
+    HI_BOOL busy;
+    SimFrmTag tag;
+} SimBlk;
+
+typedef struct {
+    HI_BOOL used;
+    HI_U64 blkSize;
+    HI_U32 blkCnt;
+    SimBlk blks[SIM_BLK_MAX];
+} SimPool;
+
+typedef struct {
+    HI_BOOL enabled;
+    VPSS_CHN_ATTR_S attr;
+    VB_POOL pool;
+    VIDEO_FRAME_INFO_S queue[SIM_CHN_QUEUE_MAX];
+    HI_U32 head;
+    HI_U32 cnt;
+    HI_U32 outCnt; // Frames taken by the app
+    HI_U32 dropCnt; // Frames overwritten in the queue or not produced for lack of a block
+} SimVpssChn;
+
+typedef struct {
+    HI_U8 *data;
+    HI_U32 len;
+    HI_U64 pts;
+    HI_U32 seq;
+    HI_BOOL key;
+} SimVencSlot;
+
+typedef struct {
+    HI_BOOL used;
+    HI_U32 taskCnt;
+    VGS_TASK_ATTR_S tasks[SIM_VGS_TASK_MAX];
+} SimVgsJob;
+
+typedef struct {
+    HI_U32 frm;
+    RectBox box;
+} SimDet;
+
+static SimPool g_pools[SIM_POOL_MAX];
+static pthread_mutex_t g_poolLock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct {
+    HI_U32 width, height, fps;
+    HI_U8 *pic; // NV21, stride == width
+    HI_U8 *background; // Synthetic scene without the target
+    FILE *clip;
+    HI_U32 clipFrm; // Frame index within the clip, or since start for the synthetic scene
+    HI_U32 frmCnt;
+    HI_U64 startUs;
+    HI_BOOL running;
+    pthread_t thread;
+} g_cam;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    HI_BOOL started;
+    SimVpssChn chns[VPSS_MAX_PHY_CHN_NUM];
+} g_vpss = { .lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER };
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    VENC_CHN_PARAM_S param;
+    VENC_CHN_ATTR_S attr;
+    VENC_JPEG_PARAM_S jpeg;
+    HI_S32 recvLeft; // Pictures still to encode, -1: until StopRecvFrame
+    HI_S32 fpsAcc; // Frame rate control accumulator
+    HI_S32 fd;
+    HI_U32 kb;
+    HI_U32 slotSize;
+    HI_U32 gopPos; // Pictures since the last I frame, H.264/H.265 only
+    HI_BOOL idrPending; // Next picture is an IDR, after RequestIDR or a reset
+    HI_U32 keyCnt;
+    SimVencSlot slots[SIM_VENC_SLOT_NUM];
+    HI_U32 head;
+    HI_U32 tail;
+    HI_U32 seq;
+    HI_U32 dropCnt;
+    HI_U64 bytes;
+} g_venc = { .lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER, .fd = -1 };
+
+static struct {
+    SimDet *dets;
+    HI_U32 detNum;
+    HI_U32 yoloMs;
+    HI_U32 calls;
+    HI_U32 hits; // Calls that returned at least one box
+} g_nnie;
+
+static SimVgsJob g_vgsJobs[SIM_VGS_JOB_MAX];
+static pthread_mutex_t g_vgsLock = PTHREAD_MUTEX_INITIALIZER;
+static HI_U32 g_vgsCnt;
+
+HI_U64 MpiSimNowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (HI_U64)ts.tv_sec * US_PER_S + (HI_U64)ts.tv_nsec / NS_PER_US;
+}
+
+HI_U32 MpiSimEnv(const char* name, HI_U32 def)
+{
+    const char *val = getenv(name);
+    return (val != NULL && *val != '\0') ? (HI_U32)strtoul(val, NULL, 0) : def;
+}
+
+static void SimDeadline(struct timespec* ts, HI_S32 milliSec)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += milliSec / 1000; // 1000: ms per s
+    ts->tv_nsec += (long)(milliSec % 1000) * 1000000L; // 1000000: ns per ms
+    if (ts->tv_nsec >= 1000000000L) { // 1000000000: ns per s
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/*
+ * 按milliSec语义等待条件变量：0不等，-1一直等
+ * Wait on a condition with the MPI milliSec meaning: 0 does not wait, -1 waits forever
+ */
+static HI_BOOL SimCondWait(pthread_cond_t* cond, pthread_mutex_t* lock, const struct timespec* deadline,
+    HI_S32 milliSec)
+{
+    if (milliSec == 0) {
+        return HI_FALSE;
+    }
+    if (milliSec < 0) {
+        pthread_cond_wait(cond, lock);
+        return HI_TRUE;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) == 0 ? HI_TRUE : HI_FALSE;
+}
+
+/* ---------------------------------------------------------------- VB ---------------------------------------------------------------- */
+
+static void* SimAlloc(size_t size)
+{
+    void *p = NULL;
+    return posix_memalign(&p, SIM_ALIGN, HI_ALIGN_UP(size, SIM_ALIGN)) == 0 ? p : NULL;
+}
+
+static VB_POOL SimPoolCreate(HI_U64 blkSize, HI_U32 blkCnt)
+{
+    VB_POOL pool = VB_INVALID_POOLID;
+
+    if (blkCnt == 0 || blkCnt > SIM_BLK_MAX) {
+        return VB_INVALID_POOLID;
+    }
+    pthread_mutex_lock(&g_poolLock);
+    for (HI_U32 i = 0; i < SIM_POOL_MAX; i++) {
+        if (!g_pools[i].used) {
+            pool = (VB_POOL)i;
+            break;
+        }
+    }
+    if ((HI_U32)pool != VB_INVALID_POOLID) {
+        SimPool *p = &g_pools[pool];
+        memset(p, 0, sizeof(*p));
+        p->used = HI_TRUE;
+        p->blkSize = blkSize;
+        p->blkCnt = blkCnt;
+        for (HI_U32 i = 0; i < blkCnt; i++) {
+            p->blks[i].data = SimAlloc(blkSize);
+            HI_ASSERT(p->blks[i].data);
+        }
+    }
+    pthread_mutex_unlock(&g_poolLock);
+    return pool;
+}
+
+static SimBlk* SimBlkLocked(VB_BLK blk)
+{
+    HI_U32 pool = blk >> SIM_BLK_SHIFT;
+    HI_U32 idx = blk & ((1U << SIM_BLK_SHIFT) - 1);
+
+    if (blk == VB_INVALID_HANDLE || pool >= SIM_POOL_MAX || !g_pools[pool].used || idx >= g_pools[pool].blkCnt) {
+        return NULL;
+    }
+    return &g_pools[pool].blks[idx];
+}
+
+/*
+ * 找到包含addr的块，off返回addr在块内的偏移
+ * Find the block containing addr, off returns the offset of addr in the block
+ */
+static VB_BLK SimBlkFindLocked(HI_U64 addr, HI_U64* off)
+{
+    for (HI_U32 i = 0; i < SIM_POOL_MAX; i++) {
+        const SimPool *p = &g_pools[i];
+        for (HI_U32 j = 0; p->used && j < p->blkCnt; j++) {
+            HI_U64 start = (HI_U64)(uintptr_t)p->blks[j].data;
+            if (addr >= start && addr < start + p->blkSize) {
+                if (off != NULL) {
+                    *off = addr - start;
+                }
+                return (i << SIM_BLK_SHIFT) | j;
+            }
+        }
+    }
+    return VB_INVALID_HANDLE;
+}
+
+VB_POOL HI_MPI_VB_CreatePool(VB_POOL_CONFIG_S *pstVbPoolCfg)
+{
+    return SimPoolCreate(pstVbPoolCfg->u64BlkSize, pstVbPoolCfg->u32BlkCnt);
+}
+
+HI_S32 HI_MPI_VB_DestroyPool(VB_POOL Pool)
+{
+    HI_S32 ret = HI_SUCCESS;
+
+    pthread_mutex_lock(&g_poolLock);
+    if ((HI_U32)Pool >= SIM_POOL_MAX || !g_pools[Pool].used) {
+        ret = (HI_S32)SIM_ERR_PARAM;
+    }
+    for (HI_U32 i = 0; ret == HI_SUCCESS && i < g_pools[Pool].blkCnt; i++) {
+        if (g_pools[Pool].blks[i].busy) {
+            ret = HI_FAILURE;
+        }
+    }
+    for (HI_U32 i = 0; ret == HI_SUCCESS && i < g_pools[Pool].blkCnt; i++) {
+        free(g_pools[Pool].blks[i].data);
+    }
+    if (ret == HI_SUCCESS) {
+        g_pools[Pool].used = HI_FALSE;
+    }
+    pthread_mutex_unlock(&g_poolLock);
+    return ret;
+}
+
+VB_BLK HI_MPI_VB_GetBlock(VB_POOL Pool, HI_U64 u64BlkSize, const HI_CHAR *pcMmzName)
+{
+    VB_BLK blk = VB_INVALID_HANDLE;
+
+    (void)pcMmzName;
+    pthread_mutex_lock(&g_poolLock);
+    if ((HI_U32)Pool < SIM_POOL_MAX && g_pools[Pool].used && u64BlkSize <= g_pools[Pool].blkSize) {
+        for (HI_U32 i = 0; i < g_pools[Pool].blkCnt; i++) {
+            if (!g_pools[Pool].blks[i].busy) {
+                g_pools[Pool].blks[i].busy = HI_TRUE;
+                memset(&g_pools[Pool].blks[i].tag, 0, sizeof(SimFrmTag));
+                blk = ((VB_BLK)Pool << SIM_BLK_SHIFT) | i;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_poolLock);
+    return blk;
+}
+
+HI_S32 HI_MPI_VB_ReleaseBlock(VB_BLK Block)
+{
+    SimBlk *b;
+    HI_S32 ret = HI_SUCCESS;
+
+    pthread_mutex_lock(&g_poolLock);
+    b = SimBlkLocked(Block);
+    if (b == NULL || !b->busy) {
+        ret = (HI_S32)SIM_ERR_PARAM;
+    } else {
+        b->busy = HI_FALSE;
+    }
+    pthread_mutex_unlock(&g_poolLock);
+    return ret;
+}
+
+HI_U64 HI_MPI_VB_Handle2PhysAddr(VB_BLK Block)
+{
+    SimBlk *b;
+    HI_U64 addr = 0;
+
+    pthread_mutex_lock(&g_poolLock);
+    b = SimBlkLocked(Block);
+    if (b != NULL) {
+        addr = (HI_U64)(uintptr_t)b->data; // Physical and virtual addresses are the same on the host
+    }
+    pthread_mutex_unlock(&g_poolLock);
+    return addr;
+}
+
+VB_BLK HI_MPI_VB_PhysAddr2Handle(HI_U64 u64PhyAddr)
+{
+    VB_BLK blk;
+
+    pthread_mutex_lock(&g_poolLock);
+    blk = SimBlkFindLocked(u64PhyAddr, NULL);
+    pthread_mutex_unlock(&g_poolLock);
+    return blk;
+}
+
+HI_S32 HI_MPI_VB_MmapPool(VB_POOL Pool)
+{
+    return ((HI_U32)Pool < SIM_POOL_MAX && g_pools[Pool].used) ? HI_SUCCESS : (HI_S32)SIM_ERR_PARAM;
+}
+
+HI_S32 HI_MPI_VB_MunmapPool(VB_POOL Pool)
+{
+    return HI_MPI_VB_MmapPool(Pool);
+}
+
+HI_S32 HI_MPI_VB_GetBlockVirAddr(VB_POOL Pool, HI_U64 u64PhyAddr, HI_VOID **ppVirAddr)
+{
+    (void)Pool;
+    *ppVirAddr = (HI_VOID*)(uintptr_t)u64PhyAddr;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VB_Exit(void)
+{
+    return HI_SUCCESS;
+}
+
+HI_U32 COMMON_GetPicBufferSize(HI_U32 w, HI_U32 h, PIXEL_FORMAT_E f, DATA_BITWIDTH_E b, COMPRESS_MODE_E c, HI_U32 a)
+{
+    (void)f;
+    (void)b;
+    (void)c;
+    return HI_ALIGN_UP(w, a) * h * 3 / 2; // 3/2: NV21
+}
+
+HI_U32 VI_GetRawBufferSize(HI_U32 w, HI_U32 h, PIXEL_FORMAT_E f, COMPRESS_MODE_E c, HI_U32 a)
+{
+    (void)f;
+    (void)c;
+    return HI_ALIGN_UP(w * 2, a) * h; // 2: 16 bit raw
+}
+
+/* ---------------------------------------------------------------- SYS ---------------------------------------------------------------- */
+
+HI_S32 HI_MPI_SYS_GetCurPTS(HI_U64 *pu64CurPTS)
+{
+    *pu64CurPTS = MpiSimNowUs();
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_SYS_Bind(const MPP_CHN_S *src, const MPP_CHN_S *dst)
+{
+    (void)src;
+    (void)dst;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_SYS_Exit(void)
+{
+    return HI_SUCCESS;
+}
+
+/* ---------------------------------------------------------------- 缩放 Scaling ---------------------------------------------------------------- */
+
+/*
+ * NV21最近邻缩放，源可以是带偏移的视图
+ * Nearest neighbour NV21 scaling, the source may be an offset view
+ */
+static void SimScaleNv21(const HI_U8* srcY, const HI_U8* srcVu, HI_U32 srcStride, HI_U32 srcW, HI_U32 srcH,
+    HI_U8* dstY, HI_U8* dstVu, HI_U32 dstStride, HI_U32 dstW, HI_U32 dstH)
+{
+    for (HI_U32 y = 0; y < dstH; y++) {
+        const HI_U8 *s = srcY + (HI_U64)(y * srcH / dstH) * srcStride;
+        HI_U8 *d = dstY + (HI_U64)y * dstStride;
+        if (srcW == dstW) {
+            memcpy(d, s, dstW);
+            continue;
+        }
+        for (HI_U32 x = 0; x < dstW; x++) {
+            d[x] = s[x * srcW / dstW];
+        }
+    }
+    for (HI_U32 y = 0; y < dstH / 2; y++) { // 2: chroma is subsampled in both directions
+        const HI_U8 *s = srcVu + (HI_U64)(y * (srcH / 2) / (dstH / 2)) * srcStride;
+        HI_U8 *d = dstVu + (HI_U64)y * dstStride;
+        for (HI_U32 x = 0; x < dstW / 2; x++) {
+            HI_U32 sx = x * (srcW / 2) / (dstW / 2) * 2;
+            d[x * 2] = s[sx];
+            d[x * 2 + 1] = s[sx + 1];
+        }
+    }
+}
+
+static void SimFrmFill(VIDEO_FRAME_INFO_S* frm, HI_U8* data, HI_U32 width, HI_U32 height, HI_U32 stride,
+    HI_U32 poolId)
+{
+    VIDEO_FRAME_S *vFrm = &frm->stVFrame;
+
+    memset(frm, 0, sizeof(*frm));
+    frm->u32PoolId = poolId;
+    frm->enModId = HI_ID_VPSS;
+    vFrm->u32Width = width;
+    vFrm->u32Height = height;
+    vFrm->enField = VIDEO_FIELD_FRAME;
+    vFrm->enPixelFormat = PIXEL_FORMAT_YVU_SEMIPLANAR_420;
+    vFrm->enVideoFormat = VIDEO_FORMAT_LINEAR;
+    vFrm->enCompressMode = COMPRESS_MODE_NONE;
+    vFrm->enDynamicRange = DYNAMIC_RANGE_SDR8;
+    vFrm->enColorGamut = COLOR_GAMUT_BT709;
+    vFrm->u32Stride[0] = stride;
+    vFrm->u32Stride[1] = stride;
+    vFrm->u64PhyAddr[0] = (HI_U64)(uintptr_t)data;
+    vFrm->u64PhyAddr[1] = vFrm->u64PhyAddr[0] + (HI_U64)stride * height;
+    vFrm->u64VirAddr[0] = vFrm->u64PhyAddr[0];
+    vFrm->u64VirAddr[1] = vFrm->u64PhyAddr[1];
+}
+
+/*
+ * 求addr处宽w高h的视图对应的相机窗口
+ * Work out the camera window shown by the w x h view at addr
+ */
+static HI_BOOL SimTagOfView(HI_U64 addr, HI_U32 w, HI_U32 h, SimFrmTag* tag)
+{
+    HI_U64 off = 0;
+    VB_BLK blk;
+    const SimBlk *b;
+    HI_BOOL ok = HI_FALSE;
+
+    pthread_mutex_lock(&g_poolLock);
+    blk = SimBlkFindLocked(addr, &off);
+    b = SimBlkLocked(blk);
+    if (b != NULL && b->tag.width != 0) {
+        const SimFrmTag *t = &b->tag;
+        double sx = t->w / t->width;
+        double sy = t->h / t->height;
+        tag->clipFrm = t->clipFrm;
+        tag->x = t->x + (double)(off % t->stride) * sx;
+        tag->y = t->y + (double)(off / t->stride) * sy;
+        tag->w = w * sx;
+        tag->h = h * sy;
+        ok = HI_TRUE;
+    }
+    pthread_mutex_unlock(&g_poolLock);
+    return ok;
+}
+
+static void SimTagSet(HI_U64 addr, const SimFrmTag* tag)
+{
+    SimBlk *b;
+
+    pthread_mutex_lock(&g_poolLock);
+    b = SimBlkLocked(SimBlkFindLocked(addr, NULL));
+    if (b != NULL) {
+        b->tag = *tag;
+    }
+    pthread_mutex_unlock(&g_poolLock);
+}
+
+/* ---------------------------------------------------------------- 相机 Camera ---------------------------------------------------------------- */
+
+#define SIM_SCENE_CYCLE_S   10.0 // The synthetic target moves for SIM_SCENE_MOVE_S then holds still
+#define SIM_SCENE_MOVE_S    6.0
+#define SIM_SCENE_BG_Y      60
+#define SIM_SCENE_FG_Y      220
+#define SIM_SCENE_UV        128
+
+/*
+ * 合成场景中目标在第frm帧的位置，运动一段、静止一段，用来同时覆盖跟踪和运动门控
+ * Target position in frame frm of the synthetic scene, it moves then holds still, covering tracking and motion gating
+ */
+static void SimSceneBox(HI_U32 frm, RectBox* box)
+{
+    double t = (double)frm / g_cam.fps;
+    double cycle = floor(t / SIM_SCENE_CYCLE_S);
+    double phase = fmin(t - cycle * SIM_SCENE_CYCLE_S, SIM_SCENE_MOVE_S);
+    double tm = cycle * SIM_SCENE_MOVE_S + phase;
+    double cx = g_cam.width * (0.5 + 0.3 * sin(2 * M_PI * tm / 4.0)); // 0.3, 4.0: horizontal swing and period
+    double cy = g_cam.height * (0.5 + 0.25 * sin(2 * M_PI * tm / 3.0)); // 0.25, 3.0: vertical swing and period
+    int half = (int)(g_cam.height / 12); // 12: the target is a sixth of the picture height
+
+    box->xmin = (int)cx - half;
+    box->ymin = (int)cy - half;
+    box->xmax = (int)cx + half;
+    box->ymax = (int)cy + half;
+}
+
+static void SimCamFill(void)
+{
+    HI_U32 lumaSize = g_cam.width * g_cam.height;
+    size_t frmSize = (size_t)lumaSize * 3 / 2;
+    RectBox box;
+
+    if (g_cam.clip != NULL) {
+        if (fread(g_cam.pic, 1, frmSize, g_cam.clip) != frmSize) {
+            rewind(g_cam.clip);
+            g_cam.clipFrm = 0;
+            if (fread(g_cam.pic, 1, frmSize, g_cam.clip) != frmSize) {
+                memset(g_cam.pic, SIM_SCENE_UV, frmSize);
+            }
+        }
+        return;
+    }
+    memcpy(g_cam.pic, g_cam.background, frmSize);
+    SimSceneBox(g_cam.clipFrm, &box);
+    for (int y = box.ymin < 0 ? 0 : box.ymin; y < box.ymax && y < (int)g_cam.height; y++) {
+        for (int x = box.xmin < 0 ? 0 : box.xmin; x < box.xmax && x < (int)g_cam.width; x++) {
+            g_cam.pic[(size_t)y * g_cam.width + x] = SIM_SCENE_FG_Y;
+        }
+    }
+}
+
+/*
+ * 把当前相机画面缩放进通道的一块缓冲并入队，队满时丢最老的一帧
+ * Scale the current camera picture into a block of the channel and queue it, the oldest frame goes when full
+ */
+static void SimVpssEmit(SimVpssChn* chn, HI_U64 pts)
+{
+    HI_U32 width, height, stride;
+    VIDEO_FRAME_INFO_S frm;
+    SimFrmTag tag;
+    VB_BLK blk = HI_MPI_VB_GetBlock(chn->pool, 0, NULL);
+    HI_U8 *data;
+
+    pthread_mutex_lock(&g_vpss.lock); // The size may change at runtime, see HI_MPI_VPSS_SetChnAttr
+    width = chn->attr.u32Width;
+    height = chn->attr.u32Height;
+    pthread_mutex_unlock(&g_vpss.lock);
+    stride = HI_ALIGN_UP(width, SIM_ALIGN);
+    tag = (SimFrmTag){ g_cam.clipFrm, 0, 0, g_cam.width, g_cam.height, width, height, stride };
+
+    if (blk == VB_INVALID_HANDLE) {
+        __atomic_fetch_add(&chn->dropCnt, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    data = (HI_U8*)(uintptr_t)HI_MPI_VB_Handle2PhysAddr(blk);
+    SimScaleNv21(g_cam.pic, g_cam.pic + g_cam.width * g_cam.height, g_cam.width, g_cam.width, g_cam.height,
+        data, data + stride * height, stride, width, height);
+    SimTagSet((HI_U64)(uintptr_t)data, &tag);
+    SimFrmFill(&frm, data, width, height, stride, (HI_U32)chn->pool);
+    frm.stVFrame.u64PTS = pts;
+    frm.stVFrame.u32TimeRef = g_cam.frmCnt * 2; // 2: the MPI counts fields
+
+    pthread_mutex_lock(&g_vpss.lock);
+    if (chn->cnt == chn->attr.u32Depth) {
+        VIDEO_FRAME_INFO_S *old = &chn->queue[chn->head];
+        HI_MPI_VB_ReleaseBlock(HI_MPI_VB_PhysAddr2Handle(old->stVFrame.u64PhyAddr[0]));
+        chn->head = (chn->head + 1) % SIM_CHN_QUEUE_MAX;
+        chn->cnt--;
+        chn->dropCnt++;
+    }
+    chn->queue[(chn->head + chn->cnt) % SIM_CHN_QUEUE_MAX] = frm;
+    chn->cnt++;
+    pthread_cond_broadcast(&g_vpss.cond);
+    pthread_mutex_unlock(&g_vpss.lock);
+}
+
+static void SimVencFeed(HI_U64 pts);
+
+static void* SimCamTrd(void* arg)
+{
+    struct timespec next;
+    HI_U64 periodNs = US_PER_S * NS_PER_US / g_cam.fps;
+
+    (void)arg;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (__atomic_load_n(&g_cam.running, __ATOMIC_ACQUIRE)) {
+        next.tv_nsec += (long)periodNs;
+        while (next.tv_nsec >= (long)(US_PER_S * NS_PER_US)) {
+            next.tv_nsec -= (long)(US_PER_S * NS_PER_US);
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        SimCamFill();
+        HI_U64 pts = MpiSimNowUs();
+        for (HI_U32 i = 0; i < VPSS_MAX_PHY_CHN_NUM; i++) {
+            SimVpssChn *chn = &g_vpss.chns[i];
+            if (__atomic_load_n(&g_vpss.started, __ATOMIC_ACQUIRE) && chn->enabled && chn->attr.u32Depth > 0) {
+                SimVpssEmit(chn, pts);
+            }
+        }
+        SimVencFeed(pts);
+        g_cam.clipFrm++;
+        g_cam.frmCnt++;
+    }
+    return NULL;
+}
+
+static HI_S32 SimCamOpen(void)
+{
+    const char *clip = getenv("SIM_CLIP");
+    const char *size = getenv("SIM_CLIP_SIZE");
+    size_t frmSize;
+
+    g_cam.width = 1920; // 1920 x 1080: the sensor size of the board
+    g_cam.height = 1080;
+    if (size != NULL && (sscanf(size, "%ux%u", &g_cam.width, &g_cam.height) != 2 ||
+        g_cam.width % 2 != 0 || g_cam.height % 2 != 0)) {
+        printf("[sim] bad SIM_CLIP_SIZE %s, want an even WxH\n", size);
+        return HI_FAILURE;
+    }
+    g_cam.fps = MpiSimEnv("SIM_FPS", 30); // 30: sensor frame rate
+    g_cam.fps = g_cam.fps == 0 ? 1 : g_cam.fps;
+    frmSize = (size_t)g_cam.width * g_cam.height * 3 / 2;
+    g_cam.pic = malloc(frmSize);
+    g_cam.background = malloc(frmSize);
+    HI_ASSERT(g_cam.pic && g_cam.background);
+
+    if (clip != NULL) {
+        g_cam.clip = fopen(clip, "rb");
+        if (g_cam.clip == NULL) {
+            printf("[sim] open clip %s FAIL\n", clip);
+            return HI_FAILURE;
+        }
+        printf("[sim] camera: clip %s %ux%u @ %u fps\n", clip, g_cam.width, g_cam.height, g_cam.fps);
+        return HI_SUCCESS;
+    }
+    for (HI_U32 y = 0; y < g_cam.height; y++) {
+        for (HI_U32 x = 0; x < g_cam.width; x++) {
+            g_cam.background[(size_t)y * g_cam.width + x] = (HI_U8)(SIM_SCENE_BG_Y + (x + y) % 32); // 32: texture
+        }
+    }
+    memset(g_cam.background + (size_t)g_cam.width * g_cam.height, SIM_SCENE_UV, frmSize / 3); // 3: VU plane
+    printf("[sim] camera: synthetic %ux%u @ %u fps\n", g_cam.width, g_cam.height, g_cam.fps);
+    return HI_SUCCESS;
+}
+
+/* ---------------------------------------------------------------- VPSS ---------------------------------------------------------------- */
+
+static SimVpssChn* SimVpssChnGet(VPSS_GRP g, VPSS_CHN c)
+{
+    return (g == 0 && c >= 0 && c < VPSS_MAX_PHY_CHN_NUM) ? &g_vpss.chns[c] : NULL;
+}
+
+HI_S32 HI_MPI_VPSS_CreateGrp(VPSS_GRP g, const VPSS_GRP_ATTR_S *a)
+{
+    (void)a;
+    return g == 0 ? HI_SUCCESS : (HI_S32)SIM_ERR_PARAM;
+}
+
+HI_S32 HI_MPI_VPSS_DestroyGrp(VPSS_GRP g)
+{
+    return g == 0 ? HI_SUCCESS : (HI_S32)SIM_ERR_PARAM;
+}
+
+HI_S32 HI_MPI_VPSS_StartGrp(VPSS_GRP g)
+{
+    if (g != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    __atomic_store_n(&g_vpss.started, HI_TRUE, __ATOMIC_RELEASE);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VPSS_StopGrp(VPSS_GRP g)
+{
+    if (g != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    __atomic_store_n(&g_vpss.started, HI_FALSE, __ATOMIC_RELEASE);
+    return HI_SUCCESS;
+}
+
+/*
+ * 已使能的通道只能改成其缓冲块放得下的尺寸(深度不变)，对应板端VB池按最大尺寸配置的情形
+ * An enabled channel may only be resized within its pool block (same depth), as on the board where the
+ * VB pool is sized for the largest picture
+ */
+HI_S32 HI_MPI_VPSS_SetChnAttr(VPSS_GRP g, VPSS_CHN c, const VPSS_CHN_ATTR_S *a)
+{
+    SimVpssChn *chn = SimVpssChnGet(g, c);
+    HI_S32 ret = HI_SUCCESS;
+
+    if (chn == NULL || a->u32Depth > SIM_CHN_QUEUE_MAX || a->u32Width == 0 || a->u32Height == 0 ||
+        a->u32Width % 2 != 0 || a->u32Height % 2 != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_vpss.lock);
+    if (chn->enabled && (a->u32Depth != chn->attr.u32Depth ||
+        (HI_U64)HI_ALIGN_UP(a->u32Width, SIM_ALIGN) * a->u32Height * 3 / 2 > g_pools[chn->pool].blkSize)) { // 3/2: NV21
+        ret = (HI_S32)SIM_ERR_PARAM;
+    } else {
+        chn->attr = *a;
+    }
+    pthread_mutex_unlock(&g_vpss.lock);
+    return ret;
+}
+
+HI_S32 HI_MPI_VPSS_GetChnAttr(VPSS_GRP g, VPSS_CHN c, VPSS_CHN_ATTR_S *a)
+{
+    SimVpssChn *chn = SimVpssChnGet(g, c);
+
+    if (chn == NULL) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_vpss.lock);
+    *a = chn->attr;
+    pthread_mutex_unlock(&g_vpss.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VPSS_EnableChn(VPSS_GRP g, VPSS_CHN c)
+{
+    SimVpssChn *chn = SimVpssChnGet(g, c);
+    HI_U32 stride;
+
+    if (chn == NULL || chn->attr.u32Width == 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    stride = HI_ALIGN_UP(chn->attr.u32Width, SIM_ALIGN);
+    chn->pool = SimPoolCreate((HI_U64)stride * chn->attr.u32Height * 3 / 2, // 3/2: NV21
+        chn->attr.u32Depth + SIM_CHN_BLK_EXTRA);
+    if ((HI_U32)chn->pool == VB_INVALID_POOLID) {
+        return HI_FAILURE;
+    }
+    chn->head = 0;
+    chn->cnt = 0;
+    __atomic_store_n(&chn->enabled, HI_TRUE, __ATOMIC_RELEASE);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VPSS_DisableChn(VPSS_GRP g, VPSS_CHN c)
+{
+    SimVpssChn *chn = SimVpssChnGet(g, c);
+    HI_S32 ret;
+
+    if (chn == NULL || !chn->enabled) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_vpss.lock);
+    __atomic_store_n(&chn->enabled, HI_FALSE, __ATOMIC_RELEASE);
+    while (chn->cnt > 0) {
+        HI_MPI_VB_ReleaseBlock(HI_MPI_VB_PhysAddr2Handle(chn->queue[chn->head].stVFrame.u64PhyAddr[0]));
+        chn->head = (chn->head + 1) % SIM_CHN_QUEUE_MAX;
+        chn->cnt--;
+    }
+    pthread_mutex_unlock(&g_vpss.lock);
+    /* The camera thread may still be writing a block, the pool goes once that is given back */
+    for (int i = 0; (ret = HI_MPI_VB_DestroyPool(chn->pool)) != HI_SUCCESS && i < 100; i++) { // 100: 1 s
+        usleep(10000); // 10000: 10 ms
+    }
+    if (ret != HI_SUCCESS) {
+        printf("[sim] vpss chn %d: frames still held by the app\n", c);
+    }
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VPSS_GetChnFrame(VPSS_GRP g, VPSS_CHN c, VIDEO_FRAME_INFO_S *f, HI_S32 ms)
+{
+    SimVpssChn *chn = SimVpssChnGet(g, c);
+    struct timespec deadline;
+    HI_S32 ret = HI_SUCCESS;
+
+    if (chn == NULL || !chn->enabled) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    SimDeadline(&deadline, ms);
+    pthread_mutex_lock(&g_vpss.lock);
+    while (chn->cnt == 0) {
+        if (!SimCondWait(&g_vpss.cond, &g_vpss.lock, &deadline, ms)) {
+            ret = (HI_S32)(ms == 0 ? SIM_ERR_EMPTY : SIM_ERR_TIMEOUT);
+            break;
+        }
+    }
+    if (ret == HI_SUCCESS) {
+        *f = chn->queue[chn->head];
+        chn->head = (chn->head + 1) % SIM_CHN_QUEUE_MAX;
+        chn->cnt--;
+        chn->outCnt++;
+    }
+    pthread_mutex_unlock(&g_vpss.lock);
+    return ret;
+}
+
+HI_S32 HI_MPI_VPSS_ReleaseChnFrame(VPSS_GRP g, VPSS_CHN c, const VIDEO_FRAME_INFO_S *f)
+{
+    if (SimVpssChnGet(g, c) == NULL) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    return HI_MPI_VB_ReleaseBlock(HI_MPI_VB_PhysAddr2Handle(f->stVFrame.u64PhyAddr[0]));
+}
+
+/* ---------------------------------------------------------------- VGS ---------------------------------------------------------------- */
+
+HI_S32 HI_MPI_VGS_BeginJob(VGS_HANDLE *h)
+{
+    HI_S32 ret = HI_FAILURE;
+
+    pthread_mutex_lock(&g_vgsLock);
+    for (HI_S32 i = 0; i < SIM_VGS_JOB_MAX; i++) {
+        if (!g_vgsJobs[i].used) {
+            g_vgsJobs[i].used = HI_TRUE;
+            g_vgsJobs[i].taskCnt = 0;
+            *h = i;
+            ret = HI_SUCCESS;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_vgsLock);
+    return ret;
+}
+
+HI_S32 HI_MPI_VGS_AddScaleTask(VGS_HANDLE h, const VGS_TASK_ATTR_S *t, VGS_SCLCOEF_MODE_E m)
+{
+    (void)m;
+    if (h < 0 || h >= SIM_VGS_JOB_MAX || !g_vgsJobs[h].used || g_vgsJobs[h].taskCnt >= SIM_VGS_TASK_MAX ||
+        t->stImgIn.stVFrame.enCompressMode != COMPRESS_MODE_NONE) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    g_vgsJobs[h].tasks[g_vgsJobs[h].taskCnt++] = *t;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VGS_EndJob(VGS_HANDLE h)
+{
+    if (h < 0 || h >= SIM_VGS_JOB_MAX || !g_vgsJobs[h].used) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    for (HI_U32 i = 0; i < g_vgsJobs[h].taskCnt; i++) {
+        const VIDEO_FRAME_S *in = &g_vgsJobs[h].tasks[i].stImgIn.stVFrame;
+        const VIDEO_FRAME_S *out = &g_vgsJobs[h].tasks[i].stImgOut.stVFrame;
+        SimFrmTag tag;
+        SimScaleNv21((const HI_U8*)(uintptr_t)in->u64VirAddr[0], (const HI_U8*)(uintptr_t)in->u64VirAddr[1],
+            in->u32Stride[0], in->u32Width, in->u32Height,
+            (HI_U8*)(uintptr_t)out->u64VirAddr[0], (HI_U8*)(uintptr_t)out->u64VirAddr[1],
+            out->u32Stride[0], out->u32Width, out->u32Height);
+        if (SimTagOfView(in->u64VirAddr[0], in->u32Width, in->u32Height, &tag)) {
+            tag.width = out->u32Width;
+            tag.height = out->u32Height;
+            tag.stride = out->u32Stride[0];
+            SimTagSet(out->u64VirAddr[0], &tag);
+        }
+    }
+    __atomic_fetch_add(&g_vgsCnt, g_vgsJobs[h].taskCnt, __ATOMIC_RELAXED);
+    return HI_MPI_VGS_CancelJob(h);
+}
+
+HI_S32 HI_MPI_VGS_CancelJob(VGS_HANDLE h)
+{
+    if (h < 0 || h >= SIM_VGS_JOB_MAX) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_vgsLock);
+    g_vgsJobs[h].used = HI_FALSE;
+    pthread_mutex_unlock(&g_vgsLock);
+    return HI_SUCCESS;
+}
+
+/* ---------------------------------------------------------------- IVE ---------------------------------------------------------------- */
+
+/*
+ * 任务同步执行，Query总是返回完成
+ * Tasks run synchronously, Query always reports them finished
+ */
+HI_S32 HI_MPI_IVE_SAD(IVE_HANDLE *h, IVE_SRC_IMAGE_S *s1, IVE_SRC_IMAGE_S *s2, IVE_DST_IMAGE_S *sad,
+    IVE_DST_IMAGE_S *thr, IVE_SAD_CTRL_S *c, HI_BOOL bInstant)
+{
+    const HI_U32 blk = 16; // IVE_SAD_MODE_MB_16X16 only
+
+    (void)bInstant;
+    if (c->enMode != IVE_SAD_MODE_MB_16X16 || c->enOutCtrl != IVE_SAD_OUT_CTRL_16BIT_BOTH) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    for (HI_U32 by = 0; by < s1->u32Height / blk; by++) {
+        HI_U16 *sadRow = (HI_U16*)(uintptr_t)sad->au64PhyAddr[0] + (HI_U64)by * sad->au32Stride[0];
+        HI_U8 *thrRow = (HI_U8*)(uintptr_t)thr->au64PhyAddr[0] + (HI_U64)by * thr->au32Stride[0];
+        for (HI_U32 bx = 0; bx < s1->u32Width / blk; bx++) {
+            HI_U32 sum = 0;
+            for (HI_U32 y = by * blk; y < (by + 1) * blk; y++) {
+                const HI_U8 *a = (const HI_U8*)(uintptr_t)s1->au64PhyAddr[0] + (HI_U64)y * s1->au32Stride[0];
+                const HI_U8 *b = (const HI_U8*)(uintptr_t)s2->au64PhyAddr[0] + (HI_U64)y * s2->au32Stride[0];
+                for (HI_U32 x = bx * blk; x < (bx + 1) * blk; x++) {
+                    sum += (HI_U32)abs((int)a[x] - (int)b[x]);
+                }
+            }
+            sadRow[bx] = (HI_U16)sum;
+            thrRow[bx] = sum >= c->u16Thr ? c->u8MaxVal : c->u8MinVal;
+        }
+    }
+    *h = 0;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_IVE_DMA(IVE_HANDLE *h, IVE_DATA_S *src, IVE_DST_DATA_S *dst, IVE_DMA_CTRL_S *c, HI_BOOL bInstant)
+{
+    (void)bInstant;
+    if (c->enMode != IVE_DMA_MODE_DIRECT_COPY) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    for (HI_U32 y = 0; y < src->u32Height; y++) {
+        memcpy((HI_U8*)(uintptr_t)dst->u64PhyAddr + (HI_U64)y * dst->u32Stride,
+            (const HI_U8*)(uintptr_t)src->u64PhyAddr + (HI_U64)y * src->u32Stride, src->u32Width);
+    }
+    *h = 0;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_IVE_Query(IVE_HANDLE h, HI_BOOL *pbFinish, HI_BOOL bBlock)
+{
+    (void)h;
+    (void)bBlock;
+    *pbFinish = HI_TRUE;
+    return HI_SUCCESS;
+}
+
+int IveImgCreate(IVE_IMAGE_S *img, IVE_IMAGE_TYPE_E enType, uint32_t width, uint32_t height)
+{
+    HI_U32 stride = HI_ALIGN_UP(width, SIM_ALIGN);
+    size_t size;
+
+    memset(img, 0, sizeof(*img));
+    switch (enType) {
+        case IVE_IMAGE_TYPE_U8C1:
+            size = (size_t)stride * height;
+            break;
+        case IVE_IMAGE_TYPE_U16C1:
+            size = (size_t)stride * height * sizeof(HI_U16);
+            break;
+        case IVE_IMAGE_TYPE_YUV420SP:
+            size = (size_t)stride * height * 3 / 2; // 3/2: Y plane + VU plane
+            break;
+        default:
+            return HI_FAILURE;
+    }
+    img->au64PhyAddr[0] = (HI_U64)(uintptr_t)SimAlloc(size);
+    if (img->au64PhyAddr[0] == 0) {
+        return HI_FAILURE;
+    }
+    memset((void*)(uintptr_t)img->au64PhyAddr[0], 0, size);
+    img->au64VirAddr[0] = img->au64PhyAddr[0];
+    img->au32Stride[0] = stride;
+    if (enType == IVE_IMAGE_TYPE_YUV420SP) {
+        img->au64PhyAddr[1] = img->au64PhyAddr[0] + (HI_U64)stride * height;
+        img->au64VirAddr[1] = img->au64PhyAddr[1];
+        img->au32Stride[1] = stride;
+    }
+    img->u32Width = width;
+    img->u32Height = height;
+    img->enType = enType;
+    return HI_SUCCESS;
+}
+
+void IveImgDestroy(IVE_IMAGE_S *img)
+{
+    free((void*)(uintptr_t)img->au64VirAddr[0]);
+    memset(img, 0, sizeof(*img));
+}
+
+int FrmToOrigImg(const VIDEO_FRAME_INFO_S *frm, IVE_IMAGE_S *img)
+{
+    const VIDEO_FRAME_S *vFrm = &frm->stVFrame;
+
+    if (vFrm->enPixelFormat != PIXEL_FORMAT_YVU_SEMIPLANAR_420) {
+        return HI_FAILURE;
+    }
+    memset(img, 0, sizeof(*img));
+    img->enType = IVE_IMAGE_TYPE_YUV420SP;
+    img->u32Width = vFrm->u32Width;
+    img->u32Height = vFrm->u32Height;
+    for (int i = 0; i < 2; i++) { // 2: Y plane + VU plane
+        img->au64PhyAddr[i] = vFrm->u64PhyAddr[i];
+        img->au64VirAddr[i] = vFrm->u64VirAddr[i];
+        img->au32Stride[i] = vFrm->u32Stride[i];
+    }
+    return HI_SUCCESS;
+}
+
+/* ---------------------------------------------------------------- VENC ---------------------------------------------------------------- */
+
+/*
+ * 码流大小相对于最大尺寸、QFactor 90时的千分比：按面积缩放，QFactor按平方近似
+ * Stream size in permille of the max picture size at QFactor 90: scales with the area, and roughly with
+ * the square of the QFactor
+ */
+static HI_U32 SimVencScale(void)
+{
+    const VENC_ATTR_S *a = &g_venc.attr.stVencAttr;
+    HI_U64 maxArea = (HI_U64)a->u32MaxPicWidth * a->u32MaxPicHeight;
+    HI_U32 q = g_venc.jpeg.u32Qfactor;
+    HI_U32 areaScale = SIM_PERMILLE;
+    HI_U32 qScale = SIM_PERMILLE;
+
+    if (maxArea != 0) {
+        areaScale = (HI_U32)((HI_U64)a->u32PicWidth * a->u32PicHeight * SIM_PERMILLE / maxArea);
+    }
+    if (q != 0 && q < SIM_JPEG_REF_Q) {
+        qScale = q * q * SIM_PERMILLE / (SIM_JPEG_REF_Q * SIM_JPEG_REF_Q);
+        qScale = qScale < SIM_PERMILLE / 10 ? SIM_PERMILLE / 10 : qScale; // 10: headers and tables stay
+    }
+    return areaScale * qScale / SIM_PERMILLE;
+}
+
+/*
+ * 相机每出一帧调用一次；按帧率控制和接收计数决定是否"编码"，码流槽满时丢弃新帧，与VENC码流缓冲满时一致
+ * Called once per camera frame; frame rate control and the receive count decide whether to "encode",
+ * a new picture is dropped when the stream slots are full, as VENC does when its stream buffer is full
+ */
+static HI_BOOL SimVencIsH26x(void)
+{
+    return g_venc.attr.stVencAttr.enType == PT_H264 || g_venc.attr.stVencAttr.enType == PT_H265;
+}
+
+/*
+ * 本帧码流字节数：JPEG按面积和QFactor缩放SIM_JPEG_KB；H.264/H.265把码控的码率按GOP分给I帧和P帧
+ * Stream bytes of this picture: JPEG scales SIM_JPEG_KB by area and QFactor, H.264/H.265 split the
+ * rate control bitrate over the GOP between the I frame and the P frames
+ */
+static HI_U32 SimVencFrameBytes(HI_BOOL key)
+{
+    const VENC_H264_CBR_S *cbr = &g_venc.attr.stRcAttr.stH264Cbr; // The H.265 CBR has the same layout
+    HI_U64 bytes = (HI_U64)g_venc.kb * 1024 * SimVencScale() / SIM_PERMILLE; // 1024: KB
+    HI_U64 gopBytes;
+
+    if (SimVencIsH26x() && cbr->fr32DstFrameRate > 0 && cbr->u32Gop > 0) {
+        gopBytes = (HI_U64)cbr->u32BitRate * 1000 / 8 * cbr->u32Gop / cbr->fr32DstFrameRate; // 1000 / 8: kbit to B
+        bytes = gopBytes / (cbr->u32Gop - 1 + SIM_I_P_RATIO);
+        bytes = key ? bytes * SIM_I_P_RATIO : bytes;
+    }
+    bytes = bytes * (90 + rand() % 21) / 100; // +-10 %
+    bytes = bytes < 8 ? 8 : bytes; // 8: room for the markers
+    return bytes > g_venc.slotSize ? g_venc.slotSize : (HI_U32)bytes;
+}
+
+/*
+ * 填充假码流：JPEG带SOI/EOI，H.264/H.265带起始码和NAL头，接收端可据此认出格式与帧类型
+ * Fill a fake stream: SOI/EOI for JPEG, a start code and NAL header for H.264/H.265,
+ * so receivers can tell the format and frame type
+ */
+static void SimVencFill(SimVencSlot *slot)
+{
+    static const HI_U8 startCode[] = { 0, 0, 0, 1 };
+    HI_U8 *nal = slot->data + sizeof(startCode);
+
+    memset(slot->data, (int)(g_venc.seq & 0x7F) | 0x01, slot->len); // 0x01: never a start code
+    if (!SimVencIsH26x()) {
+        slot->data[0] = 0xFF; // SOI
+        slot->data[1] = 0xD8;
+        slot->data[slot->len - 2] = 0xFF; // EOI
+        slot->data[slot->len - 1] = 0xD9;
+        return;
+    }
+    memcpy(slot->data, startCode, sizeof(startCode));
+    if (g_venc.attr.stVencAttr.enType == PT_H264) {
+        nal[0] = (HI_U8)(0x60 | (slot->key ? H264E_NALU_IDRSLICE : H264E_NALU_PSLICE)); // 0x60: nal_ref_idc 3
+    } else {
+        nal[0] = (HI_U8)((slot->key ? H265E_NALU_IDRSLICE : H265E_NALU_PSLICE) << 1);
+        nal[1] = 1; // 1: nuh_temporal_id_plus1
+    }
+}
+
+static void SimVencFeed(HI_U64 pts)
+{
+    HI_S32 src, dst;
+    SimVencSlot *slot;
+    HI_U64 one = 1;
+
+    pthread_mutex_lock(&g_venc.lock);
+    src = g_venc.param.stFrameRate.s32SrcFrameRate;
+    dst = g_venc.param.stFrameRate.s32DstFrameRate;
+    if (g_venc.recvLeft == 0) {
+        goto UNLOCK;
+    }
+    if (src > 0 && dst > 0 && dst < src) {
+        g_venc.fpsAcc += dst;
+        if (g_venc.fpsAcc < src) {
+            goto UNLOCK;
+        }
+        g_venc.fpsAcc -= src;
+    }
+    if (g_venc.recvLeft > 0) {
+        g_venc.recvLeft--;
+    }
+    if (g_venc.head - g_venc.tail >= SIM_VENC_SLOT_NUM) {
+        g_venc.dropCnt++;
+        goto UNLOCK;
+    }
+
+    slot = &g_venc.slots[g_venc.head % SIM_VENC_SLOT_NUM];
+    slot->key = HI_TRUE;
+    if (SimVencIsH26x()) {
+        if (g_venc.gopPos >= g_venc.attr.stRcAttr.stH264Cbr.u32Gop) {
+            g_venc.gopPos = 0;
+        }
+        slot->key = g_venc.idrPending || g_venc.gopPos == 0 ? HI_TRUE : HI_FALSE;
+        g_venc.gopPos = slot->key ? 1 : g_venc.gopPos + 1;
+        g_venc.idrPending = HI_FALSE;
+    }
+    g_venc.keyCnt += slot->key ? 1 : 0;
+    slot->len = SimVencFrameBytes(slot->key);
+    SimVencFill(slot);
+    slot->pts = pts;
+    slot->seq = g_venc.seq++;
+    g_venc.bytes += slot->len;
+    g_venc.head++;
+    if (g_venc.fd >= 0 && write(g_venc.fd, &one, sizeof(one)) != sizeof(one)) {
+        printf("[sim] venc fd write FAIL\n");
+    }
+    pthread_cond_broadcast(&g_venc.cond);
+UNLOCK:
+    pthread_mutex_unlock(&g_venc.lock);
+}
+
+HI_S32 HI_MPI_VENC_GetFd(VENC_CHN c)
+{
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    if (g_venc.fd < 0) {
+        g_venc.fd = eventfd(g_venc.head - g_venc.tail, EFD_NONBLOCK | EFD_SEMAPHORE);
+    }
+    pthread_mutex_unlock(&g_venc.lock);
+    return g_venc.fd;
+}
+
+HI_S32 HI_MPI_VENC_CloseFd(VENC_CHN c)
+{
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    if (g_venc.fd >= 0) {
+        close(g_venc.fd);
+        g_venc.fd = -1;
+    }
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VENC_QueryStatus(VENC_CHN c, VENC_CHN_STATUS_S *s)
+{
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    memset(s, 0, sizeof(*s));
+    pthread_mutex_lock(&g_venc.lock);
+    s->u32LeftStreamFrames = g_venc.head - g_venc.tail;
+    s->u32CurPacks = s->u32LeftStreamFrames > 0 ? 1 : 0;
+    s->u32LeftRecvPics = g_venc.recvLeft > 0 ? (HI_U32)g_venc.recvLeft : 0;
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VENC_GetStream(VENC_CHN c, VENC_STREAM_S *s, HI_S32 ms)
+{
+    struct timespec deadline;
+    const SimVencSlot *slot;
+    HI_U64 val;
+    HI_S32 ret = HI_SUCCESS;
+
+    if (c != 0 || s->pstPack == NULL || s->u32PackCount == 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    SimDeadline(&deadline, ms);
+    pthread_mutex_lock(&g_venc.lock);
+    while (g_venc.head == g_venc.tail) {
+        if (!SimCondWait(&g_venc.cond, &g_venc.lock, &deadline, ms)) {
+            ret = (HI_S32)SIM_ERR_TIMEOUT;
+            break;
+        }
+    }
+    if (ret == HI_SUCCESS) {
+        slot = &g_venc.slots[g_venc.tail % SIM_VENC_SLOT_NUM];
+        memset(&s->pstPack[0], 0, sizeof(s->pstPack[0]));
+        s->pstPack[0].u64PhyAddr = (HI_U64)(uintptr_t)slot->data;
+        s->pstPack[0].pu8Addr = slot->data;
+        s->pstPack[0].u32Len = slot->len;
+        s->pstPack[0].u64PTS = slot->pts;
+        s->pstPack[0].bFrameEnd = HI_TRUE;
+        if (g_venc.attr.stVencAttr.enType == PT_H264) {
+            s->pstPack[0].DataType.enH264EType = slot->key ? H264E_NALU_IDRSLICE : H264E_NALU_PSLICE;
+        } else if (g_venc.attr.stVencAttr.enType == PT_H265) {
+            s->pstPack[0].DataType.enH265EType = slot->key ? H265E_NALU_IDRSLICE : H265E_NALU_PSLICE;
+        } else {
+            s->pstPack[0].DataType.enJPEGEType = JPEGE_PACK_ECS;
+        }
+        s->u32PackCount = 1;
+        s->u32Seq = slot->seq;
+        if (g_venc.fd >= 0 && read(g_venc.fd, &val, sizeof(val)) != sizeof(val)) {
+            val = 0; // Nothing to take, the fd was opened after the stream was queued
+        }
+    }
+    pthread_mutex_unlock(&g_venc.lock);
+    return ret;
+}
+
+HI_S32 HI_MPI_VENC_ReleaseStream(VENC_CHN c, VENC_STREAM_S *s)
+{
+    HI_S32 ret = HI_SUCCESS;
+
+    pthread_mutex_lock(&g_venc.lock);
+    if (c != 0 || g_venc.head == g_venc.tail || g_venc.slots[g_venc.tail % SIM_VENC_SLOT_NUM].seq != s->u32Seq) {
+        ret = (HI_S32)SIM_ERR_PARAM;
+    } else {
+        g_venc.tail++;
+    }
+    pthread_mutex_unlock(&g_venc.lock);
+    return ret;
+}
+
+HI_S32 HI_MPI_VENC_StartRecvFrame(VENC_CHN c, const VENC_RECV_PIC_PARAM_S *p)
+{
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    g_venc.recvLeft = p->s32RecvPicNum;
+    g_venc.fpsAcc = 0;
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VENC_StopRecvFrame(VENC_CHN c)
+{
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    g_venc.recvLeft = 0;
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VENC_GetChnParam(VENC_CHN c, VENC_CHN_PARAM_S *p)
+{
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    *p = g_venc.param;
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VENC_SetChnParam(VENC_CHN c, const VENC_CHN_PARAM_S *p)
+{
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    g_venc.param = *p;
+    g_venc.fpsAcc = 0;
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VENC_GetJpegParam(VENC_CHN c, VENC_JPEG_PARAM_S *p)
+{
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    *p = g_venc.jpeg;
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VENC_SetJpegParam(VENC_CHN c, const VENC_JPEG_PARAM_S *p)
+{
+    if (c != 0 || p->u32Qfactor == 0 || p->u32Qfactor > 99) { // 99: JPEG QFactor range is [1, 99]
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    g_venc.jpeg = *p;
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VENC_GetChnAttr(VENC_CHN c, VENC_CHN_ATTR_S *p)
+{
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    *p = g_venc.attr;
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+/*
+ * 与VENC一致：最大尺寸创建后不可改，图像尺寸只能在停止接收时修改且不超过最大尺寸
+ * As VENC: the max size is fixed once created, the picture size may only change while not receiving
+ * and never beyond the max size
+ */
+HI_S32 HI_MPI_VENC_SetChnAttr(VENC_CHN c, const VENC_CHN_ATTR_S *p)
+{
+    const VENC_ATTR_S *cur = &g_venc.attr.stVencAttr;
+    const VENC_ATTR_S *a = &p->stVencAttr;
+    HI_S32 ret = HI_SUCCESS;
+
+    if (c != 0 || a->u32PicWidth > a->u32MaxPicWidth || a->u32PicHeight > a->u32MaxPicHeight) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    if (cur->u32MaxPicWidth != 0 &&
+        (a->u32MaxPicWidth != cur->u32MaxPicWidth || a->u32MaxPicHeight != cur->u32MaxPicHeight)) {
+        ret = (HI_S32)SIM_ERR_PARAM;
+    } else if (g_venc.recvLeft != 0 &&
+        (a->u32PicWidth != cur->u32PicWidth || a->u32PicHeight != cur->u32PicHeight)) {
+        ret = (HI_S32)SIM_ERR_PARAM;
+    } else {
+        g_venc.attr = *p;
+    }
+    pthread_mutex_unlock(&g_venc.lock);
+    return ret;
+}
+
+/* 丢弃尚未取走的码流 Drop the streams not taken yet */
+HI_S32 HI_MPI_VENC_ResetChn(VENC_CHN c)
+{
+    HI_U64 val;
+
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    while (g_venc.head != g_venc.tail) {
+        g_venc.tail++;
+        if (g_venc.fd >= 0 && read(g_venc.fd, &val, sizeof(val)) != sizeof(val)) {
+            printf("[sim] venc fd read FAIL\n");
+        }
+    }
+    g_venc.idrPending = HI_TRUE; // The stream restarts, H.264/H.265 with an IDR
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+/*
+ * 仿真只有一个VENC通道，创建即设置其属性，由帧率和码控决定码流
+ * The sim has a single VENC channel, creating it just sets its attributes, which shape the stream
+ */
+HI_S32 HI_MPI_VENC_CreateChn(VENC_CHN c, const VENC_CHN_ATTR_S *p)
+{
+    const VENC_ATTR_S *a = &p->stVencAttr;
+
+    if (c != 0 || a->u32PicWidth > a->u32MaxPicWidth || a->u32PicHeight > a->u32MaxPicHeight) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    g_venc.attr = *p;
+    memset(&g_venc.jpeg, 0, sizeof(g_venc.jpeg));
+    g_venc.gopPos = 0;
+    g_venc.idrPending = HI_TRUE;
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VENC_DestroyChn(VENC_CHN c)
+{
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    g_venc.recvLeft = 0;
+    memset(&g_venc.attr, 0, sizeof(g_venc.attr));
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VENC_RequestIDR(VENC_CHN c, HI_BOOL bInstant)
+{
+    (void)bInstant;
+    if (c != 0) {
+        return (HI_S32)SIM_ERR_PARAM;
+    }
+    pthread_mutex_lock(&g_venc.lock);
+    g_venc.idrPending = HI_TRUE;
+    pthread_mutex_unlock(&g_venc.lock);
+    return HI_SUCCESS;
+}
+
+/* ---------------------------------------------------------------- NNIE ---------------------------------------------------------------- */
+
+static int SimDetCmp(const void* a, const void* b)
+{
+    HI_U32 fa = ((const SimDet*)a)->frm;
+    HI_U32 fb = ((const SimDet*)b)->frm;
+    return fa < fb ? -1 : (fa > fb ? 1 : 0);
+}
+
+static void SimDetLoad(void)
+{
+    const char *path = getenv("SIM_DETS");
+    SimDet det;
+    FILE *fp;
+
+    if (path == NULL || g_nnie.dets != NULL) {
+        return;
+    }
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        printf("[sim] open detections %s FAIL, using the synthetic target\n", path);
+        return;
+    }
+    g_nnie.dets = malloc(sizeof(SimDet) * SIM_DET_MAX);
+    HI_ASSERT(g_nnie.dets);
+    while (g_nnie.detNum < SIM_DET_MAX && fscanf(fp, "%u %d %d %d %d", &det.frm,
+        &det.box.xmin, &det.box.ymin, &det.box.xmax, &det.box.ymax) == 5) { // 5: fields per line
+        g_nnie.dets[g_nnie.detNum++] = det;
+    }
+    fclose(fp);
+    qsort(g_nnie.dets, g_nnie.detNum, sizeof(SimDet), SimDetCmp);
+    printf("[sim] %u canned detections from %s\n", g_nnie.detNum, path);
+}
+
+/*
+ * 把相机坐标的框裁到窗口内并换算到图像坐标；框有一半以上在窗口外时视为检测不到
+ * Clip a box in camera pixels to the window and map it to image pixels;
+ * a box mostly outside the window is not detected
+ */
+static HI_BOOL SimBoxToImg(const RectBox* box, const SimFrmTag* win, const IVE_IMAGE_S* img, RectBox* out)
+{
+    double x0 = fmax(box->xmin, win->x);
+    double y0 = fmax(box->ymin, win->y);
+    double x1 = fmin(box->xmax, win->x + win->w);
+    double y1 = fmin(box->ymax, win->y + win->h);
+    double area = (double)(box->xmax - box->xmin) * (box->ymax - box->ymin);
+
+    if (x1 <= x0 || y1 <= y0 || (x1 - x0) * (y1 - y0) * 2 < area) { // 2: half of the box
+        return HI_FALSE;
+    }
+    out->xmin = (int)((x0 - win->x) * img->u32Width / win->w);
+    out->ymin = (int)((y0 - win->y) * img->u32Height / win->h);
+    out->xmax = (int)((x1 - win->x) * img->u32Width / win->w);
+    out->ymax = (int)((y1 - win->y) * img->u32Height / win->h);
+    return HI_TRUE;
+}
+
+int Yolo2Create(SAMPLE_SVP_NNIE_CFG_S **self, const char *model)
+{
+    printf("[sim] yolo2 model %s is not loaded, detections are canned\n", model);
+    g_nnie.yoloMs = MpiSimEnv("SIM_YOLO_MS", 25); // 25: about one NNIE YOLOv2 pass at 640x384
+    SimDetLoad();
+    *self = calloc(1, sizeof(SAMPLE_SVP_NNIE_CFG_S));
+    return *self == NULL ? HI_FAILURE : HI_SUCCESS;
+}
+
+void Yolo2Destory(SAMPLE_SVP_NNIE_CFG_S *self)
+{
+    free(self);
+}
+
+int Yolo2CalImg(SAMPLE_SVP_NNIE_CFG_S *self, const IVE_IMAGE_S *img, DetectObjInfo objs[], int objCap, int *objNum)
+{
+    SimFrmTag win;
+    RectBox box;
+    int num = 0;
+
+    (void)self;
+    *objNum = 0;
+    if (g_nnie.yoloMs > 0) {
+        usleep(g_nnie.yoloMs * 1000); // 1000: us per ms
+    }
+    __atomic_fetch_add(&g_nnie.calls, 1, __ATOMIC_RELAXED);
+    if (!SimTagOfView(img->au64VirAddr[0], img->u32Width, img->u32Height, &win)) {
+        return HI_SUCCESS; // Not a picture from the camera, nothing to find
+    }
+    if (g_nnie.dets == NULL) {
+        SimSceneBox(win.clipFrm, &box);
+        if (g_cam.clip == NULL && SimBoxToImg(&box, &win, img, &objs[0].box)) {
+            num = 1;
+        }
+    } else {
+        SimDet key = { win.clipFrm, { 0 } };
+        const SimDet *det = bsearch(&key, g_nnie.dets, g_nnie.detNum, sizeof(SimDet), SimDetCmp);
+        while (det != NULL && det > g_nnie.dets && det[-1].frm == win.clipFrm) {
+            det--;
+        }
+        for (; det != NULL && det < g_nnie.dets + g_nnie.detNum && det->frm == win.clipFrm && num < objCap; det++) {
+            num += SimBoxToImg(&det->box, &win, img, &objs[num].box) ? 1 : 0;
+        }
+    }
+    for (int i = 0; i < num; i++) {
+        objs[i].cls = 1; // 1: hand
+        objs[i].score = 0.9f; // 0.9: a confident detection
+    }
+    if (num > 0) {
+        __atomic_fetch_add(&g_nnie.hits, 1, __ATOMIC_RELAXED);
+    }
+    *objNum = num;
+    return HI_SUCCESS;
+}
+
+int CnnCreate(SAMPLE_SVP_NNIE_CFG_S **self, const char *model)
+{
+    printf("[sim] cnn model %s is not loaded, every hand is gesture 0\n", model);
+    *self = calloc(1, sizeof(SAMPLE_SVP_NNIE_CFG_S));
+    return *self == NULL ? HI_FAILURE : HI_SUCCESS;
+}
+
+void CnnDestroy(SAMPLE_SVP_NNIE_CFG_S *self)
+{
+    free(self);
+}
+
+int CnnCalImg(SAMPLE_SVP_NNIE_CFG_S *self, const IVE_IMAGE_S *img, RecogNumInfo res[], int resSize, int *resLen)
+{
+    (void)self;
+    (void)img;
+    *resLen = resSize > 0 ? 1 : 0;
+    if (resSize > 0) {
+        res[0].num = 0;
+        res[0].score = 900; // 900: 0.9 in the per mille score of the classifier
+    }
+    return HI_SUCCESS;
+}
+
+/* ---------------------------------------------------------------- 仿真控制 Simulation control ---------------------------------------------------------------- */
+
+HI_S32 MpiSimStart(void)
+{
+    if (SimCamOpen() != HI_SUCCESS) {
+        return HI_FAILURE;
+    }
+    g_venc.kb = MpiSimEnv("SIM_JPEG_KB", 40); // 40: a 800 x 700 JPEG at the default QFactor
+    g_venc.param.stFrameRate.s32SrcFrameRate = -1;
+    g_venc.param.stFrameRate.s32DstFrameRate = -1;
+    g_venc.slotSize = g_venc.kb * 1024 * 11 / 10 + 8; // 11/10: size jitter, 8: markers
+    g_venc.slotSize = g_venc.slotSize < SIM_VENC_SLOT_MIN ? SIM_VENC_SLOT_MIN : g_venc.slotSize;
+    for (HI_U32 i = 0; i < SIM_VENC_SLOT_NUM; i++) {
+        g_venc.slots[i].data = malloc(g_venc.slotSize);
+        HI_ASSERT(g_venc.slots[i].data);
+    }
+    g_cam.startUs = MpiSimNowUs();
+    g_cam.running = HI_TRUE;
+    if (pthread_create(&g_cam.thread, NULL, SimCamTrd, NULL) != 0) {
+        g_cam.running = HI_FALSE;
+        return HI_FAILURE;
+    }
+    return HI_SUCCESS;
+}
+
+void MpiSimStop(void)
+{
+    if (!g_cam.running) {
+        return;
+    }
+    __atomic_store_n(&g_cam.running, HI_FALSE, __ATOMIC_RELEASE);
+    pthread_join(g_cam.thread, NULL);
+    if (g_cam.clip != NULL) {
+        fclose(g_cam.clip);
+        g_cam.clip = NULL;
+    }
+}
+
+HI_U32 MpiSimYoloCalls(void)
+{
+    return __atomic_load_n(&g_nnie.calls, __ATOMIC_RELAXED);
+}
+
+HI_U32 MpiSimCamFrames(void)
+{
+    return __atomic_load_n(&g_cam.frmCnt, __ATOMIC_RELAXED);
+}
+
+void MpiSimReport(void)
+{
+    double sec = (double)(MpiSimNowUs() - g_cam.startUs) / US_PER_S;
+
+    sec = sec > 0 ? sec : 1;
+    printf("[sim] camera: %u frames in %.1f s (%.1f fps)\n", g_cam.frmCnt, sec, g_cam.frmCnt / sec);
+    for (HI_U32 i = 0; i < VPSS_MAX_PHY_CHN_NUM; i++) {
+        const SimVpssChn *chn = &g_vpss.chns[i];
+        if (chn->attr.u32Width != 0) {
+            printf("[sim] vpss chn %u %ux%u: taken %u dropped %u\n", i, chn->attr.u32Width, chn->attr.u32Height,
+                chn->outCnt, chn->dropCnt);
+        }
+    }
+    printf("[sim] venc: %u pictures (%u key) %.1f KB avg, dropped %u\n", g_venc.seq, g_venc.keyCnt,
+        g_venc.seq ? (double)g_venc.bytes / g_venc.seq / 1024 : 0.0, g_venc.dropCnt); // 1024: KB
+    printf("[sim] vgs: %u scale tasks, yolo: %u calls (%.1f/s), %u with a box\n", g_vgsCnt, g_nnie.calls,
+        g_nnie.calls / sec, g_nnie.hits);
+}
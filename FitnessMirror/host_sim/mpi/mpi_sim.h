@@ -0,0 +1,313 @@
+/*
+ * 海思MPI及样例库(sample_comm/NNIE/IVE/VGS/VENC/UART/GPIO)的主机端替身，只实现板端代码用到的接口。
+ * 图像来自录制的YUV420SP(NV21)片段或合成画面，检测结果来自预置文件，串口回环到一个舵机MCU模型，
+ * UDP走本机回环并由仿真网页端收帧，这样真实的线程、协议和PID代码可以在x86 Linux上跑通并测吞吐与延迟。
+ *
+ * Host stand-in for the HiSilicon MPI and sample libraries (sample_comm/NNIE/IVE/VGS/VENC/UART/GPIO),
+ * only the entry points the board code uses. Pictures come from a recorded YUV420SP (NV21) clip or a
+ * synthetic scene, detections from a canned file, the UART loops back to a servo MCU model and UDP goes
+ * over loopback to a simulated web receiver, so the real threads, protocol and PID code run on x86 Linux
+ * and can be measured for throughput and latency.
+ *
+ * 环境变量 Environment:
+ *   SIM_CLIP=path       NV21 clip, frames are read in order and the clip loops; unset: synthetic scene
+ *   SIM_CLIP_SIZE=WxH   Clip frame size, default 1920x1080
+ *   SIM_FPS=n           Camera frame rate, default 30
+ *   SIM_DETS=path       Canned detections, lines of "frame xmin ymin xmax ymax" in clip pixels;
+ *                       unset: one box following the synthetic target
+ *   SIM_YOLO_MS=n       Time one Yolo2CalImg takes, default 25
+ *   SIM_JPEG_KB=n       Size of one encoded picture, default 40
+ *   SIM_RUN_S=n         Press Enter for the app after n seconds; unset: wait for the real Enter key
+ *   SIM_FB_LOSS=n       Percent of frames the simulated relay reports lost, default 0
+ *   SIM_FB_LOSS_S=n     Report that loss for the first n seconds only; unset: for the whole run
+ *   SIM_FB_RTT_US=n     Round trip time in the relay reports, default 2000
+ * 回归门限，非0时在定时运行结束时检查，不满足则以1退出 Regression limits, checked at the end of a timed run when
+ * not 0, the process exits with 1 when one is missed:
+ *   SIM_CHECK_SENT_PCT=n      Minimum frames received by the web end, percent of camera frames
+ *   SIM_CHECK_YOLO_MIN_PCT=n  Minimum Yolo2CalImg calls, percent of camera frames
+ *   SIM_CHECK_YOLO_MAX_PCT=n  Maximum Yolo2CalImg calls, percent of camera frames
+ *   SIM_CHECK_ACK_PCT=n       Minimum MCU ACKs, percent of the setpoints sent
+ *   SIM_CHECK_P50_MS=n        Maximum end to end latency p50
+ *   SIM_CHECK_P99_MS=n        Maximum end to end latency p99
+ */
+#ifndef MPI_SIM_H
+#define MPI_SIM_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stddef.h>
+
+typedef unsigned char HI_U8; typedef unsigned short HI_U16; typedef unsigned int HI_U32;
+typedef unsigned long long HI_U64; typedef signed char HI_S8; typedef short HI_S16; typedef int HI_S32;
+typedef long long HI_S64; typedef char HI_CHAR; typedef float HI_FLOAT; typedef double HI_DOUBLE;
+#define HI_VOID void
+typedef enum { HI_FALSE = 0, HI_TRUE = 1 } HI_BOOL;
+#define HI_NULL 0L
+#define HI_SUCCESS 0
+#define HI_FAILURE (-1)
+#define EOK 0
+#define HI_ASSERT(x) assert(x)
+#define HI_ALIGN_DOWN(x, a) ((x) / (a) * (a))
+#define HI_ALIGN_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+static inline int memset_s(void *d, size_t dm, int c, size_t n) { if (n > dm) return -1; memset(d, c, n); return 0; }
+static inline int memcpy_s(void *d, size_t dm, const void *s, size_t n) { if (n > dm) return -1; memcpy(d, s, n); return 0; }
+
+typedef HI_S32 VI_PIPE; typedef HI_S32 VI_CHN; typedef HI_S32 VI_DEV; typedef HI_S32 VPSS_GRP; typedef HI_S32 VPSS_CHN;
+typedef HI_S32 VENC_CHN; typedef HI_S32 VDEC_CHN; typedef HI_S32 VO_DEV; typedef HI_S32 VO_LAYER; typedef HI_S32 VO_CHN;
+typedef HI_S32 VB_POOL; typedef HI_U32 VB_BLK; typedef HI_S32 VGS_HANDLE; typedef HI_S32 IVE_HANDLE;
+#define VB_INVALID_POOLID (-1U)
+#define VB_INVALID_HANDLE (-1U)
+#define VPSS_MAX_PHY_CHN_NUM 3
+#define MAX_MMZ_NAME_LEN 32
+
+typedef enum { HI_ID_VB = 1, HI_ID_SYS, HI_ID_VI, HI_ID_VPSS, HI_ID_VENC, HI_ID_VGS, HI_ID_VO, HI_ID_IVE } MOD_ID_E;
+typedef struct { MOD_ID_E enModId; HI_S32 s32DevId; HI_S32 s32ChnId; } MPP_CHN_S;
+typedef struct { HI_U32 u32Width; HI_U32 u32Height; } SIZE_S;
+typedef struct { HI_S32 s32X; HI_S32 s32Y; HI_U32 u32Width; HI_U32 u32Height; } RECT_S;
+typedef struct { HI_S32 s32SrcFrameRate; HI_S32 s32DstFrameRate; } FRAME_RATE_CTRL_S;
+
+typedef enum { PIXEL_FORMAT_RGB_BAYER_16BPP = 1, PIXEL_FORMAT_YVU_SEMIPLANAR_420 = 23, PIXEL_FORMAT_YUV_400, PIXEL_FORMAT_BUTT } PIXEL_FORMAT_E;
+typedef enum { VIDEO_FORMAT_LINEAR = 0, VIDEO_FORMAT_TILE_64x16, VIDEO_FORMAT_BUTT } VIDEO_FORMAT_E;
+typedef enum { COMPRESS_MODE_NONE = 0, COMPRESS_MODE_SEG, COMPRESS_MODE_TILE, COMPRESS_MODE_LINE, COMPRESS_MODE_FRAME, COMPRESS_MODE_BUTT } COMPRESS_MODE_E;
+typedef enum { DYNAMIC_RANGE_SDR8 = 0, DYNAMIC_RANGE_SDR10, DYNAMIC_RANGE_BUTT } DYNAMIC_RANGE_E;
+typedef enum { WDR_MODE_NONE = 0, WDR_MODE_BUTT } WDR_MODE_E;
+typedef enum { VIDEO_FIELD_FRAME = 3 } VIDEO_FIELD_E;
+typedef enum { COLOR_GAMUT_BT709 = 1 } COLOR_GAMUT_E;
+typedef enum { DATA_BITWIDTH_8 = 0 } DATA_BITWIDTH_E;
+typedef enum { ASPECT_RATIO_NONE = 0 } ASPECT_RATIO_E;
+typedef enum { PIC_CIF, PIC_360P, PIC_720P, PIC_1080P, PIC_BUTT } PIC_SIZE_E;
+typedef enum { ROTATION_0 = 0, ROTATION_90, ROTATION_180, ROTATION_270 } ROTATION_E;
+typedef enum { PT_H264 = 96, PT_H265 = 265, PT_JPEG = 26, PT_MJPEG = 1002 } PAYLOAD_TYPE_E;
+#define SAMPLE_PIXEL_FORMAT PIXEL_FORMAT_YVU_SEMIPLANAR_420
+#define DEFAULT_ALIGN 32
+
+typedef struct {
+    HI_U32 u32Width; HI_U32 u32Height; VIDEO_FIELD_E enField; PIXEL_FORMAT_E enPixelFormat;
+    VIDEO_FORMAT_E enVideoFormat; COMPRESS_MODE_E enCompressMode; DYNAMIC_RANGE_E enDynamicRange;
+    COLOR_GAMUT_E enColorGamut; HI_U32 u32HeaderStride[3]; HI_U32 u32Stride[3]; HI_U32 u32ExtStride[3];
+    HI_U64 u64HeaderPhyAddr[3]; HI_U64 u64HeaderVirAddr[3]; HI_U64 u64PhyAddr[3]; HI_U64 u64VirAddr[3];
+    HI_U64 u64ExtPhyAddr[3]; HI_U64 u64ExtVirAddr[3]; HI_S16 s16OffsetTop; HI_S16 s16OffsetBottom;
+    HI_S16 s16OffsetLeft; HI_S16 s16OffsetRight; HI_U32 u32MaxLuminance; HI_U32 u32MinLuminance;
+    HI_U32 u32TimeRef; HI_U64 u64PTS; HI_U64 u64PrivateData; HI_U32 u32FrameFlag;
+} VIDEO_FRAME_S;
+typedef struct { VIDEO_FRAME_S stVFrame; HI_U32 u32PoolId; MOD_ID_E enModId; } VIDEO_FRAME_INFO_S;
+
+/* VB / SYS */
+typedef enum { VB_REMAP_MODE_NONE = 0, VB_REMAP_MODE_NOCACHE, VB_REMAP_MODE_CACHED } VB_REMAP_MODE_E;
+typedef struct { HI_U64 u64BlkSize; HI_U32 u32BlkCnt; VB_REMAP_MODE_E enRemapMode; HI_CHAR acMmzName[MAX_MMZ_NAME_LEN]; } VB_POOL_CONFIG_S;
+typedef struct { HI_U32 u32MaxPoolCnt; VB_POOL_CONFIG_S astCommPool[16]; } VB_CONFIG_S;
+HI_S32 HI_MPI_SYS_Exit(void); HI_S32 HI_MPI_VB_Exit(void);
+HI_S32 HI_MPI_SYS_Bind(const MPP_CHN_S *src, const MPP_CHN_S *dst);
+HI_S32 HI_MPI_SYS_UnBind(const MPP_CHN_S *src, const MPP_CHN_S *dst);
+HI_S32 HI_MPI_SYS_GetCurPTS(HI_U64 *pu64CurPTS);
+void *HI_MPI_SYS_Mmap(HI_U64 u64PhyAddr, HI_U32 u32Size);
+HI_S32 HI_MPI_SYS_Munmap(void *pVirAddr, HI_U32 u32Size);
+HI_S32 HI_MPI_SYS_MmzAlloc(HI_U64 *pu64PhyAddr, HI_VOID **ppVirAddr, const HI_CHAR *strMmb, const HI_CHAR *strZone, HI_U32 u32Len);
+HI_S32 HI_MPI_SYS_MmzFree(HI_U64 u64PhyAddr, HI_VOID *pVirAddr);
+VB_POOL HI_MPI_VB_CreatePool(VB_POOL_CONFIG_S *pstVbPoolCfg);
+HI_S32 HI_MPI_VB_DestroyPool(VB_POOL Pool);
+VB_BLK HI_MPI_VB_GetBlock(VB_POOL Pool, HI_U64 u64BlkSize, const HI_CHAR *pcMmzName);
+HI_S32 HI_MPI_VB_ReleaseBlock(VB_BLK Block);
+HI_U64 HI_MPI_VB_Handle2PhysAddr(VB_BLK Block);
+VB_POOL HI_MPI_VB_Handle2PoolId(VB_BLK Block);
+VB_BLK HI_MPI_VB_PhysAddr2Handle(HI_U64 u64PhyAddr);
+HI_S32 HI_MPI_VB_MmapPool(VB_POOL Pool);
+HI_S32 HI_MPI_VB_MunmapPool(VB_POOL Pool);
+HI_S32 HI_MPI_VB_GetBlockVirAddr(VB_POOL Pool, HI_U64 u64PhyAddr, HI_VOID **ppVirAddr);
+HI_U32 COMMON_GetPicBufferSize(HI_U32 w, HI_U32 h, PIXEL_FORMAT_E f, DATA_BITWIDTH_E b, COMPRESS_MODE_E c, HI_U32 a);
+HI_U32 VI_GetRawBufferSize(HI_U32 w, HI_U32 h, PIXEL_FORMAT_E f, COMPRESS_MODE_E c, HI_U32 a);
+
+/* VPSS */
+typedef enum { VPSS_CHN_MODE_USER = 0, VPSS_CHN_MODE_AUTO } VPSS_CHN_MODE_E;
+typedef struct { ASPECT_RATIO_E enMode; HI_U32 u32BgColor; RECT_S stVideoRect; } ASPECT_RATIO_S;
+typedef struct { HI_U32 u32MaxW; HI_U32 u32MaxH; PIXEL_FORMAT_E enPixelFormat; DYNAMIC_RANGE_E enDynamicRange; FRAME_RATE_CTRL_S stFrameRate; HI_BOOL bNrEn; } VPSS_GRP_ATTR_S;
+typedef struct { VPSS_CHN_MODE_E enChnMode; HI_U32 u32Width; HI_U32 u32Height; VIDEO_FORMAT_E enVideoFormat; PIXEL_FORMAT_E enPixelFormat; DYNAMIC_RANGE_E enDynamicRange; COMPRESS_MODE_E enCompressMode; FRAME_RATE_CTRL_S stFrameRate; HI_BOOL bMirror; HI_BOOL bFlip; HI_U32 u32Depth; ASPECT_RATIO_S stAspectRatio; } VPSS_CHN_ATTR_S;
+typedef enum { VPSS_CROP_RATIO_COOR = 0, VPSS_CROP_ABS_COOR } VPSS_CROP_COORDINATE_E;
+typedef struct { HI_BOOL bEnable; VPSS_CROP_COORDINATE_E enCropCoordinate; RECT_S stCropRect; } VPSS_CROP_INFO_S;
+typedef struct { HI_BOOL bEnable; } VPSS_LDC_ATTR_S;
+HI_S32 HI_MPI_VPSS_CreateGrp(VPSS_GRP g, const VPSS_GRP_ATTR_S *a); HI_S32 HI_MPI_VPSS_DestroyGrp(VPSS_GRP g);
+HI_S32 HI_MPI_VPSS_StartGrp(VPSS_GRP g); HI_S32 HI_MPI_VPSS_StopGrp(VPSS_GRP g);
+HI_S32 HI_MPI_VPSS_SetChnAttr(VPSS_GRP g, VPSS_CHN c, const VPSS_CHN_ATTR_S *a);
+HI_S32 HI_MPI_VPSS_GetChnAttr(VPSS_GRP g, VPSS_CHN c, VPSS_CHN_ATTR_S *a);
+HI_S32 HI_MPI_VPSS_EnableChn(VPSS_GRP g, VPSS_CHN c); HI_S32 HI_MPI_VPSS_DisableChn(VPSS_GRP g, VPSS_CHN c);
+HI_S32 HI_MPI_VPSS_GetChnFrame(VPSS_GRP g, VPSS_CHN c, VIDEO_FRAME_INFO_S *f, HI_S32 ms);
+HI_S32 HI_MPI_VPSS_ReleaseChnFrame(VPSS_GRP g, VPSS_CHN c, const VIDEO_FRAME_INFO_S *f);
+HI_S32 HI_MPI_VPSS_SetChnCrop(VPSS_GRP g, VPSS_CHN c, const VPSS_CROP_INFO_S *p);
+HI_S32 HI_MPI_VPSS_GetChnFd(VPSS_GRP g, VPSS_CHN c);
+
+/* VENC */
+typedef enum { H264E_NALU_BSLICE = 0, H264E_NALU_PSLICE = 1, H264E_NALU_ISLICE = 2, H264E_NALU_IDRSLICE = 5, H264E_NALU_SEI = 6, H264E_NALU_SPS = 7, H264E_NALU_PPS = 8 } H264E_NALU_TYPE_E;
+typedef enum { H265E_NALU_BSLICE = 0, H265E_NALU_PSLICE = 1, H265E_NALU_ISLICE = 2, H265E_NALU_IDRSLICE = 19, H265E_NALU_VPS = 32, H265E_NALU_SPS = 33, H265E_NALU_PPS = 34, H265E_NALU_SEI = 39 } H265E_NALU_TYPE_E;
+typedef enum { JPEGE_PACK_ECS = 5, JPEGE_PACK_APP = 6 } JPEGE_PACK_TYPE_E;
+typedef union { H264E_NALU_TYPE_E enH264EType; JPEGE_PACK_TYPE_E enJPEGEType; H265E_NALU_TYPE_E enH265EType; } VENC_DATA_TYPE_U;
+typedef struct { VENC_DATA_TYPE_U u32PackType; HI_U32 u32PackOffset; HI_U32 u32PackLength; } VENC_PACK_INFO_S;
+typedef struct { HI_U64 u64PhyAddr; HI_U8 *pu8Addr; HI_U32 u32Len; HI_U64 u64PTS; HI_BOOL bFrameEnd; VENC_DATA_TYPE_U DataType; HI_U32 u32Offset; HI_U32 u32DataNum; VENC_PACK_INFO_S stPackInfo[8]; } VENC_PACK_S;
+typedef struct { VENC_PACK_S *pstPack; HI_U32 u32PackCount; HI_U32 u32Seq; } VENC_STREAM_S;
+typedef struct { HI_U32 u32LeftPics; HI_U32 u32LeftStreamBytes; HI_U32 u32LeftStreamFrames; HI_U32 u32CurPacks; HI_U32 u32LeftRecvPics; HI_U32 u32LeftEncPics; } VENC_CHN_STATUS_S;
+typedef struct { HI_S32 s32RecvPicNum; } VENC_RECV_PIC_PARAM_S;
+typedef struct { HI_BOOL bEnable; RECT_S stRect; } VENC_CROP_INFO_S;
+typedef struct { HI_BOOL bColorToGrey; HI_U32 u32Priority; HI_U32 u32MaxStrmCnt; HI_U32 u32PollWakeUpFrmCnt; VENC_CROP_INFO_S stCropCfg; FRAME_RATE_CTRL_S stFrameRate; } VENC_CHN_PARAM_S;
+typedef struct { HI_U32 u32Qfactor; HI_U8 au8YQt[64]; HI_U8 au8CbQt[64]; HI_U8 au8CrQt[64]; HI_U32 u32MCUPerECS; } VENC_JPEG_PARAM_S;
+typedef enum { VENC_RC_MODE_H264CBR = 1, VENC_RC_MODE_H265CBR = 11, VENC_RC_MODE_MJPEGCBR = 6 } VENC_RC_MODE_E;
+typedef struct { HI_U32 u32Gop; HI_U32 u32StatTime; HI_U32 u32SrcFrameRate; HI_U32 fr32DstFrameRate; HI_U32 u32BitRate; } VENC_H264_CBR_S;
+typedef VENC_H264_CBR_S VENC_H265_CBR_S;
+typedef struct { VENC_RC_MODE_E enRcMode; union { VENC_H264_CBR_S stH264Cbr; VENC_H265_CBR_S stH265Cbr; }; } VENC_RC_ATTR_S;
+typedef struct { PAYLOAD_TYPE_E enType; HI_U32 u32MaxPicWidth; HI_U32 u32MaxPicHeight; HI_U32 u32BufSize; HI_U32 u32Profile; HI_BOOL bByFrame; HI_U32 u32PicWidth; HI_U32 u32PicHeight; } VENC_ATTR_S;
+typedef enum { VENC_GOPMODE_NORMALP = 0, VENC_GOPMODE_DUALP, VENC_GOPMODE_SMARTP } VENC_GOP_MODE_E;
+typedef struct { HI_S32 s32IPQpDelta; } VENC_GOP_NORMALP_S;
+typedef struct { VENC_GOP_MODE_E enGopMode; union { VENC_GOP_NORMALP_S stNormalP; }; } VENC_GOP_ATTR_S;
+typedef struct { VENC_ATTR_S stVencAttr; VENC_RC_ATTR_S stRcAttr; VENC_GOP_ATTR_S stGopAttr; } VENC_CHN_ATTR_S;
+HI_S32 HI_MPI_VENC_CreateChn(VENC_CHN c, const VENC_CHN_ATTR_S *p); HI_S32 HI_MPI_VENC_DestroyChn(VENC_CHN c);
+HI_S32 HI_MPI_VENC_GetFd(VENC_CHN c); HI_S32 HI_MPI_VENC_CloseFd(VENC_CHN c);
+HI_S32 HI_MPI_VENC_QueryStatus(VENC_CHN c, VENC_CHN_STATUS_S *s);
+HI_S32 HI_MPI_VENC_GetStream(VENC_CHN c, VENC_STREAM_S *s, HI_S32 ms);
+HI_S32 HI_MPI_VENC_ReleaseStream(VENC_CHN c, VENC_STREAM_S *s);
+HI_S32 HI_MPI_VENC_StartRecvFrame(VENC_CHN c, const VENC_RECV_PIC_PARAM_S *p);
+HI_S32 HI_MPI_VENC_StopRecvFrame(VENC_CHN c);
+HI_S32 HI_MPI_VENC_GetChnParam(VENC_CHN c, VENC_CHN_PARAM_S *p); HI_S32 HI_MPI_VENC_SetChnParam(VENC_CHN c, const VENC_CHN_PARAM_S *p);
+HI_S32 HI_MPI_VENC_GetJpegParam(VENC_CHN c, VENC_JPEG_PARAM_S *p); HI_S32 HI_MPI_VENC_SetJpegParam(VENC_CHN c, const VENC_JPEG_PARAM_S *p);
+HI_S32 HI_MPI_VENC_GetChnAttr(VENC_CHN c, VENC_CHN_ATTR_S *p); HI_S32 HI_MPI_VENC_SetChnAttr(VENC_CHN c, const VENC_CHN_ATTR_S *p);
+HI_S32 HI_MPI_VENC_ResetChn(VENC_CHN c);
+HI_S32 HI_MPI_VENC_RequestIDR(VENC_CHN c, HI_BOOL bInstant);
+
+/* VGS */
+typedef struct { VIDEO_FRAME_INFO_S stImgIn; VIDEO_FRAME_INFO_S stImgOut; HI_U64 au64PrivateData[4]; HI_U32 reserved; } VGS_TASK_ATTR_S;
+typedef enum { VGS_SCLCOEF_NORMAL = 0 } VGS_SCLCOEF_MODE_E;
+HI_S32 HI_MPI_VGS_BeginJob(VGS_HANDLE *h); HI_S32 HI_MPI_VGS_EndJob(VGS_HANDLE h); HI_S32 HI_MPI_VGS_CancelJob(VGS_HANDLE h);
+HI_S32 HI_MPI_VGS_AddScaleTask(VGS_HANDLE h, const VGS_TASK_ATTR_S *t, VGS_SCLCOEF_MODE_E m);
+
+/* IVE */
+typedef enum { IVE_IMAGE_TYPE_U8C1 = 0, IVE_IMAGE_TYPE_YUV420SP = 3, IVE_IMAGE_TYPE_U16C1 = 9 } IVE_IMAGE_TYPE_E;
+typedef struct { HI_U64 au64PhyAddr[3]; HI_U64 au64VirAddr[3]; HI_U32 au32Stride[3]; HI_U32 u32Width; HI_U32 u32Height; IVE_IMAGE_TYPE_E enType; } IVE_IMAGE_S;
+typedef IVE_IMAGE_S IVE_SRC_IMAGE_S; typedef IVE_IMAGE_S IVE_DST_IMAGE_S;
+typedef struct { HI_U64 u64PhyAddr; HI_U64 u64VirAddr; HI_U32 u32Stride; HI_U32 u32Width; HI_U32 u32Height; HI_U32 u32Reserved; } IVE_DATA_S;
+typedef IVE_DATA_S IVE_SRC_DATA_S; typedef IVE_DATA_S IVE_DST_DATA_S;
+typedef enum { IVE_DMA_MODE_DIRECT_COPY = 0 } IVE_DMA_MODE_E;
+typedef struct { IVE_DMA_MODE_E enMode; HI_U64 u64Val; HI_U8 u8HorSegSize; HI_U8 u8ElemSize; HI_U8 u8VerSegRows; } IVE_DMA_CTRL_S;
+typedef enum { IVE_SAD_MODE_MB_4X4 = 0, IVE_SAD_MODE_MB_8X8, IVE_SAD_MODE_MB_16X16 } IVE_SAD_MODE_E;
+typedef enum { IVE_SAD_OUT_CTRL_16BIT_BOTH = 0, IVE_SAD_OUT_CTRL_8BIT_BOTH, IVE_SAD_OUT_CTRL_16BIT_SAD, IVE_SAD_OUT_CTRL_8BIT_SAD, IVE_SAD_OUT_CTRL_THRESH } IVE_SAD_OUT_CTRL_E;
+typedef struct { IVE_SAD_MODE_E enMode; IVE_SAD_OUT_CTRL_E enOutCtrl; HI_U16 u16Thr; HI_U8 u8MinVal; HI_U8 u8MaxVal; } IVE_SAD_CTRL_S;
+HI_S32 HI_MPI_IVE_DMA(IVE_HANDLE *h, IVE_DATA_S *src, IVE_DST_DATA_S *dst, IVE_DMA_CTRL_S *c, HI_BOOL bInstant);
+HI_S32 HI_MPI_IVE_SAD(IVE_HANDLE *h, IVE_SRC_IMAGE_S *s1, IVE_SRC_IMAGE_S *s2, IVE_DST_IMAGE_S *sad, IVE_DST_IMAGE_S *thr, IVE_SAD_CTRL_S *c, HI_BOOL bInstant);
+HI_S32 HI_MPI_IVE_Query(IVE_HANDLE h, HI_BOOL *pbFinish, HI_BOOL bBlock);
+#define HI_ERR_IVE_QUERY_TIMEOUT ((HI_S32)0xA01D8027) // HI_DEF_ERR yields HI_S32, like HI_MPI_IVE_Query
+#define HI_ERR_IVE_SYS_TIMEOUT ((HI_S32)0xA01D8041)
+
+/* ISP / VI */
+typedef struct { HI_U32 u32StatIntvl; } ISP_CTRL_PARAM_S;
+HI_S32 HI_MPI_ISP_GetCtrlParam(VI_PIPE p, ISP_CTRL_PARAM_S *c); HI_S32 HI_MPI_ISP_SetCtrlParam(VI_PIPE p, const ISP_CTRL_PARAM_S *c);
+typedef enum { SONY_IMX335_MIPI_4M_30FPS_12BIT = 0, SAMPLE_SNS_TYPE_BUTT } SAMPLE_SNS_TYPE_E;
+typedef struct { SAMPLE_SNS_TYPE_E enSnsType; HI_S32 s32SnsId; HI_S32 s32BusId; HI_S32 MipiDev; } SAMPLE_SENSOR_INFO_S;
+typedef struct { VI_DEV ViDev; WDR_MODE_E enWDRMode; } SAMPLE_DEV_INFO_S;
+typedef struct { VI_PIPE aPipe[4]; HI_S32 enMastPipeMode; HI_BOOL bMultiPipe; } SAMPLE_PIPE_INFO_S;
+typedef struct { VI_CHN ViChn; PIXEL_FORMAT_E enPixFormat; DYNAMIC_RANGE_E enDynamicRange; VIDEO_FORMAT_E enVideoFormat; COMPRESS_MODE_E enCompressMode; } SAMPLE_CHN_INFO_S;
+typedef struct { SAMPLE_SENSOR_INFO_S stSnsInfo; SAMPLE_DEV_INFO_S stDevInfo; SAMPLE_PIPE_INFO_S stPipeInfo; SAMPLE_CHN_INFO_S stChnInfo; } SAMPLE_VI_INFO_S;
+typedef struct { SAMPLE_VI_INFO_S astViInfo[4]; HI_S32 as32WorkingViId[4]; HI_S32 s32WorkingViNum; } SAMPLE_VI_CONFIG_S;
+
+/* VO */
+typedef enum { VO_INTF_MIPI = 0x4000 } VO_INTF_TYPE_E;
+typedef enum { VO_OUTPUT_1080P24 = 0, VO_OUTPUT_1080P25, VO_OUTPUT_1080P30, VO_OUTPUT_720P50, VO_OUTPUT_720P60, VO_OUTPUT_1080P50, VO_OUTPUT_1080P60, VO_OUTPUT_USER } VO_INTF_SYNC_E;
+typedef enum { VO_MODE_1MUX, VO_MODE_2MUX, VO_MODE_4MUX, VO_MODE_8MUX, VO_MODE_9MUX, VO_MODE_16MUX, VO_MODE_25MUX, VO_MODE_36MUX, VO_MODE_49MUX, VO_MODE_64MUX, VO_MODE_2X4, VO_MODE_BUTT } SAMPLE_VO_MODE_E;
+typedef enum { VO_PART_MODE_SINGLE = 0, VO_PART_MODE_MULTI } VO_PART_MODE_E;
+typedef enum { VO_CLK_SOURCE_PLL = 0 } VO_CLK_SOURCE_E;
+typedef enum { VO_CSC_MATRIX_BT709_TO_RGB_PC = 5 } VO_CSC_MATRIX_E;
+typedef struct { HI_BOOL bSynm; HI_BOOL bIop; HI_U8 u8Intfb; HI_U16 u16Vact; HI_U16 u16Vbb; HI_U16 u16Vfb; HI_U16 u16Hact; HI_U16 u16Hbb; HI_U16 u16Hfb; HI_U16 u16Hmid; HI_U16 u16Bvact; HI_U16 u16Bvbb; HI_U16 u16Bvfb; HI_U16 u16Hpw; HI_U16 u16Vpw; HI_BOOL bIdv; HI_BOOL bIhs; HI_BOOL bIvs; } VO_SYNC_INFO_S;
+typedef struct { HI_U32 u32BgColor; VO_INTF_TYPE_E enIntfType; VO_INTF_SYNC_E enIntfSync; VO_SYNC_INFO_S stSyncInfo; } VO_PUB_ATTR_S;
+typedef struct { HI_U32 u32Fbdiv; HI_U32 u32Frac; HI_U32 u32Refdiv; HI_U32 u32Postdiv1; HI_U32 u32Postdiv2; } VO_PLL_S;
+typedef struct { VO_CLK_SOURCE_E enClkSource; VO_PLL_S stUserSyncPll; } VO_USER_INTFSYNC_ATTR_S;
+typedef struct { VO_USER_INTFSYNC_ATTR_S stUserIntfSyncAttr; HI_U32 u32PreDiv; HI_U32 u32DevDiv; HI_BOOL bClkReverse; } VO_USER_INTFSYNC_INFO_S;
+typedef struct { RECT_S stDispRect; SIZE_S stImageSize; HI_U32 u32DispFrmRt; PIXEL_FORMAT_E enPixFormat; HI_BOOL bDoubleFrame; HI_BOOL bClusterMode; DYNAMIC_RANGE_E enDstDynamicRange; } VO_VIDEO_LAYER_ATTR_S;
+typedef struct { VO_CSC_MATRIX_E enCscMatrix; HI_U32 u32Luma; HI_U32 u32Contrast; HI_U32 u32Hue; HI_U32 u32Satuature; } VO_CSC_S;
+typedef struct { HI_U32 u32Priority; RECT_S stRect; HI_BOOL bDeflicker; } VO_CHN_ATTR_S;
+typedef struct { VO_DEV VoDev; VO_INTF_TYPE_E enVoIntfType; VO_INTF_SYNC_E enIntfSync; PIC_SIZE_E enPicSize; HI_U32 u32BgColor; PIXEL_FORMAT_E enPixFormat; RECT_S stDispRect; SIZE_S stImageSize; VO_PART_MODE_E enVoPartMode; HI_U32 u32DisBufLen; DYNAMIC_RANGE_E enDstDynamicRange; SAMPLE_VO_MODE_E enVoMode; } SAMPLE_VO_CONFIG_S;
+HI_S32 HI_MPI_VO_Enable(VO_DEV d); HI_S32 HI_MPI_VO_SetPubAttr(VO_DEV d, const VO_PUB_ATTR_S *a);
+HI_S32 HI_MPI_VO_SetDevFrameRate(VO_DEV d, HI_U32 f); HI_S32 HI_MPI_VO_SetUserIntfSyncInfo(VO_DEV d, VO_USER_INTFSYNC_INFO_S *i);
+HI_S32 HI_MPI_VO_GetVideoLayerAttr(VO_LAYER l, VO_VIDEO_LAYER_ATTR_S *a);
+HI_S32 HI_MPI_VO_SetChnAttr(VO_LAYER l, VO_CHN c, const VO_CHN_ATTR_S *a);
+HI_S32 HI_MPI_VO_SetChnRotation(VO_LAYER l, VO_CHN c, ROTATION_E r); HI_S32 HI_MPI_VO_EnableChn(VO_LAYER l, VO_CHN c);
+HI_S32 HI_MPI_VO_SetDisplayBufLen(VO_LAYER l, HI_U32 n); HI_S32 HI_MPI_VO_SetVideoLayerPartitionMode(VO_LAYER l, VO_PART_MODE_E m);
+HI_S32 HI_MPI_VO_GetVideoLayerCSC(VO_LAYER l, VO_CSC_S *c); HI_S32 HI_MPI_VO_SetVideoLayerCSC(VO_LAYER l, const VO_CSC_S *c);
+HI_S32 HI_MPI_VO_SendFrame(VO_LAYER l, VO_CHN c, VIDEO_FRAME_INFO_S *f, HI_S32 ms);
+
+/* MIPI TX */
+typedef enum { OUTPUT_MODE_DSI_VIDEO = 1 } output_mode_t;
+typedef enum { OUT_FORMAT_RGB_24_BIT = 3 } output_format_t;
+typedef enum { BURST_MODE = 2 } video_mode_t;
+typedef struct { unsigned short vid_pkt_size, vid_hsa_pixels, vid_hbp_pixels, vid_hline_pixels, vid_vsa_lines, vid_vbp_lines, vid_vfp_lines, vid_active_lines, edpi_cmd_size; } sync_info_t;
+typedef struct { unsigned int devno; short lane_id[4]; output_mode_t output_mode; video_mode_t video_mode; output_format_t output_format; sync_info_t sync_info; unsigned int phy_data_rate; unsigned int pixel_clk; } combo_dev_cfg_t;
+typedef struct { unsigned int devno; unsigned short data_type; unsigned short cmd_size; unsigned char *cmd; } cmd_info_t;
+#define HI_MIPI_TX_SET_DEV_CFG 0x4d01
+#define HI_MIPI_TX_SET_CMD 0x4d02
+#define HI_MIPI_TX_ENABLE 0x4d03
+#define HI_MIPI_TX_DISABLE 0x4d04
+
+/* sample_comm */
+typedef enum { SAMPLE_RC_CBR = 0, SAMPLE_RC_VBR, SAMPLE_RC_AVBR, SAMPLE_RC_QVBR, SAMPLE_RC_CVBR, SAMPLE_RC_QPMAP, SAMPLE_RC_FIXQP } SAMPLE_RC_E;
+#define SAMPLE_CHECK_EXPR_GOTO(expr, label, ...) do { if (expr) { printf(__VA_ARGS__); goto label; } } while (0)
+#define SAMPLE_CHECK_EXPR_RET(expr, ret, ...) do { if (expr) { printf(__VA_ARGS__); return (ret); } } while (0)
+HI_S32 SAMPLE_COMM_SYS_Init(VB_CONFIG_S *c); HI_VOID SAMPLE_COMM_SYS_Exit(void);
+HI_S32 SAMPLE_COMM_SYS_GetPicSize(PIC_SIZE_E e, SIZE_S *s);
+HI_S32 SAMPLE_COMM_VI_GetSizeBySensor(SAMPLE_SNS_TYPE_E t, PIC_SIZE_E *p);
+HI_VOID SAMPLE_COMM_VI_GetSensorInfo(SAMPLE_VI_CONFIG_S *c);
+HI_S32 SAMPLE_COMM_VI_GetComboDevBySensor(SAMPLE_SNS_TYPE_E t, HI_S32 i);
+HI_S32 SAMPLE_COMM_VI_GetFrameRateBySensor(SAMPLE_SNS_TYPE_E t, HI_U32 *f);
+HI_S32 SAMPLE_COMM_VI_SetParam(SAMPLE_VI_CONFIG_S *c); HI_S32 SAMPLE_COMM_VI_StartVi(SAMPLE_VI_CONFIG_S *c);
+HI_S32 SAMPLE_COMM_VI_StopVi(SAMPLE_VI_CONFIG_S *c);
+HI_S32 SAMPLE_COMM_VI_UnBind_VPSS(VI_PIPE p, VI_CHN c, VPSS_GRP g);
+HI_S32 SAMPLE_COMM_VO_GetDefConfig(SAMPLE_VO_CONFIG_S *c); HI_S32 SAMPLE_COMM_VO_StartLayer(VO_LAYER l, const VO_VIDEO_LAYER_ATTR_S *a);
+HI_S32 SAMPLE_COMM_VO_StopLayer(VO_LAYER l); HI_S32 SAMPLE_COMM_VO_StopDev(VO_DEV d); HI_S32 SAMPLE_COMM_VO_StopVO(SAMPLE_VO_CONFIG_S *c);
+HI_S32 SAMPLE_COMM_VPSS_Bind_VO(VPSS_GRP g, VPSS_CHN c, VO_LAYER l, VO_CHN vc);
+HI_S32 SAMPLE_COMM_VPSS_UnBind_VO(VPSS_GRP g, VPSS_CHN c, VO_LAYER l, VO_CHN vc);
+HI_S32 SAMPLE_COMM_VPSS_Bind_VENC(VPSS_GRP g, VPSS_CHN c, VENC_CHN v);
+HI_S32 SAMPLE_COMM_VPSS_UnBind_VENC(VPSS_GRP g, VPSS_CHN c, VENC_CHN v);
+HI_S32 SAMPLE_COMM_VENC_SnapStart(VENC_CHN c, SIZE_S *s, HI_BOOL bSupportDCF);
+HI_S32 SAMPLE_COMM_VENC_SnapStop(VENC_CHN c);
+HI_S32 SAMPLE_COMM_VENC_Start(VENC_CHN c, PAYLOAD_TYPE_E t, PIC_SIZE_E s, SAMPLE_RC_E rc, HI_U32 profile, HI_BOOL bRcnRefShareBuf, VENC_GOP_ATTR_S *gop);
+HI_S32 SAMPLE_COMM_VENC_Stop(VENC_CHN c);
+HI_S32 SAMPLE_COMM_VENC_GetGopAttr(VENC_GOP_MODE_E m, VENC_GOP_ATTR_S *g);
+HI_S32 VENC_GetPic(VENC_CHN c, const char *name);
+
+/* ai sample libs */
+typedef struct { int xmin; int ymin; int xmax; int ymax; } RectBox;
+typedef struct { int cls; RectBox box; float score; } DetectObjInfo;
+typedef struct { unsigned int num; unsigned int score; } RecogNumInfo;
+typedef struct { uintptr_t model; } AiPlugLib;
+typedef struct SAMPLE_SVP_NNIE_CFG_S { int dummy; } SAMPLE_SVP_NNIE_CFG_S;
+typedef struct OsdSet OsdSet;
+int Yolo2Create(SAMPLE_SVP_NNIE_CFG_S **self, const char *model);
+void Yolo2Destory(SAMPLE_SVP_NNIE_CFG_S *self);
+int Yolo2CalImg(SAMPLE_SVP_NNIE_CFG_S *self, const IVE_IMAGE_S *img, DetectObjInfo objs[], int objCap, int *objNum);
+int CnnCreate(SAMPLE_SVP_NNIE_CFG_S **self, const char *model);
+void CnnDestroy(SAMPLE_SVP_NNIE_CFG_S *self);
+int CnnCalImg(SAMPLE_SVP_NNIE_CFG_S *self, const IVE_IMAGE_S *img, RecogNumInfo res[], int resSize, int *resLen);
+int MppFrmResize(const VIDEO_FRAME_INFO_S *src, VIDEO_FRAME_INFO_S *dst, uint32_t dstWidth, uint32_t dstHeight);
+void MppFrmDestroy(VIDEO_FRAME_INFO_S *frm);
+int MppFrmDrawRects(VIDEO_FRAME_INFO_S *frm, const RectBox *boxes, int boxesNum, uint32_t color, int thick);
+int FrmToOrigImg(const VIDEO_FRAME_INFO_S *frm, IVE_IMAGE_S *img);
+int OrigImgToFrm(const IVE_IMAGE_S *img, VIDEO_FRAME_INFO_S *frm);
+int ImgYuvCrop(const IVE_IMAGE_S *src, IVE_IMAGE_S *dst, const RectBox *rect);
+int IveImgCreate(IVE_IMAGE_S *img, IVE_IMAGE_TYPE_E enType, uint32_t width, uint32_t height);
+void IveImgDestroy(IVE_IMAGE_S *img);
+#define RGB888_GREEN 0x00FF00
+#define RGB888_RED 0xFF0000
+int sdk_init(void); void sdk_exit(void);
+int Play_audioFile(int idx);
+int GPIO_Init(void);
+void LED1_ON(void); void LED1_OFF(void); void LED2_ON(void); void LED2_OFF(void);
+
+/*
+ * 仿真控制，sdk_init/sdk_exit会调用
+ * Simulation control, called by sdk_init/sdk_exit
+ */
+HI_S32 MpiSimStart(void);
+void MpiSimStop(void);
+void MpiSimReport(void);
+HI_U32 MpiSimYoloCalls(void);
+HI_U32 MpiSimCamFrames(void);
+HI_U64 MpiSimNowUs(void);
+HI_U32 MpiSimEnv(const char* name, HI_U32 def); // Unsigned environment knob, def when unset
+
+#endif
@@ -0,0 +1,801 @@
+/*
+ * 样例库外设部分(sdk/sample_comm/VI/VO/ISP/GPIO/UART/音频)的主机端替身实现，见mpi/mpi_sim.h
+ * 串口回环到舵机MCU模型：按servo_proto解析设定值帧，按115200波特率的线路时间延后回ACK。
+ * 仿真网页端在本机8888端口收帧重组，用帧头PTS统计端到端延迟。
+ *
+ * Host stand-in of the sample library peripherals (sdk/sample_comm/VI/VO/ISP/GPIO/UART/audio), see mpi/mpi_sim.h.
+ * The UART loops back to a servo MCU model: setpoint frames are parsed with servo_proto and the ACK comes back
+ * after the line time at 115200 baud. A simulated web end receives and reassembles the frames on local port 8888
+ * and measures the end to end latency from the PTS in the frame header.
+ */
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "mpi_sim.h"
+#include "uart_user.h"
+#include "servo_proto.h"
+#include "udp_frame.h"
+
+#define SIM_UART_BYTE_US    87 // 10 bits at 115200 baud
+#define SIM_UART_RX_MAX     1024
+#define SIM_US_PER_S        1000000ULL
+#define SIM_NS_PER_US       1000ULL
+#define SIM_WEB_PORT        8888 // serverPort of sample_media_ai.c
+#define SIM_WEB_POLL_MS     100
+#define SIM_LAT_SAMPLE_MAX  16384 // About 9 minutes at 30 fps, later frames are left out of the percentiles
+#define SIM_DGRAM_MAX       2048
+#define SIM_ACK_PORT        9999 // clientPort of sample_media_ai.c, takes the relay feedback
+#define SIM_FB_PERIOD_US    1000000 // The relay reports once a second
+#define SIM_FB_MSG_MAX      64
+
+typedef struct {
+    HI_U8 data[SIM_UART_RX_MAX];
+    HI_U64 readyUs[SIM_UART_RX_MAX]; // When each byte has reached the board
+    HI_U32 head;
+    HI_U32 tail;
+} SimUartRx;
+
+static struct {
+    pthread_mutex_t lock;
+    ServoProtoParser parser;
+    SimUartRx rx;
+    HI_U64 lineFreeUs; // The MCU to board direction is busy until then
+    HI_U32 setpointCnt;
+    HI_U32 ackCnt;
+    HI_U32 overflow;
+    uint16_t angle[SERVO_PROTO_SP_MAX];
+    int rxFd; // timerfd standing in for the UART fd, fires when the oldest queued byte reaches the board
+} g_mcu = { .lock = PTHREAD_MUTEX_INITIALIZER, .rxFd = -1 };
+
+static struct {
+    int fd;
+    HI_BOOL running;
+    pthread_t thread;
+    HI_U32 frameId;
+    HI_U32 fragGot;
+    HI_U32 fragCnt;
+    HI_U64 pts;
+    HI_BOOL pending;
+    HI_U32 frames;
+    HI_U32 incomplete;
+    HI_U64 bytes;
+    HI_U32 latMaxUs;
+    int fbFd;
+    HI_U64 fbLastUs;
+    HI_U32 fbFrames; // frames at the last report
+    HI_U32 fbCnt;
+    HI_U32 fbLossPct;
+    HI_U64 fbLossUs; // Loss is reported until then
+    HI_U32 fbRttUs;
+    HI_U32 latCnt;
+    HI_U32 lat[SIM_LAT_SAMPLE_MAX]; // us
+} g_web = { .fd = -1, .fbFd = -1 };
+
+static HI_U32 g_ledWrites;
+static HI_U32 g_audioPlays;
+static pthread_t g_enterThread;
+static HI_BOOL g_enterArmed;
+
+/* ---------------------------------------------------------------- sample_comm / VI / VO / ISP ---------------------------------------------------------------- */
+
+HI_S32 SAMPLE_COMM_SYS_Init(VB_CONFIG_S *c)
+{
+    (void)c;
+    return HI_SUCCESS;
+}
+
+HI_VOID SAMPLE_COMM_SYS_Exit(void)
+{
+}
+
+HI_S32 SAMPLE_COMM_SYS_GetPicSize(PIC_SIZE_E e, SIZE_S *s)
+{
+    static const SIZE_S sizes[PIC_BUTT] = { { 352, 288 }, { 640, 360 }, { 1280, 720 }, { 1920, 1080 } };
+
+    if ((HI_U32)e >= PIC_BUTT) {
+        return HI_FAILURE;
+    }
+    *s = sizes[e];
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VI_GetSizeBySensor(SAMPLE_SNS_TYPE_E t, PIC_SIZE_E *p)
+{
+    (void)t;
+    *p = PIC_1080P;
+    return HI_SUCCESS;
+}
+
+HI_VOID SAMPLE_COMM_VI_GetSensorInfo(SAMPLE_VI_CONFIG_S *c)
+{
+    for (int i = 0; i < 4; i++) { // 4: astViInfo entries
+        c->astViInfo[i].stSnsInfo.enSnsType = SONY_IMX335_MIPI_4M_30FPS_12BIT;
+        c->astViInfo[i].stSnsInfo.s32SnsId = i;
+    }
+}
+
+HI_S32 SAMPLE_COMM_VI_GetComboDevBySensor(SAMPLE_SNS_TYPE_E t, HI_S32 i)
+{
+    (void)t;
+    return i;
+}
+
+HI_S32 SAMPLE_COMM_VI_GetFrameRateBySensor(SAMPLE_SNS_TYPE_E t, HI_U32 *f)
+{
+    (void)t;
+    *f = MpiSimEnv("SIM_FPS", 30); // 30: same default as the simulated camera
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VI_SetParam(SAMPLE_VI_CONFIG_S *c)
+{
+    (void)c;
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VI_StartVi(SAMPLE_VI_CONFIG_S *c)
+{
+    (void)c;
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VI_StopVi(SAMPLE_VI_CONFIG_S *c)
+{
+    (void)c;
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VI_UnBind_VPSS(VI_PIPE p, VI_CHN c, VPSS_GRP g)
+{
+    (void)p;
+    (void)c;
+    (void)g;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_ISP_GetCtrlParam(VI_PIPE p, ISP_CTRL_PARAM_S *c)
+{
+    (void)p;
+    memset(c, 0, sizeof(*c));
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_ISP_SetCtrlParam(VI_PIPE p, const ISP_CTRL_PARAM_S *c)
+{
+    (void)p;
+    (void)c;
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VPSS_Bind_VENC(VPSS_GRP g, VPSS_CHN c, VENC_CHN v)
+{
+    (void)g;
+    (void)c;
+    (void)v;
+    return HI_SUCCESS; // The simulated VENC is always fed by the camera
+}
+
+HI_S32 SAMPLE_COMM_VPSS_UnBind_VENC(VPSS_GRP g, VPSS_CHN c, VENC_CHN v)
+{
+    return SAMPLE_COMM_VPSS_Bind_VENC(g, c, v);
+}
+
+HI_S32 SAMPLE_COMM_VENC_SnapStart(VENC_CHN c, SIZE_S *s, HI_BOOL bSupportDCF)
+{
+    VENC_CHN_ATTR_S attr;
+    VENC_JPEG_PARAM_S jpeg;
+
+    (void)bSupportDCF;
+    memset(&attr, 0, sizeof(attr));
+    attr.stVencAttr.enType = PT_JPEG;
+    attr.stVencAttr.u32MaxPicWidth = s->u32Width;
+    attr.stVencAttr.u32MaxPicHeight = s->u32Height;
+    attr.stVencAttr.u32PicWidth = s->u32Width;
+    attr.stVencAttr.u32PicHeight = s->u32Height;
+    memset(&jpeg, 0, sizeof(jpeg));
+    jpeg.u32Qfactor = 90; // 90: the snap sample's default QFactor
+    if (HI_MPI_VENC_CreateChn(c, &attr) != HI_SUCCESS || HI_MPI_VENC_SetJpegParam(c, &jpeg) != HI_SUCCESS) {
+        return HI_FAILURE;
+    }
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VENC_GetGopAttr(VENC_GOP_MODE_E m, VENC_GOP_ATTR_S *g)
+{
+    if (m != VENC_GOPMODE_NORMALP) {
+        return HI_FAILURE; // Only the mode the app uses
+    }
+    memset(g, 0, sizeof(*g));
+    g->enGopMode = m;
+    g->stNormalP.s32IPQpDelta = 2; // 2: the sample's default
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VO_GetDefConfig(SAMPLE_VO_CONFIG_S *c)
+{
+    memset(c, 0, sizeof(*c));
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VO_StartLayer(VO_LAYER l, const VO_VIDEO_LAYER_ATTR_S *a)
+{
+    (void)l;
+    (void)a;
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VO_StopLayer(VO_LAYER l)
+{
+    (void)l;
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VO_StopDev(VO_DEV d)
+{
+    (void)d;
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VO_StopVO(SAMPLE_VO_CONFIG_S *c)
+{
+    (void)c;
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VPSS_Bind_VO(VPSS_GRP g, VPSS_CHN c, VO_LAYER l, VO_CHN vc)
+{
+    (void)g;
+    (void)c;
+    (void)l;
+    (void)vc;
+    return HI_SUCCESS;
+}
+
+HI_S32 SAMPLE_COMM_VPSS_UnBind_VO(VPSS_GRP g, VPSS_CHN c, VO_LAYER l, VO_CHN vc)
+{
+    return SAMPLE_COMM_VPSS_Bind_VO(g, c, l, vc);
+}
+
+/*
+ * 没有屏幕，VO接口全部直接成功
+ * There is no screen, every VO call just succeeds
+ */
+HI_S32 HI_MPI_VO_Enable(VO_DEV d)
+{
+    (void)d;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_SetPubAttr(VO_DEV d, const VO_PUB_ATTR_S *a)
+{
+    (void)d;
+    (void)a;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_SetDevFrameRate(VO_DEV d, HI_U32 f)
+{
+    (void)d;
+    (void)f;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_SetUserIntfSyncInfo(VO_DEV d, VO_USER_INTFSYNC_INFO_S *i)
+{
+    (void)d;
+    (void)i;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_GetVideoLayerAttr(VO_LAYER l, VO_VIDEO_LAYER_ATTR_S *a)
+{
+    (void)l;
+    memset(a, 0, sizeof(*a));
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_SetChnAttr(VO_LAYER l, VO_CHN c, const VO_CHN_ATTR_S *a)
+{
+    (void)l;
+    (void)c;
+    (void)a;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_SetChnRotation(VO_LAYER l, VO_CHN c, ROTATION_E r)
+{
+    (void)l;
+    (void)c;
+    (void)r;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_EnableChn(VO_LAYER l, VO_CHN c)
+{
+    (void)l;
+    (void)c;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_SetDisplayBufLen(VO_LAYER l, HI_U32 n)
+{
+    (void)l;
+    (void)n;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_SetVideoLayerPartitionMode(VO_LAYER l, VO_PART_MODE_E m)
+{
+    (void)l;
+    (void)m;
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_GetVideoLayerCSC(VO_LAYER l, VO_CSC_S *c)
+{
+    (void)l;
+    memset(c, 0, sizeof(*c));
+    return HI_SUCCESS;
+}
+
+HI_S32 HI_MPI_VO_SetVideoLayerCSC(VO_LAYER l, const VO_CSC_S *c)
+{
+    (void)l;
+    (void)c;
+    return HI_SUCCESS;
+}
+
+/* ---------------------------------------------------------------- GPIO / 音频 audio ---------------------------------------------------------------- */
+
+int GPIO_Init(void)
+{
+    return 0;
+}
+
+void LED1_ON(void)
+{
+    __atomic_fetch_add(&g_ledWrites, 1, __ATOMIC_RELAXED);
+}
+
+void LED1_OFF(void)
+{
+    __atomic_fetch_add(&g_ledWrites, 1, __ATOMIC_RELAXED);
+}
+
+void LED2_ON(void)
+{
+    __atomic_fetch_add(&g_ledWrites, 1, __ATOMIC_RELAXED);
+}
+
+void LED2_OFF(void)
+{
+    __atomic_fetch_add(&g_ledWrites, 1, __ATOMIC_RELAXED);
+}
+
+int Play_audioFile(int idx)
+{
+    (void)idx;
+    __atomic_fetch_add(&g_audioPlays, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/* ---------------------------------------------------------------- UART / 舵机MCU Servo MCU ---------------------------------------------------------------- */
+
+/*
+ * MCU按设定值立即回显角度，不模拟轨迹限速；ACK在设定值帧和ACK帧的线路时间之后才能被读到
+ * The MCU echoes the setpoint as its angle at once, its trajectory limits are not modelled;
+ * the ACK can be read only after the line time of the setpoint frame and of the ACK itself
+ */
+/*
+ * 让串口fd在rx中最早的字节到达时可读，rx为空时不动；调用时持有g_mcu.lock
+ * Make the UART fd readable when the oldest byte in rx arrives, nothing when rx is empty; called with g_mcu.lock held
+ */
+static void SimUartArm(void)
+{
+    SimUartRx *rx = &g_mcu.rx;
+    struct itimerspec its = { { 0, 0 }, { 0, 0 } };
+    HI_U64 readyUs;
+
+    if (g_mcu.rxFd < 0 || rx->tail == rx->head) {
+        return;
+    }
+    readyUs = rx->readyUs[rx->tail % SIM_UART_RX_MAX];
+    its.it_value.tv_sec = (time_t)(readyUs / SIM_US_PER_S);
+    its.it_value.tv_nsec = (long)(readyUs % SIM_US_PER_S * SIM_NS_PER_US);
+    timerfd_settime(g_mcu.rxFd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void SimMcuAck(const ServoMsg* msg, HI_U32 rxLen, HI_U64 nowUs)
+{
+    uint8_t buf[SERVO_PROTO_FRAME_MAX];
+    ServoMsg ack = { .type = SERVO_MSG_ACK, .seq = msg->seq, .ts = msg->ts, .cnt = 2 }; // 2: pan and tilt
+    HI_U64 readyUs;
+    int len;
+
+    for (uint8_t i = 0; i < ack.cnt; i++) {
+        ack.sp[i].id = i;
+        ack.sp[i].angle = g_mcu.angle[i];
+    }
+    len = ServoProtoPack(&ack, buf, sizeof(buf));
+    readyUs = nowUs + (HI_U64)rxLen * SIM_UART_BYTE_US;
+    readyUs = readyUs > g_mcu.lineFreeUs ? readyUs : g_mcu.lineFreeUs;
+    for (int i = 0; i < len; i++) {
+        SimUartRx *rx = &g_mcu.rx;
+        readyUs += SIM_UART_BYTE_US;
+        if (rx->head - rx->tail >= SIM_UART_RX_MAX) {
+            g_mcu.overflow++;
+            continue;
+        }
+        rx->data[rx->head % SIM_UART_RX_MAX] = buf[i];
+        rx->readyUs[rx->head % SIM_UART_RX_MAX] = readyUs;
+        rx->head++;
+    }
+    g_mcu.lineFreeUs = readyUs;
+    g_mcu.ackCnt++;
+    SimUartArm();
+}
+
+int Uart1Init(void)
+{
+    pthread_mutex_lock(&g_mcu.lock);
+    ServoProtoParserInit(&g_mcu.parser);
+    g_mcu.rx.head = 0;
+    g_mcu.rx.tail = 0;
+    if (g_mcu.rxFd < 0) {
+        g_mcu.rxFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    }
+    pthread_mutex_unlock(&g_mcu.lock);
+    return g_mcu.rxFd < 0 ? -1 : 0;
+}
+
+int Uart1Send(const unsigned char *buf, int len)
+{
+    HI_U64 nowUs = MpiSimNowUs();
+    ServoMsg msg;
+
+    pthread_mutex_lock(&g_mcu.lock);
+    for (int i = 0; i < len; i++) {
+        if (!ServoProtoParse(&g_mcu.parser, buf[i], &msg) || msg.type != SERVO_MSG_SETPOINT) {
+            continue;
+        }
+        g_mcu.setpointCnt++;
+        for (uint8_t j = 0; j < msg.cnt; j++) {
+            if (msg.sp[j].id < SERVO_PROTO_SP_MAX) {
+                g_mcu.angle[msg.sp[j].id] = msg.sp[j].angle;
+            }
+        }
+        if (msg.flags & SERVO_FLAG_ACK_REQ) {
+            SimMcuAck(&msg, (HI_U32)(i + 1), nowUs);
+        }
+    }
+    pthread_mutex_unlock(&g_mcu.lock);
+    return len;
+}
+
+int Uart1Read(unsigned char *buf, int len)
+{
+    HI_U64 nowUs = MpiSimNowUs();
+    SimUartRx *rx = &g_mcu.rx;
+    uint64_t expired;
+    int n = 0;
+
+    pthread_mutex_lock(&g_mcu.lock);
+    if (g_mcu.rxFd >= 0 && read(g_mcu.rxFd, &expired, sizeof(expired)) < 0 && errno != EAGAIN) {
+        printf("[sim] uart timerfd read FAIL, errno=%d\n", errno); // EAGAIN: not fired, nothing to clear
+    }
+    while (n < len && rx->tail != rx->head && rx->readyUs[rx->tail % SIM_UART_RX_MAX] <= nowUs) {
+        buf[n++] = rx->data[rx->tail % SIM_UART_RX_MAX];
+        rx->tail++;
+    }
+    SimUartArm();
+    pthread_mutex_unlock(&g_mcu.lock);
+    return n;
+}
+
+int Uart1Fd(void)
+{
+    return g_mcu.rxFd;
+}
+
+void Uart1Close(void)
+{
+    pthread_mutex_lock(&g_mcu.lock);
+    if (g_mcu.rxFd >= 0) {
+        close(g_mcu.rxFd);
+        g_mcu.rxFd = -1;
+    }
+    pthread_mutex_unlock(&g_mcu.lock);
+}
+
+/* ---------------------------------------------------------------- 仿真网页端 Simulated web end ---------------------------------------------------------------- */
+
+static HI_U32 SimGetU16(const HI_U8* p)
+{
+    return ((HI_U32)p[0] << 8) | p[1]; // 8: big endian
+}
+
+static HI_U32 SimGetU32(const HI_U8* p)
+{
+    return (SimGetU16(p) << 16) | SimGetU16(p + 2); // 16, 2: high half first
+}
+
+/*
+ * 只按分片计数判断一帧是否收齐，不做FEC恢复；新帧号到来时未收齐的旧帧记为不完整
+ * A frame is complete when all its data fragments have arrived, no FEC recovery; an unfinished frame
+ * counts as incomplete once a newer frame id shows up
+ */
+static void SimWebFeed(const HI_U8* pkt, ssize_t len)
+{
+    HI_U32 frameId, fragCnt, payloadLen, latUs;
+    HI_U64 pts;
+
+    if (len < UDP_FRAME_HDR_LEN || SimGetU16(pkt) != UDP_FRAME_MAGIC || (pkt[3] & UDP_FRAME_FLAG_PARITY)) { // 3: flags
+        return;
+    }
+    frameId = SimGetU32(pkt + 4); // 4: frameId
+    fragCnt = SimGetU16(pkt + 10); // 10: fragCnt
+    payloadLen = SimGetU16(pkt + 12); // 12: payloadLen
+    pts = ((HI_U64)SimGetU32(pkt + 20) << 32) | SimGetU32(pkt + 24); // 20, 24: pts, 32: high word
+    if (!g_web.pending || frameId != g_web.frameId) {
+        g_web.incomplete += g_web.pending ? 1 : 0;
+        g_web.frameId = frameId;
+        g_web.fragCnt = fragCnt;
+        g_web.fragGot = 0;
+        g_web.pts = pts;
+        g_web.pending = HI_TRUE;
+    }
+    g_web.bytes += payloadLen;
+    if (++g_web.fragGot < g_web.fragCnt) {
+        return;
+    }
+    g_web.pending = HI_FALSE;
+    g_web.frames++;
+    latUs = (HI_U32)(MpiSimNowUs() - g_web.pts);
+    g_web.latMaxUs = latUs > g_web.latMaxUs ? latUs : g_web.latMaxUs;
+    if (g_web.latCnt < SIM_LAT_SAMPLE_MAX) {
+        g_web.lat[g_web.latCnt++] = latUs;
+    }
+}
+
+/*
+ * 模拟中继每秒一次的码率反馈 "FB frames lost recovered rttUs"，丢帧比例和持续时间由环境变量给出，
+ * 使板端的码率档位控制在主机上也能跑到
+ *
+ * Fake the relay's once a second bitrate feedback "FB frames lost recovered rttUs". The loss rate and
+ * how long it lasts come from the environment, so the board's bitrate level control runs on the host too
+ */
+static void SimWebFeedback(void)
+{
+    char msg[SIM_FB_MSG_MAX];
+    HI_U64 nowUs = MpiSimNowUs();
+    HI_U32 frames, lost;
+    struct sockaddr_in to;
+    int len;
+
+    if (g_web.fbFd < 0 || g_web.frames == 0 || nowUs - g_web.fbLastUs < SIM_FB_PERIOD_US) {
+        return;
+    }
+    frames = g_web.frames - g_web.fbFrames;
+    lost = nowUs < g_web.fbLossUs ? frames * g_web.fbLossPct / 100 : 0; // 100: percent
+    g_web.fbFrames = g_web.frames;
+    g_web.fbLastUs = nowUs;
+    len = snprintf(msg, sizeof(msg), "FB %u %u 0 %u", frames - lost, lost, g_web.fbRttUs);
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = htons(SIM_ACK_PORT);
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (sendto(g_web.fbFd, msg, len, 0, (struct sockaddr*)&to, sizeof(to)) == len) {
+        g_web.fbCnt++;
+    }
+}
+
+static void* SimWebTrd(void* arg)
+{
+    HI_U8 pkt[SIM_DGRAM_MAX];
+    struct pollfd pfd = { g_web.fd, POLLIN, 0 };
+
+    (void)arg;
+    while (__atomic_load_n(&g_web.running, __ATOMIC_ACQUIRE)) {
+        SimWebFeedback();
+        if (poll(&pfd, 1, SIM_WEB_POLL_MS) <= 0) {
+            continue;
+        }
+        ssize_t len = recv(g_web.fd, pkt, sizeof(pkt), 0);
+        if (len > 0) {
+            SimWebFeed(pkt, len);
+        }
+    }
+    return NULL;
+}
+
+static void SimWebStart(void)
+{
+    struct sockaddr_in addr;
+
+    g_web.fd = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(SIM_WEB_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (g_web.fd < 0 || bind(g_web.fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        printf("[sim] web end: bind 127.0.0.1:%d FAIL, frames are not checked\n", SIM_WEB_PORT);
+        if (g_web.fd >= 0) {
+            close(g_web.fd);
+            g_web.fd = -1;
+        }
+        return;
+    }
+    g_web.fbFd = socket(AF_INET, SOCK_DGRAM, 0);
+    g_web.fbLastUs = MpiSimNowUs();
+    g_web.fbLossPct = MpiSimEnv("SIM_FB_LOSS", 0);
+    g_web.fbLossUs = MpiSimEnv("SIM_FB_LOSS_S", 0) == 0 ? (HI_U64)-1 :
+        g_web.fbLastUs + (HI_U64)MpiSimEnv("SIM_FB_LOSS_S", 0) * 1000000; // 1000000: us per s
+    g_web.fbRttUs = MpiSimEnv("SIM_FB_RTT_US", 2000); // 2000: a LAN round trip
+    g_web.running = HI_TRUE;
+    if (pthread_create(&g_web.thread, NULL, SimWebTrd, NULL) != 0) {
+        g_web.running = HI_FALSE;
+    }
+}
+
+static void SimWebStop(void)
+{
+    if (g_web.running) {
+        __atomic_store_n(&g_web.running, HI_FALSE, __ATOMIC_RELEASE);
+        pthread_join(g_web.thread, NULL);
+    }
+    if (g_web.fd >= 0) {
+        close(g_web.fd);
+        g_web.fd = -1;
+    }
+    if (g_web.fbFd >= 0) {
+        close(g_web.fbFd);
+        g_web.fbFd = -1;
+    }
+}
+
+static int SimLatCmp(const void* a, const void* b)
+{
+    HI_U32 x = *(const HI_U32*)a;
+    HI_U32 y = *(const HI_U32*)b;
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * 已排序样本的百分位，取第(n-1)*p/100个样本，返回ms
+ * Percentile of the sorted samples, taken at index (n-1)*p/100, in ms
+ */
+static double SimLatPercentile(HI_U32 pct)
+{
+    HI_U32 idx;
+
+    if (g_web.latCnt == 0) {
+        return 0;
+    }
+    idx = (HI_U32)((HI_U64)(g_web.latCnt - 1) * pct / 100); // 100: percent
+    idx = idx < g_web.latCnt - 1 ? idx : g_web.latCnt - 1;
+    return g_web.lat[idx] / 1000.0; // 1000: us per ms
+}
+
+/* ---------------------------------------------------------------- sdk ---------------------------------------------------------------- */
+
+/*
+ * SIM_RUN_S秒后替用户按下回车，让Pause()返回，程序按正常流程退出
+ * Press Enter for the user after SIM_RUN_S seconds, so Pause() returns and the app exits the normal way
+ */
+static void* SimEnterTrd(void* arg)
+{
+    int fd = (int)(intptr_t)arg;
+
+    sleep(MpiSimEnv("SIM_RUN_S", 0));
+    if (write(fd, "\n", 1) != 1) {
+        printf("[sim] press Enter FAIL\n");
+    }
+    close(fd);
+    return NULL;
+}
+
+int sdk_init(void)
+{
+    int fds[2];
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    if (MpiSimStart() != HI_SUCCESS) {
+        printf("[sim] start FAIL\n");
+        exit(1);
+    }
+    SimWebStart();
+    if (MpiSimEnv("SIM_RUN_S", 0) > 0 && pipe(fds) == 0 && dup2(fds[0], STDIN_FILENO) >= 0) {
+        close(fds[0]);
+        g_enterArmed = pthread_create(&g_enterThread, NULL, SimEnterTrd, (void*)(intptr_t)fds[1]) == 0;
+    }
+    return 0;
+}
+
+/*
+ * 回归门限检查，knob未设置(为0)时不检查；不满足时打印并返回HI_FALSE
+ * Regression limit checks, skipped while knob is unset (0); print and return HI_FALSE when the limit is missed
+ */
+static HI_BOOL SimCheckMin(const char* knob, const char* what, double val)
+{
+    HI_U32 lim = MpiSimEnv(knob, 0);
+
+    if (lim == 0 || val >= lim) {
+        return HI_TRUE;
+    }
+    printf("[sim] FAIL: %s %.1f below %s=%u\n", what, val, knob, lim);
+    return HI_FALSE;
+}
+
+static HI_BOOL SimCheckMax(const char* knob, const char* what, double val)
+{
+    HI_U32 lim = MpiSimEnv(knob, 0);
+
+    if (lim == 0 || val <= lim) {
+        return HI_TRUE;
+    }
+    printf("[sim] FAIL: %s %.1f above %s=%u\n", what, val, knob, lim);
+    return HI_FALSE;
+}
+
+/*
+ * 对照SIM_CHECK_*门限检查汇总数据，全部满足(或未设置)时返回HI_TRUE
+ * Check the summary against the SIM_CHECK_* limits, HI_TRUE when all are met (or unset)
+ */
+static HI_BOOL SimCheckLimits(void)
+{
+    double cam = MpiSimCamFrames() ? MpiSimCamFrames() : 1;
+    double yoloPct = MpiSimYoloCalls() * 100.0 / cam; // 100: percent
+    HI_BOOL ok = HI_TRUE;
+
+    ok &= SimCheckMin("SIM_CHECK_SENT_PCT", "web frames %", g_web.frames * 100.0 / cam); // 100: percent
+    ok &= SimCheckMin("SIM_CHECK_YOLO_MIN_PCT", "yolo calls %", yoloPct);
+    ok &= SimCheckMax("SIM_CHECK_YOLO_MAX_PCT", "yolo calls %", yoloPct);
+    ok &= SimCheckMin("SIM_CHECK_ACK_PCT", "uart acks %",
+        g_mcu.setpointCnt ? g_mcu.ackCnt * 100.0 / g_mcu.setpointCnt : 0); // 100: percent
+    ok &= SimCheckMax("SIM_CHECK_P50_MS", "e2e p50 ms", SimLatPercentile(50)); // 50: p50
+    ok &= SimCheckMax("SIM_CHECK_P99_MS", "e2e p99 ms", SimLatPercentile(99)); // 99: p99
+    return ok;
+}
+
+/*
+ * 打印仿真汇总；定时运行(SIM_RUN_S)时网页端一帧没收到、检测从未运行或未达SIM_CHECK_*门限则以1退出，
+ * 供回归(make test)判断
+ * Print the simulation summary; in a timed run (SIM_RUN_S) exit with 1 when the web end got no frame,
+ * detection never ran or a SIM_CHECK_* limit is missed, so the regression run (make test) can tell
+ */
+void sdk_exit(void)
+{
+    if (g_enterArmed) {
+        pthread_join(g_enterThread, NULL);
+        g_enterArmed = HI_FALSE;
+    }
+    MpiSimStop();
+    SimWebStop();
+
+    printf("[sim] ---------------- summary ----------------\n");
+    MpiSimReport();
+    printf("[sim] uart: %u setpoints, %u acks, rx overflow %u, last angle %u %u\n", g_mcu.setpointCnt,
+        g_mcu.ackCnt, g_mcu.overflow, g_mcu.angle[0], g_mcu.angle[1]);
+    printf("[sim] led writes: %u, audio plays: %u\n", g_ledWrites, g_audioPlays);
+    qsort(g_web.lat, g_web.latCnt, sizeof(g_web.lat[0]), SimLatCmp);
+    printf("[sim] web: %u frames %.1f MB, %u incomplete, e2e latency p50 %.1f ms p99 %.1f ms max %.1f ms\n",
+        g_web.frames, (double)g_web.bytes / (1024 * 1024), g_web.incomplete, // 1024 * 1024: MB
+        SimLatPercentile(50), SimLatPercentile(99), g_web.latMaxUs / 1000.0); // 50, 99: p50, p99
+    printf("[sim] relay feedback: %u reports, %u%% loss\n", g_web.fbCnt, g_web.fbLossPct);
+    if (MpiSimEnv("SIM_RUN_S", 0) == 0) {
+        return;
+    }
+    if (g_web.frames == 0 || MpiSimYoloCalls() == 0) {
+        printf("[sim] FAIL: the pipeline did not run end to end\n");
+        exit(1);
+    }
+    if (!SimCheckLimits()) {
+        exit(1);
+    }
+}
@@ -0,0 +1,163 @@
+/*
+ * 舵机PWM时序的主机端仿真：servo_pwm.c在mcu/下的SDK替身上运行，记录两路引脚的每个边沿并检查
+ * 周期、脉宽、两路同时上升、周期中途设置的脉宽在下一周期生效、中断延迟不累积。
+ *
+ * Host simulation of the servo PWM timing: servo_pwm.c runs on the SDK stand-in under mcu/, every edge on
+ * both pins is recorded and checked for period, pulse width, simultaneous rising edges, mid-period updates
+ * taking effect at the next period, and ISR latency not accumulating.
+ */
+#include <stdlib.h>
+
+#include "mcu_sim.h"
+#include "servo_pwm.h"
+
+#define PIN_PAN         GPIO_10
+#define PIN_TILT        GPIO_12
+#define EDGE_MAX        256
+#define PERIODS         20
+
+typedef struct {
+    uint64_t rise[EDGE_MAX];
+    uint64_t fall[EDGE_MAX];
+    int riseNum;
+    int fallNum;
+} PinLog;
+
+static PinLog g_log[SERVO_PWM_CH_NUM];
+static int g_failCnt = 0;
+
+#define CHECK(cond, fmt, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: " fmt "\n", __FUNCTION__, __LINE__, ##__VA_ARGS__); \
+        g_failCnt++; \
+    } \
+} while (0)
+
+static void GpioHook(pin_t pin, gpio_level_t level, uint64_t nowUs)
+{
+    PinLog *log = &g_log[pin == PIN_PAN ? 0 : 1];
+
+    if (pin != PIN_PAN && pin != PIN_TILT) {
+        return;
+    }
+    if (level == GPIO_LEVEL_HIGH && log->riseNum < EDGE_MAX) {
+        log->rise[log->riseNum++] = nowUs;
+    } else if (level == GPIO_LEVEL_LOW && log->fallNum < EDGE_MAX) {
+        log->fall[log->fallNum++] = nowUs;
+    }
+}
+
+static void SimStart(uint32_t isrLatencyUs)
+{
+    static const pin_t pins[SERVO_PWM_CH_NUM] = { PIN_PAN, PIN_TILT };
+
+    McuSimReset();
+    memset(g_log, 0, sizeof(g_log));
+    McuSimSetGpioHook(GpioHook);
+    McuSimSetIsrLatency(isrLatencyUs);
+    CHECK(ServoPwmInit(pins) == 0, "init");
+}
+
+/*
+ * 第i个周期通道ch的脉宽，tol为允许的误差(us)
+ * Pulse width of channel ch in period i, tol is the allowed error in us
+ */
+static void CheckPulse(int ch, int i, uint32_t want, uint32_t tol)
+{
+    const PinLog *log = &g_log[ch];
+    long width;
+
+    CHECK(i < log->riseNum && i < log->fallNum, "ch%d period %d missing edges", ch, i);
+    if (i >= log->riseNum || i >= log->fallNum) {
+        return;
+    }
+    width = (long)(log->fall[i] - log->rise[i]);
+    CHECK(labs(width - (long)want) <= (long)tol, "ch%d period %d width %ld want %u", ch, i, width, want);
+}
+
+static void TestSteady(void)
+{
+    SimStart(0);
+    ServoPwmSet(0, 1500);
+    ServoPwmSet(1, 1000);
+    McuSimRunUntil((uint64_t)SERVO_PWM_PERIOD_US * (PERIODS + 1) - 1);
+
+    for (int ch = 0; ch < SERVO_PWM_CH_NUM; ch++) {
+        CHECK(g_log[ch].riseNum == PERIODS, "ch%d %d periods", ch, g_log[ch].riseNum);
+        for (int i = 1; i < g_log[ch].riseNum; i++) {
+            CHECK(g_log[ch].rise[i] - g_log[ch].rise[i - 1] == SERVO_PWM_PERIOD_US, "ch%d period %d len %llu",
+                ch, i, (unsigned long long)(g_log[ch].rise[i] - g_log[ch].rise[i - 1]));
+        }
+    }
+    for (int i = 0; i < PERIODS; i++) {
+        CheckPulse(0, i, 1500, 0);
+        CheckPulse(1, i, 1000, 0);
+        CHECK(g_log[0].rise[i] == g_log[1].rise[i], "period %d rising edges differ", i);
+    }
+    CHECK(ServoPwmPeriodCnt() == PERIODS, "period count %u", ServoPwmPeriodCnt());
+}
+
+static void TestUpdate(void)
+{
+    uint64_t mid;
+
+    SimStart(0);
+    ServoPwmSet(0, 2000);
+    ServoPwmSet(1, 2000);
+    McuSimRunUntil((uint64_t)SERVO_PWM_PERIOD_US * 2 + 1);
+    /* 在第2个周期高电平期间修改，本周期不变，下一周期生效 */
+    mid = g_log[0].rise[1] + 700;
+    McuSimRunUntil(mid);
+    ServoPwmSet(0, 600);
+    ServoPwmSet(1, 2500);
+    McuSimRunUntil((uint64_t)SERVO_PWM_PERIOD_US * 5 + 1);
+
+    CheckPulse(0, 1, 2000, 0);
+    CheckPulse(1, 1, 2000, 0);
+    CheckPulse(0, 2, 600, 0);
+    CheckPulse(1, 2, 2500, 0);
+
+    /* 超出范围的脉宽被限幅，0表示停止输出 */
+    ServoPwmSet(0, 100);
+    ServoPwmSet(1, 0);
+    McuSimRunUntil((uint64_t)SERVO_PWM_PERIOD_US * 8 + 1);
+    CheckPulse(0, 5, SERVO_PWM_PULSE_MIN_US, 0);
+    CHECK(g_log[1].riseNum == 5, "ch1 still pulsing after stop: %d", g_log[1].riseNum);
+}
+
+static void TestLatency(void)
+{
+    const uint32_t lat = 15;
+
+    /* 每次中断都晚lat执行：脉宽和周期误差不超过一次延迟，且不随周期累积 */
+    SimStart(lat);
+    ServoPwmSet(0, 1200);
+    ServoPwmSet(1, 1800);
+    McuSimRunUntil((uint64_t)SERVO_PWM_PERIOD_US * (PERIODS + 1) - 1);
+
+    for (int i = 0; i < g_log[0].riseNum && i < PERIODS; i++) {
+        CheckPulse(0, i, 1200, lat);
+        CheckPulse(1, i, 1800, lat);
+    }
+    for (int i = 1; i < g_log[0].riseNum; i++) {
+        long len = (long)(g_log[0].rise[i] - g_log[0].rise[i - 1]);
+        CHECK(labs(len - SERVO_PWM_PERIOD_US) <= (long)(lat * (SERVO_PWM_CH_NUM + 1)), "period %d len %ld", i, len);
+    }
+}
+
+static void TestAngle(void)
+{
+    CHECK(ServoPwmAngleToPulse(0, 180) == SERVO_PWM_PULSE_MIN_US, "0 deg");
+    CHECK(ServoPwmAngleToPulse(9000, 180) == 1500, "90/180 deg");
+    CHECK(ServoPwmAngleToPulse(27000, 270) == SERVO_PWM_PULSE_MAX_US, "270/270 deg");
+}
+
+int main(void)
+{
+    TestSteady();
+    TestUpdate();
+    TestLatency();
+    TestAngle();
+    printf("servo_pwm_sim: %s (%d failures)\n", g_failCnt ? "FAIL" : "PASS", g_failCnt);
+    return g_failCnt ? EXIT_FAILURE : EXIT_SUCCESS;
+}
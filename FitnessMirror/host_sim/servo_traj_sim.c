@@ -0,0 +1,129 @@
+/*
+ * 舵机轨迹的主机端仿真：servo_traj.c挂在servo_pwm.c的周期上运行，每个PWM周期采样输出角度，
+ * 检查速度/加速度不超过各轴上限、到达目标不过冲、目标中途反向时先减速再折返。
+ *
+ * Host simulation of the servo trajectory: servo_traj.c runs on the servo_pwm.c period and the output angle
+ * is sampled every PWM period, checking the per-axis speed/acceleration limits, arrival without overshoot,
+ * and that a target reversal mid-move decelerates before turning back.
+ */
+#include <stdlib.h>
+
+#include "mcu_sim.h"
+#include "servo_pwm.h"
+#include "servo_traj.h"
+
+#define SAMPLE_MAX      600
+#define PERIOD_S        ((double)SERVO_PWM_PERIOD_US / 1000000.0)
+#define CDEG_PER_DEG    100.0
+#define LIMIT_SLACK     1.02 // Q8 rounding of the limits and of the reported angle
+
+static const ServoTrajCfg g_cfg[SERVO_TRAJ_AXIS_NUM] = {
+    { 300, 1500, 0, 27000, 270 },
+    { 200, 1000, 8000, 16000, 180 },
+};
+static int g_failCnt = 0;
+
+#define CHECK(cond, fmt, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: " fmt "\n", __FUNCTION__, __LINE__, ##__VA_ARGS__); \
+        g_failCnt++; \
+    } \
+} while (0)
+
+static void SimStart(uint16_t pan, uint16_t tilt)
+{
+    static const pin_t pins[SERVO_PWM_CH_NUM] = { GPIO_10, GPIO_12 };
+    const uint16_t pos[SERVO_TRAJ_AXIS_NUM] = { pan, tilt };
+
+    McuSimReset();
+    ServoTrajInit(g_cfg, pos);
+    CHECK(ServoPwmInit(pins) == 0, "init");
+}
+
+/*
+ * 跑n个周期，把轴axis每周期的输出角度写进out
+ * Run n periods and store the output angle of axis into out once per period
+ */
+static void Run(uint8_t axis, double out[], int n)
+{
+    for (int i = 0; i < n; i++) {
+        McuSimRunUntil(McuSimNowUs() + SERVO_PWM_PERIOD_US);
+        out[i] = ServoTrajPos(axis);
+    }
+}
+
+/*
+ * 检查一段采样的速度和加速度，取样的第一个点之前视为静止于prev
+ * Check speed and acceleration of a run of samples, starting at rest at prev
+ */
+static void CheckLimits(uint8_t axis, double prev, const double pos[], int n)
+{
+    double vMax = g_cfg[axis].velMax * CDEG_PER_DEG * PERIOD_S * LIMIT_SLACK;
+    double aMax = g_cfg[axis].accMax * CDEG_PER_DEG * PERIOD_S * PERIOD_S * LIMIT_SLACK + 2; // +2: rounding
+    double lastVel = 0;
+
+    for (int i = 0; i < n; i++) {
+        double vel = pos[i] - prev;
+        CHECK(vel <= vMax && vel >= -vMax, "axis%u step %d speed %.1f > %.1f cdeg/period", axis, i, vel, vMax);
+        CHECK(vel - lastVel <= aMax && vel - lastVel >= -aMax,
+            "axis%u step %d accel %.1f > %.1f", axis, i, vel - lastVel, aMax);
+        lastVel = vel;
+        prev = pos[i];
+    }
+}
+
+static void TestMove(void)
+{
+    static double pos[SAMPLE_MAX];
+    uint16_t target;
+    int n = 100; // 2 s, enough for 180 deg at 300 deg/s
+
+    SimStart(9000, 14000);
+    target = ServoTrajSetTarget(0, 27000);
+    CHECK(target == 27000, "pan target %u", target);
+    Run(0, pos, n);
+    CheckLimits(0, 9000, pos, n);
+    for (int i = 0; i < n; i++) {
+        CHECK(pos[i] <= 27000, "pan overshoot %.0f at %d", pos[i], i);
+    }
+    CHECK(pos[n - 1] == 27000, "pan did not arrive: %.0f", pos[n - 1]);
+    CHECK(ServoTrajPos(1) == 14000, "tilt moved: %u", ServoTrajPos(1));
+}
+
+static void TestClampAndReverse(void)
+{
+    static double pos[SAMPLE_MAX];
+    int half = 20;
+    int n = 150;
+
+    SimStart(9000, 14000);
+    CHECK(ServoTrajSetTarget(1, 2000) == 8000, "tilt not clamped to min");
+    Run(1, pos, half);
+    /* 反向时仍在向下运动，必须先减速 */
+    ServoTrajSetTarget(1, 16000);
+    Run(1, pos + half, n - half);
+    CheckLimits(1, 14000, pos, n);
+    CHECK(pos[n - 1] == 16000, "tilt did not arrive: %.0f", pos[n - 1]);
+    for (int i = 0; i < n; i++) {
+        CHECK(pos[i] >= 8000 && pos[i] <= 16000, "tilt out of range %.0f at %d", pos[i], i);
+    }
+}
+
+static void TestToZero(void)
+{
+    static double pos[SAMPLE_MAX];
+
+    SimStart(13500, 9000);
+    ServoTrajSetTarget(0, 0);
+    Run(0, pos, 100);
+    CHECK(pos[99] == 0, "pan did not reach 0: %.0f", pos[99]);
+}
+
+int main(void)
+{
+    TestMove();
+    TestClampAndReverse();
+    TestToZero();
+    printf("servo_traj_sim: %s (%d failures)\n", g_failCnt ? "FAIL" : "PASS", g_failCnt);
+    return g_failCnt ? EXIT_FAILURE : EXIT_SUCCESS;
+}
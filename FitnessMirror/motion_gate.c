@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件用IVE硬件做帧差运动检测，场景静止时降低NNIE推理频率，降低长时间运行的功耗和温升
+ *
+ * This file uses the IVE engine for frame difference motion detection, so NNIE inference is throttled
+ * while the scene is still, cutting power and heat over long sessions.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "sample_media_ai.h"
+#include "ive_img.h"
+#include "motion_gate.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define SAD_BLK_SIZE        16 // IVE_SAD_MODE_MB_16X16
+#define IVE_QUERY_SLEEP_US  100
+
+static const MotionGateCfg g_motionGateCfgDef = {
+    .pixDiff = 6,
+    .blkMin = 3,
+    .idleFrm = 30,
+    .idleInterval = 10,
+};
+
+static HI_S32 IveWait(IVE_HANDLE handle)
+{
+    HI_BOOL finish = HI_FALSE;
+    HI_S32 ret;
+
+    while ((ret = HI_MPI_IVE_Query(handle, &finish, HI_TRUE)) == HI_ERR_IVE_QUERY_TIMEOUT) {
+        usleep(IVE_QUERY_SLEEP_US);
+    }
+    return ret;
+}
+
+int MotionGateInit(MotionGate* self, HI_U32 width, HI_U32 height, const MotionGateCfg* cfg)
+{
+    int ret;
+
+    HI_ASSERT(self);
+    if (memset_s(self, sizeof(*self), 0, sizeof(*self)) != EOK) {
+        HI_ASSERT(0);
+    }
+    self->cfg = cfg ? *cfg : g_motionGateCfgDef;
+
+    ret = IveImgCreate(&self->prev, IVE_IMAGE_TYPE_U8C1, width, height);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "motion gate prev img create FAIL, ret=%#x\n", ret);
+    ret = IveImgCreate(&self->sad, IVE_IMAGE_TYPE_U16C1, width / SAD_BLK_SIZE, height / SAD_BLK_SIZE);
+    SAMPLE_CHECK_EXPR_GOTO(ret != HI_SUCCESS, FAIL0, "motion gate sad img create FAIL, ret=%#x\n", ret);
+    ret = IveImgCreate(&self->thr, IVE_IMAGE_TYPE_U8C1, width / SAD_BLK_SIZE, height / SAD_BLK_SIZE);
+    SAMPLE_CHECK_EXPR_GOTO(ret != HI_SUCCESS, FAIL1, "motion gate thr img create FAIL, ret=%#x\n", ret);
+
+    self->ready = HI_TRUE;
+    SAMPLE_PRT("motion gate %ux%u: pixDiff=%u blkMin=%u/%u idleFrm=%u idleInterval=%u\n", width, height,
+        self->cfg.pixDiff, self->cfg.blkMin, self->thr.u32Width * self->thr.u32Height,
+        self->cfg.idleFrm, self->cfg.idleInterval);
+    return HI_SUCCESS;
+
+FAIL1:
+    IveImgDestroy(&self->sad);
+FAIL0:
+    IveImgDestroy(&self->prev);
+    return ret;
+}
+
+void MotionGateDeinit(MotionGate* self)
+{
+    HI_ASSERT(self);
+    if (self->ready) {
+        IveImgDestroy(&self->thr);
+        IveImgDestroy(&self->sad);
+        IveImgDestroy(&self->prev);
+        self->ready = HI_FALSE;
+    }
+}
+
+/*
+ * 当前帧与上一帧做SAD，并把当前帧亮度DMA到prev，两个任务顺序提交、一次等待
+ * SAD the current frame against the previous one and DMA the current luma into prev,
+ * both tasks are queued in order and waited for once
+ */
+static HI_S32 MotionGateSad(MotionGate* self, const VIDEO_FRAME_INFO_S* frm)
+{
+    IVE_IMAGE_S cur;
+    IVE_DATA_S dmaSrc, dmaDst;
+    IVE_SAD_CTRL_S sadCtrl;
+    IVE_DMA_CTRL_S dmaCtrl;
+    IVE_HANDLE handle;
+    HI_S32 ret;
+
+    if (memset_s(&cur, sizeof(cur), 0, sizeof(cur)) != EOK) {
+        HI_ASSERT(0);
+    }
+    cur.enType = IVE_IMAGE_TYPE_U8C1;
+    cur.au64PhyAddr[0] = frm->stVFrame.u64PhyAddr[0];
+    cur.au32Stride[0] = frm->stVFrame.u32Stride[0];
+    cur.u32Width = self->prev.u32Width;
+    cur.u32Height = self->prev.u32Height;
+
+    if (self->prevValid) {
+        if (memset_s(&sadCtrl, sizeof(sadCtrl), 0, sizeof(sadCtrl)) != EOK) {
+            HI_ASSERT(0);
+        }
+        sadCtrl.enMode = IVE_SAD_MODE_MB_16X16;
+        sadCtrl.enOutCtrl = IVE_SAD_OUT_CTRL_16BIT_BOTH; // 16 bit block sums, 255 * 16 * 16 still fits
+        sadCtrl.u16Thr = (HI_U16)(self->cfg.pixDiff * SAD_BLK_SIZE * SAD_BLK_SIZE);
+        sadCtrl.u8MinVal = 0;
+        sadCtrl.u8MaxVal = 1;
+        ret = HI_MPI_IVE_SAD(&handle, &cur, &self->prev, &self->sad, &self->thr, &sadCtrl, HI_FALSE);
+        SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_IVE_SAD FAIL, ret=%#x\n", ret);
+    }
+
+    dmaSrc.u64PhyAddr = cur.au64PhyAddr[0];
+    dmaSrc.u64VirAddr = 0;
+    dmaSrc.u32Stride = cur.au32Stride[0];
+    dmaSrc.u32Width = cur.u32Width;
+    dmaSrc.u32Height = cur.u32Height;
+    dmaDst.u64PhyAddr = self->prev.au64PhyAddr[0];
+    dmaDst.u64VirAddr = self->prev.au64VirAddr[0];
+    dmaDst.u32Stride = self->prev.au32Stride[0];
+    dmaDst.u32Width = cur.u32Width;
+    dmaDst.u32Height = cur.u32Height;
+    if (memset_s(&dmaCtrl, sizeof(dmaCtrl), 0, sizeof(dmaCtrl)) != EOK) {
+        HI_ASSERT(0);
+    }
+    dmaCtrl.enMode = IVE_DMA_MODE_DIRECT_COPY;
+    ret = HI_MPI_IVE_DMA(&handle, &dmaSrc, &dmaDst, &dmaCtrl, HI_TRUE);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_IVE_DMA FAIL, ret=%#x\n", ret);
+    return IveWait(handle);
+}
+
+static HI_U32 MotionGateCountMoved(const MotionGate* self)
+{
+    const HI_U8 *row = (const HI_U8*)(uintptr_t)self->thr.au64VirAddr[0];
+    HI_U32 moved = 0;
+
+    for (HI_U32 y = 0; y < self->thr.u32Height; y++) {
+        for (HI_U32 x = 0; x < self->thr.u32Width; x++) {
+            moved += row[x];
+        }
+        row += self->thr.au32Stride[0];
+    }
+    return moved;
+}
+
+HI_BOOL MotionGatePass(MotionGate* self, const VIDEO_FRAME_INFO_S* frm)
+{
+    HI_BOOL hadPrev = self->prevValid;
+    HI_U32 moved;
+
+    if (!self->ready) {
+        return HI_TRUE;
+    }
+    __atomic_fetch_add(&self->checkCnt, 1, __ATOMIC_RELAXED);
+    if (frm->stVFrame.u32Width < self->prev.u32Width || frm->stVFrame.u32Height < self->prev.u32Height ||
+        MotionGateSad(self, frm) != HI_SUCCESS) {
+        self->prevValid = HI_FALSE;
+        self->idleCnt = 0;
+        return HI_TRUE;
+    }
+    self->prevValid = HI_TRUE;
+    if (!hadPrev) {
+        return HI_TRUE;
+    }
+
+    moved = MotionGateCountMoved(self);
+    __atomic_store_n(&self->movedBlk, moved, __ATOMIC_RELAXED);
+    if (moved >= self->cfg.blkMin) {
+        self->idleCnt = 0;
+        return HI_TRUE;
+    }
+    if (++self->idleCnt <= self->cfg.idleFrm ||
+        (self->cfg.idleInterval != 0 && (self->idleCnt - self->cfg.idleFrm) % self->cfg.idleInterval == 0)) {
+        return HI_TRUE;
+    }
+    __atomic_fetch_add(&self->skipCnt, 1, __ATOMIC_RELAXED);
+    return HI_FALSE;
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include "hi_type.h"
+#include "hi_comm_video.h"
+#include "hi_comm_ive.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 运动门限参数
+ * Motion gate thresholds
+ */
+typedef struct MotionGateCfg {
+    HI_U8 pixDiff; // Mean absolute luma difference over a 16x16 block that counts as moved
+    HI_U32 blkMin; // Moved blocks needed for the frame to count as moving
+    HI_U32 idleFrm; // Frames without motion before inference is throttled
+    HI_U32 idleInterval; // While throttled, still infer one frame out of this many
+} MotionGateCfg;
+
+/*
+ * 基于IVE SAD的运动门控：当前帧亮度与上一帧按16x16块做SAD，
+ * 静止一段时间后只按固定间隔放行推理，有运动立即恢复每帧推理
+ *
+ * Motion gate based on IVE SAD: the luma of the current frame is compared with the previous one
+ * in 16x16 blocks. After the scene has been still for a while inference is only let through at a fixed
+ * interval, any motion brings back inference on every frame
+ */
+typedef struct MotionGate {
+    MotionGateCfg cfg;
+    IVE_IMAGE_S prev; // U8C1 copy of the previous luma plane
+    IVE_IMAGE_S sad; // U16C1 per block sum of absolute differences
+    IVE_IMAGE_S thr; // U8C1 per block result, 1 for moved blocks
+    HI_BOOL ready;
+    HI_BOOL prevValid;
+    HI_U32 idleCnt; // Frames in a row without motion
+    HI_U32 movedBlk; // Moved blocks of the latest frame
+    HI_U32 checkCnt; // Frames checked, read and cleared by the stats printer
+    HI_U32 skipCnt; // Frames kept from inference, read and cleared by the stats printer
+} MotionGate;
+
+/*
+ * 按width x height亮度平面分配IVE图像，cfg为NULL时使用默认门限
+ * Allocate the IVE images for a width x height luma plane, default thresholds when cfg is NULL
+ */
+int MotionGateInit(MotionGate* self, HI_U32 width, HI_U32 height, const MotionGateCfg* cfg);
+
+void MotionGateDeinit(MotionGate* self);
+
+/*
+ * 检查frm相对上一帧是否有运动，返回本帧是否需要推理；未初始化或IVE出错时总是放行
+ * Check frm for motion against the previous frame and return whether this frame needs inference.
+ * Always lets the frame through when not initialised or on IVE errors
+ */
+HI_BOOL MotionGatePass(MotionGate* self, const VIDEO_FRAME_INFO_S* frm);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件提供了流水线各级耗时的直方图。记录端只对桶做原子加，不加锁；
+ * 汇总端周期性地取走全部桶，算出p50/p99/max，供打印和统计端口使用。
+ *
+ * This file provides the per-stage latency histograms of the pipeline. Recording only does atomic adds
+ * on the buckets, without locks; the summary side periodically takes all buckets and computes
+ * p50/p99/max for the console and the stats port.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "sample_media_ai.h"
+#include "pipe_stats.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define US_PER_S            1000000
+#define NS_PER_US           1000
+#define US_PER_MS           1000
+#define PCT_50              50
+#define PCT_99              99
+#define PCT_ALL             100
+#define STATS_REPLY_MAX     1024
+#define STATS_REQ_MAX       64
+
+typedef struct PipeHist {
+    HI_U32 bucket[PIPE_HIST_BUCKETS];
+    HI_U32 max;
+} PipeHist;
+
+static PipeHist g_hist[PIPE_STAGE_NUM];
+static PipeStageSum g_sum[PIPE_STAGE_NUM]; // Latest window, under g_sumLock
+static HI_U32 g_sumWindowMs;
+static HI_U64 g_rollUs;
+static pthread_mutex_t g_sumLock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char* const g_stageName[PIPE_STAGE_NUM] = {
+    "vpss", "resize", "toimg", "yolo", "ctrl", "uart", "infer", "venc", "udp",
+};
+
+HI_U64 PipeStatsNowUs(HI_VOID)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (HI_U64)ts.tv_sec * US_PER_S + (HI_U64)ts.tv_nsec / NS_PER_US;
+}
+
+/*
+ * 小于PIPE_HIST_SUB的值每个值一个桶，之后按最高位所在的2的幂区间和其下3位定桶
+ * Values below PIPE_HIST_SUB get a bucket each, above that the bucket is the power of two range
+ * of the top bit and the 3 bits below it
+ */
+static HI_U32 PipeHistIndex(HI_U32 v)
+{
+    HI_U32 e;
+
+    if (v < PIPE_HIST_SUB) {
+        return v;
+    }
+    e = 31 - (HI_U32)__builtin_clz(v); // 31: index of the top bit
+    return (e - PIPE_HIST_SUB_BITS + 1) * PIPE_HIST_SUB + ((v >> (e - PIPE_HIST_SUB_BITS)) & (PIPE_HIST_SUB - 1));
+}
+
+/*
+ * 桶内的最大值
+ * Largest value that falls into the bucket
+ */
+static HI_U32 PipeHistUpper(HI_U32 idx)
+{
+    HI_U32 shift;
+
+    if (idx < PIPE_HIST_SUB) {
+        return idx;
+    }
+    shift = idx / PIPE_HIST_SUB - 1;
+    return (((PIPE_HIST_SUB + idx % PIPE_HIST_SUB) << shift) - 1) + (1U << shift);
+}
+
+HI_VOID PipeStatsAdd(PipeStage stage, HI_U64 us)
+{
+    PipeHist *h = &g_hist[stage];
+    HI_U32 v = us > UINT32_MAX ? UINT32_MAX : (HI_U32)us;
+    HI_U32 max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+
+    __atomic_fetch_add(&h->bucket[PipeHistIndex(v)], 1, __ATOMIC_RELAXED);
+    while (v > max && !__atomic_compare_exchange_n(&h->max, &max, v, HI_FALSE,
+        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+HI_VOID PipeStatsFrmAge(PipeStage stage, HI_U64 pts)
+{
+    HI_U64 now = 0;
+
+    if (pts != 0 && HI_MPI_SYS_GetCurPTS(&now) == HI_SUCCESS && now >= pts && now - pts < US_PER_S) {
+        PipeStatsAdd(stage, now - pts);
+    }
+}
+
+/*
+ * 取走一个直方图并汇总，被取走期间新到的样本落入下一个窗口
+ * Take one histogram and summarize it, samples arriving meanwhile land in the next window
+ */
+static HI_VOID PipeHistTake(PipeHist* h, PipeStageSum* sum)
+{
+    static HI_U32 cnts[PIPE_HIST_BUCKETS];
+    HI_U32 rank50, rank99;
+    HI_U32 acc = 0;
+
+    sum->cnt = 0;
+    for (HI_U32 i = 0; i < PIPE_HIST_BUCKETS; i++) {
+        cnts[i] = __atomic_exchange_n(&h->bucket[i], 0, __ATOMIC_RELAXED);
+        sum->cnt += cnts[i];
+    }
+    sum->max = __atomic_exchange_n(&h->max, 0, __ATOMIC_RELAXED);
+    sum->p50 = 0;
+    sum->p99 = 0;
+    if (sum->cnt == 0) {
+        return;
+    }
+
+    rank50 = (HI_U32)(((HI_U64)sum->cnt * PCT_50 + PCT_ALL - 1) / PCT_ALL);
+    rank99 = (HI_U32)(((HI_U64)sum->cnt * PCT_99 + PCT_ALL - 1) / PCT_ALL);
+    for (HI_U32 i = 0; i < PIPE_HIST_BUCKETS; i++) {
+        HI_U32 upper = PipeHistUpper(i) < sum->max ? PipeHistUpper(i) : sum->max;
+        acc += cnts[i];
+        if (sum->p50 == 0 && acc >= rank50) {
+            sum->p50 = upper;
+        }
+        if (acc >= rank99) {
+            sum->p99 = upper;
+            break;
+        }
+    }
+}
+
+HI_VOID PipeStatsRoll(HI_VOID)
+{
+    PipeStageSum sum[PIPE_STAGE_NUM];
+    HI_U64 now = PipeStatsNowUs();
+
+    for (int i = 0; i < PIPE_STAGE_NUM; i++) {
+        PipeHistTake(&g_hist[i], &sum[i]);
+    }
+    pthread_mutex_lock(&g_sumLock);
+    if (memcpy_s(g_sum, sizeof(g_sum), sum, sizeof(sum)) != EOK) {
+        HI_ASSERT(0);
+    }
+    g_sumWindowMs = g_rollUs == 0 ? 0 : (HI_U32)((now - g_rollUs) / US_PER_MS);
+    g_rollUs = now;
+    pthread_mutex_unlock(&g_sumLock);
+}
+
+HI_VOID PipeStatsGet(PipeStageSum sum[PIPE_STAGE_NUM], HI_U32* windowMs)
+{
+    pthread_mutex_lock(&g_sumLock);
+    if (memcpy_s(sum, sizeof(g_sum), g_sum, sizeof(g_sum)) != EOK) {
+        HI_ASSERT(0);
+    }
+    *windowMs = g_sumWindowMs;
+    pthread_mutex_unlock(&g_sumLock);
+}
+
+int PipeStatsFormat(char* buf, int size)
+{
+    PipeStageSum sum[PIPE_STAGE_NUM];
+    HI_U32 windowMs;
+    int len;
+    int n;
+
+    PipeStatsGet(sum, &windowMs);
+    len = snprintf(buf, size, "window %ums, us: cnt p50 p99 max\n", windowMs);
+    for (int i = 0; i < PIPE_STAGE_NUM && len >= 0 && len < size; i++) {
+        n = snprintf(buf + len, size - len, "%-6s %5u %7u %7u %7u\n",
+            g_stageName[i], sum[i].cnt, sum[i].p50, sum[i].p99, sum[i].max);
+        len = n < 0 ? n : len + n;
+    }
+    return len < 0 ? 0 : (len < size ? len : size - 1);
+}
+
+int PipeStatsServeOpen(HI_U16 port)
+{
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) {
+        SAMPLE_PRT("stats socket FAIL, errno=%d\n", errno);
+        return -1;
+    }
+    if (memset_s(&addr, sizeof(addr), 0, sizeof(addr)) != EOK) {
+        HI_ASSERT(0);
+    }
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = INADDR_ANY;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        SAMPLE_PRT("stats bind %u FAIL, errno=%d\n", port, errno);
+        close(fd);
+        return -1;
+    }
+    SAMPLE_PRT("pipeline stats on udp port %u\n", port);
+    return fd;
+}
+
+HI_VOID PipeStatsServe(int fd)
+{
+    char req[STATS_REQ_MAX];
+    char reply[STATS_REPLY_MAX];
+    struct sockaddr_in peer;
+    socklen_t peerLen = sizeof(peer);
+    int len;
+
+    if (recvfrom(fd, req, sizeof(req), MSG_DONTWAIT, (struct sockaddr*)&peer, &peerLen) < 0) {
+        return;
+    }
+    len = PipeStatsFormat(reply, sizeof(reply));
+    if (sendto(fd, reply, len, MSG_DONTWAIT, (struct sockaddr*)&peer, peerLen) < 0) {
+        SAMPLE_PRT("stats reply FAIL, errno=%d\n", errno);
+    }
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PIPE_STATS_H
+#define PIPE_STATS_H
+
+#include "hi_type.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 流水线各级耗时，单位us
+ * Time spent in each pipeline stage, us
+ */
+typedef enum PipeStage {
+    PIPE_STAGE_VPSS = 0, // Frame age when VPSS_CaptureTrd gets it, PTS to now
+    PIPE_STAGE_RESIZE, // VGS crop and scale of the ROI window
+    PIPE_STAGE_TO_IMG, // FrmToOrigImg
+    PIPE_STAGE_YOLO, // HandDetectCal
+    PIPE_STAGE_CTRL, // PID and the hand-over to the actuation thread
+    PIPE_STAGE_UART, // ServoLinkSend in the actuation thread
+    PIPE_STAGE_INFER, // Frame age when inference is done, PTS to now
+    PIPE_STAGE_VENC, // VencRingFill
+    PIPE_STAGE_UDP, // udpSend of one frame
+    PIPE_STAGE_NUM
+} PipeStage;
+
+/*
+ * 对数线性直方图：每个2的幂区间再均分为8个桶，相对误差不超过12.5%
+ * Log-linear histogram: each power of two range is split into 8 buckets, relative error at most 12.5%
+ */
+#define PIPE_HIST_SUB_BITS      3
+#define PIPE_HIST_SUB           (1U << PIPE_HIST_SUB_BITS)
+#define PIPE_HIST_BUCKETS       ((32 - PIPE_HIST_SUB_BITS + 1) * PIPE_HIST_SUB)
+
+typedef struct PipeStageSum {
+    HI_U32 cnt;
+    HI_U32 p50;
+    HI_U32 p99;
+    HI_U32 max;
+} PipeStageSum;
+
+/*
+ * 当前时间(单调时钟，us)
+ * Current time on the monotonic clock, us
+ */
+HI_U64 PipeStatsNowUs(HI_VOID);
+
+/*
+ * 记录一次耗时，无锁，可在任意线程调用
+ * Record one sample, lock-free, callable from any thread
+ */
+HI_VOID PipeStatsAdd(PipeStage stage, HI_U64 us);
+
+/*
+ * 记录从t0(PipeStatsNowUs)到现在的耗时
+ * Record the time from t0 (PipeStatsNowUs) until now
+ */
+#define PIPE_STATS_SINCE(stage, t0)     PipeStatsAdd((stage), PipeStatsNowUs() - (t0))
+
+/*
+ * 记录帧从采集(PTS)到现在的时间
+ * Record the time from frame capture (PTS) until now
+ */
+HI_VOID PipeStatsFrmAge(PipeStage stage, HI_U64 pts);
+
+/*
+ * 把累计的样本汇总成一个新窗口并清空，由一个线程周期调用
+ * Summarize the samples collected so far into a new window and clear them, called periodically by one thread
+ */
+HI_VOID PipeStatsRoll(HI_VOID);
+
+/*
+ * 最近一个窗口的汇总
+ * Summary of the latest window
+ */
+HI_VOID PipeStatsGet(PipeStageSum sum[PIPE_STAGE_NUM], HI_U32* windowMs);
+
+/*
+ * 把最近一个窗口格式化为文本，每级一行，返回写入的长度
+ * Format the latest window as text, one line per stage, returns the length written
+ */
+int PipeStatsFormat(char* buf, int size);
+
+/*
+ * 打开统计端口(UDP)，任意数据报都会收到PipeStatsFormat的文本作为应答，返回fd
+ * Open the stats port (UDP), any datagram is answered with the PipeStatsFormat text, returns the fd
+ */
+int PipeStatsServeOpen(HI_U16 port);
+
+/*
+ * fd可读时调用，应答一个请求
+ * Call when fd is readable, answers one request
+ */
+HI_VOID PipeStatsServe(int fd);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
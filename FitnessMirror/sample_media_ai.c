@@ -13,17 +13,24 @@
  * limitations under the License.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // sendmmsg
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <signal.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/prctl.h>
+#include <sys/select.h>
+#include <poll.h>
 
 #include "hi_mipi_tx.h"
 #include "sdk.h"
@@ -37,6 +44,14 @@
 #include "hand_classify.h"
 #include "gpio_user.h"
 #include "uart_user.h"
+#include "venc_ring.h"
+#include "spsc_queue.h"
+#include "ai_event.h"
+#include "udp_frame.h"
+#include "udp_pacer.h"
+#include "motion_gate.h"
+#include "pipe_stats.h"
+#include "abr_ctrl.h"
 #include <arpa/inet.h>
 #include <sys/socket.h>
 
@@ -56,6 +71,41 @@ HI_S32 ai_fd = 0;
     #error "DEBUGMODE is not defined"
 #endif
 
+/*
+ * 1: VENC通道常驻接收，由VENC_StreamTrd按fd取流; 0: AI线程逐帧Start/StopRecvFrame抓拍
+ * 1: the VENC channel stays in receive mode and VENC_StreamTrd drains it by fd;
+ * 0: the AI thread snaps each frame with Start/StopRecvFrame
+ */
+#define VENC_STREAM_MODE      1
+#define VENC_STREAM_FPS       15 // Encoded frame rate in VENC_STREAM_MODE
+
+/*
+ * 码流格式(UDP_FRAME_CODEC_*)：JPEG逐帧独立编码；H.264/H.265帧间编码，同样画质下码率低得多，
+ * 便于多台镜子共用一个无线接入点，但丢帧后要等关键帧，需VENC_STREAM_MODE 1
+ *
+ * Stream format (UDP_FRAME_CODEC_*): JPEG codes every frame on its own. H.264/H.265 code between frames,
+ * at a much lower bitrate for the same quality so that several mirrors can share one access point,
+ * but a lost frame has to wait for a key frame. They need VENC_STREAM_MODE 1
+ */
+#define VENC_CODEC            UDP_FRAME_CODEC_JPEG
+#define VENC_GOP_S            2 // Seconds between I frames with H.264/H.265, bounds the recovery from a loss
+#define VENC_RC_KBPS_DIV      4 // CBR target is this fraction of the level's link rate, the rest absorbs I frames
+#define VENC_IDR_HOLD_US      200000 // IDR requests closer than this are merged, one loss may trigger several
+
+#if VENC_CODEC == UDP_FRAME_CODEC_H264
+#define VENC_PAYLOAD          PT_H264
+#elif VENC_CODEC == UDP_FRAME_CODEC_H265
+#define VENC_PAYLOAD          PT_H265
+#else
+#define VENC_PAYLOAD          PT_JPEG
+#endif
+#if VENC_CODEC != UDP_FRAME_CODEC_JPEG && VENC_STREAM_MODE != 1
+#error "H.264/H.265 streaming needs VENC_STREAM_MODE 1"
+#endif
+
+#define AI_FRM_QUEUE_DEPTH    2 // VPSS frames queued between capture and inference, power of two
+#define AI_TRD_MAX            16 // Threads started by main, joined at exit
+
 #define OBSTACLE_FRM_WIDTH      640
 #define OBSTACLE_FRM_HEIGHT     384
 
@@ -66,7 +116,21 @@ HI_S32 ai_fd = 0;
 // #define SERVER_IP               "192.168.137.1"
 // #define SERVER_PORT             8888
 // #define BROADCAST_PORT          9999
-#define MTU_USER                60000
+#define UDP_SEND_BATCH          8 // Fragments handed to one sendmmsg call, also the pacing granularity
+#define UDP_PACE_KBPS           12000 // Target video bitrate on the link, 0: unpaced
+#define UDP_PACE_BURST          (UDP_SEND_BATCH * UDP_FRAME_MTU)
+#define UDP_SNDBUF_MS           200 // SO_SNDBUF holds this much data at UDP_PACE_KBPS
+#define UDP_EAGAIN_WAIT_MS      20 // Wait for socket space before giving up the rest of a frame
+#define UDP_FEC_GROUP           8 // Data fragments per XOR parity fragment (12.5% overhead), 0: FEC off
+#define UDP_SEND_MSG_MAX        (UDP_SEND_BATCH * 2) // Data plus at most one parity per data fragment
+#define UART_ACK_READ_LEN       64
+#define PIPE_STATS_PORT         8899 // UDP port answering with the stage latency table
+#define PIPE_STATS_ROLL_S       5 // Latency window length, enough frames for a p99
+#if DEBUGMODE == 1
+#define PIPE_PRINT_S            1 // Seconds between counter prints of timerSleep
+#else
+#define PIPE_PRINT_S            PIPE_STATS_ROLL_S
+#endif
 
 // extern uint8_t audioBusy;
 uint8_t AiProcessStopFlag = 0;
@@ -75,6 +139,35 @@ uint8_t AiFlag = 0;
 // int8_t audioFlag = 0;
 
 static unsigned char g_mBuf[G_MBUF_LENGTH];
+static VencRing g_vencRing; // Encoded frame hand-off between VENC and UDP_TransferTrd
+static AiEvent g_stopEvent = { -1 }; // Set once at exit, wakes every thread
+static AiEvent g_inferEvent = { -1 }; // A frame was queued for AI_InferTrd
+static AiEvent g_sendEvent = { -1 }; // A frame was committed to g_vencRing
+static AiEvent g_slotEvent = { -1 }; // A slot of g_vencRing was released
+static AiEvent g_aiFlagEvent = { -1 }; // AiFlag was cleared
+static UdpPacer g_udpPacer; // Pacing and send queue accounting of udpSend
+static AbrCtrl g_abr; // Picks the level of g_abrLadder from the relay feedback
+static int g_abrPending = -1; // Level picked by timerSleep for VENC_StreamTrd to apply, -1: none
+static AiEvent g_abrEvent = { -1 }; // g_abrPending was set
+
+/*
+ * 码率自适应档位，从高到低；第0档即原来的固定配置(800x700、VENC_STREAM_FPS、QFactor 90、UDP_PACE_KBPS)，
+ * 表的首尾就是允许调整的上下界。尺寸保持同一宽高比，且不超过第0档(VENC通道按第0档创建)
+ *
+ * Bitrate adaptation levels, best first. Level 0 is the former fixed setup (800x700, VENC_STREAM_FPS,
+ * QFactor 90, UDP_PACE_KBPS), and the first and last entries are the bounds of the adjustment.
+ * Sizes keep one aspect ratio and never exceed level 0, the VENC channel is created at level 0.
+ */
+static const AbrLevel g_abrLadder[] = {
+    { 800, 700, VENC_STREAM_FPS, 90, UDP_PACE_KBPS },
+    { 800, 700, VENC_STREAM_FPS, 75, 10000 },
+    { 800, 700, 12, 65, 8000 },
+    { 640, 560, 12, 65, 6000 },
+    { 640, 560, 10, 55, 5000 },
+    { 480, 420, 10, 55, 3500 },
+    { 480, 420, 8, 45, 2500 },
+    { 320, 280, 8, 45, 1500 },
+};
 static SampleVoModeMux g_sampleVoModeMux = {0};
 static VO_PUB_ATTR_S stVoPubAttr = {0};
 static VO_VIDEO_LAYER_ATTR_S  stLayerAttr    = {0};
@@ -1742,8 +1835,8 @@ HI_VOID ViPramCfg(HI_VOID)
 static HI_VOID StVbParamCfg(VbCfg *self)
 {
     memset_s(&aicMediaInfo.vbCfg, sizeof(VB_CONFIG_S), 0, sizeof(VB_CONFIG_S));
-    // 2: The number of buffer pools that can be accommodated in the entire system
-    self->u32MaxPoolCnt              = 2;
+    // 4: The number of buffer pools that can be accommodated in the entire system
+    self->u32MaxPoolCnt              = 4;
 
     /*Get picture buffer size*/
     aicMediaInfo.u32BlkSize = COMMON_GetPicBufferSize(aicMediaInfo.stSize.u32Width, aicMediaInfo.stSize.u32Height,
@@ -1758,6 +1851,18 @@ static HI_VOID StVbParamCfg(VbCfg *self)
     self->astCommPool[1].u64BlkSize  = aicMediaInfo.u32BlkSize;
     // 4: Number of cache blocks per cache pool. Value range: (0, 10240]
     self->astCommPool[1].u32BlkCnt   = 4;
+
+    /*Get inference channel buffer size*/
+    self->astCommPool[2].u64BlkSize  = COMMON_GetPicBufferSize(OBSTACLE_FRM_WIDTH, OBSTACLE_FRM_HEIGHT,
+        PIXEL_FORMAT_YVU_SEMIPLANAR_420, DATA_BITWIDTH_8, COMPRESS_MODE_NONE, DEFAULT_ALIGN);
+    // 4: VPSS channel depth(2) + frame being written + frame in inference, plus the queued ones
+    self->astCommPool[2].u32BlkCnt   = 4 + AI_FRM_QUEUE_DEPTH;
+
+    /*Get VENC channel buffer size, sized for the largest level*/
+    self->astCommPool[3].u64BlkSize  = COMMON_GetPicBufferSize(g_abrLadder[0].width, g_abrLadder[0].height,
+        PIXEL_FORMAT_YVU_SEMIPLANAR_420, DATA_BITWIDTH_8, COMPRESS_MODE_NONE, DEFAULT_ALIGN);
+    // 4: frame being written + frames queued in and being encoded by the bound VENC
+    self->astCommPool[3].u32BlkCnt   = 4;
 }
 
 static HI_VOID StVoParamCfg(VoCfg *self)
@@ -1778,55 +1883,128 @@ static HI_VOID VpssParamCfg(HI_VOID)
         aicMediaInfo.stSize.u32Width, aicMediaInfo.stSize.u32Width);
     aicMediaInfo.vpssCfg.grpAttr.enPixelFormat = PIXEL_FORMAT_YVU_SEMIPLANAR_420;
     VpssCfgAddChn(&aicMediaInfo.vpssCfg, AIC_VPSS_ZOUT_CHN, NULL, AICSTART_VI_OUTWIDTH, AICSTART_VI_OUTHEIGHT);
+    /* Inference input is scaled by the VPSS hardware, no VGS job per frame */
+    VpssCfgAddChn(&aicMediaInfo.vpssCfg, AIC_VPSS_INFER_CHN, NULL, OBSTACLE_FRM_WIDTH, OBSTACLE_FRM_HEIGHT);
+    /* The stream is scaled by the VPSS as well, so the bitrate controller can change its size at runtime */
+    VpssCfgAddChn(&aicMediaInfo.vpssCfg, AIC_VPSS_VENC_CHN, NULL, g_abrLadder[0].width,
+        g_abrLadder[0].height)->u32Depth = 0; // 0: only the bound VENC takes its frames
     HI_ASSERT(!aicMediaInfo.viSess);
 }
 
 
-static HI_VOID HandDetectAiProcess(VIDEO_FRAME_INFO_S frm, VO_LAYER voLayer, VO_CHN voChn)
+/*
+ * frm来自推理通道，已是OBSTACLE_FRM_WIDTH x OBSTACLE_FRM_HEIGHT，直接送入检测
+ * 跟踪到手时再不等待地取一帧通道0的全分辨率画面，供目标手附近的ROI检测使用
+ *
+ * frm comes from the inference channel and is already OBSTACLE_FRM_WIDTH x OBSTACLE_FRM_HEIGHT, so it goes
+ * straight into detection. While a hand is tracked, a full resolution picture is also taken from channel 0
+ * without waiting, for the ROI detection around the target hand
+ */
+static HI_VOID HandDetectAiProcess(VIDEO_FRAME_INFO_S frm)
 {
     int ret = 0;
-    VIDEO_FRAME_INFO_S resizeFrm;
+    VIDEO_FRAME_INFO_S fullFrm;
+    HI_BOOL fullGot = HI_FALSE;
 
-    ret = MppFrmResize(&frm, &resizeFrm, OBSTACLE_FRM_WIDTH, OBSTACLE_FRM_HEIGHT);  //vgs
-    if(ret < 0)
-    {
-        printf("MppFrmResize error.\n");
+    if (Yolo2HandDetectRoiWanted()) {
+        fullGot = HI_MPI_VPSS_GetChnFrame(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0, &fullFrm, 0) == HI_SUCCESS ?
+            HI_TRUE : HI_FALSE;
     }
 
-    ret = Yolo2HandDetectResnetClassifyCal(AiPlug.model, &resizeFrm, &frm);
-    SAMPLE_CHECK_EXPR_GOTO(ret < 0, RELEASE, "obstacle detect plug cal FAIL, ret=%#x\n", ret);
-
-#if DEBUGMODE == 1
-    if(ret > 0)
-    {
-        ret = HI_MPI_VO_SendFrame(voLayer, voChn, &frm, 0);
-        SAMPLE_CHECK_EXPR_GOTO(ret != HI_SUCCESS, RELEASE, "HI_MPI_VO_SendFrame fail, Error(%#x)\n", ret);
+    ret = Yolo2HandDetectResnetClassifyCal(AiPlug.model, &frm, fullGot ? &fullFrm : &frm);
+    if (ret < 0) {
+        SAMPLE_PRT("obstacle detect plug cal FAIL, ret=%#x\n", ret);
     }
-#endif
-    
-    MppFrmDestroy(&resizeFrm);
 
-RELEASE:
-    MppFrmDestroy(&resizeFrm);
-    ret = HI_MPI_VPSS_ReleaseChnFrame(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0, &frm);
+    if (fullGot) {
+        ret = HI_MPI_VPSS_ReleaseChnFrame(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0, &fullFrm);
+        if (ret != HI_SUCCESS) {
+            SAMPLE_PRT("Error(%#x),HI_MPI_VPSS_ReleaseChnFrame failed,Grp(%d) chn(%d)!\n",
+                ret, aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0);
+        }
+    }
+    ret = HI_MPI_VPSS_ReleaseChnFrame(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn1, &frm);
     if (ret != HI_SUCCESS) {
         SAMPLE_PRT("Error(%#x),HI_MPI_VPSS_ReleaseChnFrame failed,Grp(%d) chn(%d)!\n",
-            ret, aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0);
+            ret, aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn1);
     }
 }
 
-uint8_t FPS = 0;
-uint8_t jpegFlag = 0;
-static HI_VOID* GetVpssChnFrameHandDetect(void)
+/*
+ * 流水线各级的吞吐计数，每个计数只由一个线程累加，timerSleep每秒读出并清零
+ * Per-stage throughput counters, each one is only incremented by one thread,
+ * timerSleep reads and clears them every second
+ */
+typedef struct PipeStageCnt {
+    HI_U32 capture; // Frames got from VPSS by VPSS_CaptureTrd
+    HI_U32 captureDrop; // Frames given back to VPSS because the inference queue was full
+    HI_U32 infer; // Frames through the detector in AI_InferTrd
+    HI_U32 venc; // Streams moved into the ring by VENC_StreamTrd
+    HI_U32 send; // Frames sent by UDP_TransferTrd
+    HI_U32 idr; // IDR frames requested by the relay and passed to VENC
+} PipeStageCnt;
+
+static PipeStageCnt g_pipeCnt;
+static SpscQueue g_inferQueue; // VIDEO_FRAME_INFO_S handles, VPSS_CaptureTrd -> AI_InferTrd
+static MotionGate g_motionGate; // Throttles inference while the scene is still
+
+#define PIPE_CNT_INC(cnt)       __atomic_fetch_add(&(cnt), 1, __ATOMIC_RELAXED)
+#define PIPE_CNT_TAKE(cnt)      __atomic_exchange_n(&(cnt), 0, __ATOMIC_RELAXED)
+
+/*
+ * 采集级：从VPSS取帧放入推理队列，队满时直接归还，保证推理总拿到较新的帧
+ * Capture stage: get frames from VPSS into the inference queue,
+ * give them straight back when the queue is full so inference always works on recent frames
+ */
+static HI_VOID* VPSS_CaptureTrd(void)
 {
     int ret;
     VIDEO_FRAME_INFO_S frm;
     HI_S32 s32MilliSec = 2000;
-    VO_LAYER voLayer = 0;
-    VO_CHN voChn = 0;
-    uint8_t vencChn = 0;
-    VENC_RECV_PIC_PARAM_S stRecv;
-    stRecv.s32RecvPicNum = 1;
+
+    while (AI_FLAG_GET(AiProcessStopFlag) == 0) 
+    {
+        if(AI_FLAG_GET(AiFlag) != 0)
+        {
+            AiEventWait(&g_aiFlagEvent, &g_stopEvent, -1);
+            continue;
+        }
+
+        ret = HI_MPI_VPSS_GetChnFrame(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn1, &frm, s32MilliSec);
+        if (ret != 0) 
+        {
+            SAMPLE_PRT("HI_MPI_VPSS_GetChnFrame FAIL, err=%#x, grp=%d, chn=%d\n", ret, aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn1);
+            continue;
+        }
+        PIPE_CNT_INC(g_pipeCnt.capture);
+        PipeStatsFrmAge(PIPE_STAGE_VPSS, frm.stVFrame.u64PTS);
+
+        if (SpscQueuePush(&g_inferQueue, &frm) == HI_SUCCESS)
+        {
+            AiEventSignal(&g_inferEvent);
+        }
+        else
+        {
+            PIPE_CNT_INC(g_pipeCnt.captureDrop);
+            ret = HI_MPI_VPSS_ReleaseChnFrame(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn1, &frm);
+            if (ret != HI_SUCCESS) 
+            {
+                SAMPLE_PRT("Error(%#x),HI_MPI_VPSS_ReleaseChnFrame failed,Grp(%d) chn(%d)!\n",ret, aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn1);
+            }
+        }
+    }
+    pthread_exit(NULL);
+    return HI_NULL;
+}
+
+/*
+ * 推理级：检测、PID与串口下发，处理完归还VPSS帧
+ * Inference stage: detection, PID and UART output, gives the VPSS frame back when done
+ */
+static HI_VOID* AI_InferTrd(void)
+{
+    int ret;
+    VIDEO_FRAME_INFO_S frm;
 
     ret = Yolo2HandDetectResnetClassifyLoad(&AiPlug.model);
     if (ret < 0) 
@@ -1840,158 +2018,599 @@ static HI_VOID* GetVpssChnFrameHandDetect(void)
     {
         printf("Load yolo model success\n");
     }
-    SAMPLE_PRT("vpssGrp:%d, vpssChn0:%d\n", aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0);
+    SAMPLE_PRT("vpssGrp:%d, vpssChn1:%d\n", aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn1);
 
-    while (AiProcessStopFlag == 0) 
+    while (AI_FLAG_GET(AiProcessStopFlag) == 0) 
     {
-        if (jpegFlag == 0) 
+        if (SpscQueuePop(&g_inferQueue, &frm) != HI_SUCCESS)
         {
-            if(remove("p1.jpg") == 0)
-            {
-                stRecv.s32RecvPicNum = 1;
-                HI_MPI_VENC_StartRecvFrame(vencChn, &stRecv);
-                usleep(1000);
-                VENC_GetPic(vencChn, "p1.jpg");
-                usleep(1000);
-                HI_MPI_VENC_StopRecvFrame(vencChn);
-                usleep(500);
-                jpegFlag = 1;
-                FPS++;
-            }
-            else
-            {
-                printf("delete jpg fail\n");
-            }
+            AiEventWait(&g_inferEvent, &g_stopEvent, -1);
+            continue;
         }
-
-        if(AiFlag == 0)
+        if (MotionGatePass(&g_motionGate, &frm) == HI_FALSE)
         {
-            ret = HI_MPI_VPSS_GetChnFrame(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0, &frm, s32MilliSec);
-            if (ret != 0) 
-            {
-                SAMPLE_PRT("HI_MPI_VPSS_GetChnFrame FAIL, err=%#x, grp=%d, chn=%d\n", ret, aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0);
-                ret = HI_MPI_VPSS_ReleaseChnFrame(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0, &frm);
-                if (ret != HI_SUCCESS) 
-                {
-                    SAMPLE_PRT("Error(%#x),HI_MPI_VPSS_ReleaseChnFrame failed,Grp(%d) chn(%d)!\n",ret, aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0);
-                }
-                usleep(1500);
-                continue;
-            }
-            else
+            ret = HI_MPI_VPSS_ReleaseChnFrame(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn1, &frm);
+            if (ret != HI_SUCCESS) 
             {
-                HandDetectAiProcess(frm, voLayer, voChn);
+                SAMPLE_PRT("Error(%#x),HI_MPI_VPSS_ReleaseChnFrame failed,Grp(%d) chn(%d)!\n",ret, aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn1);
             }
+            continue;
         }
-        usleep(1500);
+        HandDetectAiProcess(frm);
+        PipeStatsFrmAge(PIPE_STAGE_INFER, frm.stVFrame.u64PTS);
+        PIPE_CNT_INC(g_pipeCnt.infer);
     }
     pthread_exit(NULL);
     return HI_NULL;
 }
 
+/*
+ * 归还推理队列中剩余的VPSS帧，须在采集与推理线程退出后调用
+ * Give the VPSS frames left in the inference queue back, call after the capture and inference threads exit
+ */
+static HI_VOID InferQueueFlush(HI_VOID)
+{
+    VIDEO_FRAME_INFO_S frm;
+    while (SpscQueuePop(&g_inferQueue, &frm) == HI_SUCCESS)
+    {
+        HI_MPI_VPSS_ReleaseChnFrame(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn1, &frm);
+    }
+}
+
+/*
+ * 设置编码帧率并让VENC通道常驻接收
+ * Set the encoding frame rate and keep the VENC channel in receive mode
+ */
+static HI_S32 VencStreamStart(VENC_CHN vencChn)
+{
+    HI_S32 ret;
+    HI_U32 snsFrmRate = 30;
+    VENC_CHN_PARAM_S chnParam;
+    VENC_RECV_PIC_PARAM_S stRecvParam;
+
+    SAMPLE_COMM_VI_GetFrameRateBySensor(aicMediaInfo.viCfg.astViInfo[0].stSnsInfo.enSnsType, &snsFrmRate);
+    ret = HI_MPI_VENC_GetChnParam(vencChn, &chnParam);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_GetChnParam FAIL, ret=%#x\n", ret);
+    chnParam.stFrameRate.s32SrcFrameRate = (HI_S32)snsFrmRate;
+    chnParam.stFrameRate.s32DstFrameRate = VENC_STREAM_FPS;
+    ret = HI_MPI_VENC_SetChnParam(vencChn, &chnParam);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_SetChnParam FAIL, ret=%#x\n", ret);
+
+    stRecvParam.s32RecvPicNum = -1; // -1: receive continuously until StopRecvFrame
+    ret = HI_MPI_VENC_StartRecvFrame(vencChn, &stRecvParam);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_StartRecvFrame FAIL, ret=%#x\n", ret);
+    SAMPLE_PRT("venc chn %d streaming at %d/%u fps\n", vencChn, VENC_STREAM_FPS, snsFrmRate);
+    return HI_SUCCESS;
+}
+
 static HI_VOID* UDP_TransferTrd(void)
 {
     int ret = 0;
-    long filesize = 0;
-    while(AiProcessStopFlag == 0)
+    VencFrmSlot *slot = NULL;
+    HI_U64 t0;
+    while(AI_FLAG_GET(AiProcessStopFlag) == 0)
     {
-        if(jpegFlag == 1)
+        slot = VencRingReadSlot(&g_vencRing);
+        if(slot != NULL)
         {
-            FILE *jpgFile = fopen("p1.jpg", "rb");
-            if (jpgFile == NULL)
+            t0 = PipeStatsNowUs();
+            ret = udpSend(slot->data, slot->len, slot->pts,
+                UDP_FRAME_CODEC(VENC_CODEC) | (slot->key ? UDP_FRAME_FLAG_KEY : 0));
+            if(ret == slot->len)
             {
-                jpegFlag = 0;
-                printf("failed to open jpgFile\r\n");
+                PIPE_STATS_SINCE(PIPE_STAGE_UDP, t0);
+                PIPE_CNT_INC(g_pipeCnt.send);
             }
             else
             {
-                /*get file size*/
-                fseek(jpgFile, 0, SEEK_END);
-                filesize = ftell(jpgFile);
-                fseek(jpgFile, 0, SEEK_SET);
-                if (filesize <= 0)
-                {
-                    jpegFlag = 0;
-                    printf("failed to get file size: %d\r\n", filesize);
-                }
-                else
-                {
-                    uint8_t *udpSendBuf = (uint8_t*)malloc(filesize);
-                    if(udpSendBuf == NULL)
-                    {
-                        printf("failed to allocate memory\r\n");
-                        fclose(jpgFile);
-                        jpegFlag = 0;
-                        continue;
-                    }
-                    size_t read_size = fread(udpSendBuf, 1, filesize, jpgFile);
-                    if(read_size != filesize) 
-                    {
-                        printf("failed to read file\r\n");
-                        free(udpSendBuf);
-                        fclose(jpgFile);
-                        jpegFlag = 0;
-                        continue;
-                    }
-                    jpegFlag = 0;
-
-                    ret = udpSend(udpSendBuf, filesize);
-                    if(ret == filesize)
-                    {
-                        printf("send %dB ok\n", ret);
-                    }
-                    else
-                    {
-                        printf("send fail, jpgsize: %d B, ret%d\n", filesize, ret);
-                    }
-
-                    free(udpSendBuf);
-                }
-                fclose(jpgFile);
+                printf("send fail, frame size: %u B, ret%d\n", slot->len, ret);
+            }
+            VencRingRelease(&g_vencRing);
+            AiEventSignal(&g_slotEvent);
+            continue;
+        }
+        AiEventWait(&g_sendEvent, &g_stopEvent, -1);
+    }
+    pthread_exit(NULL);
+}
+
+/*
+ * 按档位设置H.264/H.265的CBR码控：码率取档位链路速率的1/VENC_RC_KBPS_DIV，
+ * 帧率已由通道帧率控制降到档位帧率，码控的输入输出帧率都取档位帧率
+ *
+ * Set the H.264/H.265 CBR rate control for a level: the bitrate is 1/VENC_RC_KBPS_DIV of the level's link rate.
+ * The channel frame rate control already brings the input down to the level's rate, so the rate control
+ * takes it as both the source and the target frame rate
+ */
+static HI_VOID VencRcSet(VENC_RC_ATTR_S* rc, const AbrLevel* level)
+{
+    VENC_H264_CBR_S *cbr = VENC_PAYLOAD == PT_H265 ? &rc->stH265Cbr : &rc->stH264Cbr;
+
+    rc->enRcMode = VENC_PAYLOAD == PT_H265 ? VENC_RC_MODE_H265CBR : VENC_RC_MODE_H264CBR;
+    cbr->u32Gop = level->fps * VENC_GOP_S;
+    cbr->u32StatTime = 1; // 1: bitrate statistics window, in seconds
+    cbr->u32SrcFrameRate = level->fps;
+    cbr->fr32DstFrameRate = level->fps;
+    cbr->u32BitRate = level->kbps / VENC_RC_KBPS_DIV;
+}
+
+/*
+ * 创建H.264/H.265编码通道，最大尺寸取第0档，随后可在档位间切换
+ * Create the H.264/H.265 channel, its max size is level 0 so it can later move between levels
+ */
+static HI_S32 VencH26xStart(VENC_CHN vencChn, const AbrLevel* level)
+{
+    VENC_CHN_ATTR_S attr;
+    HI_S32 ret;
+
+    if(memset_s(&attr, sizeof(attr), 0, sizeof(attr)) != EOK)
+    {
+        HI_ASSERT(0);
+    }
+    attr.stVencAttr.enType = VENC_PAYLOAD;
+    attr.stVencAttr.u32MaxPicWidth = level->width;
+    attr.stVencAttr.u32MaxPicHeight = level->height;
+    attr.stVencAttr.u32PicWidth = level->width;
+    attr.stVencAttr.u32PicHeight = level->height;
+    attr.stVencAttr.u32BufSize = level->width * level->height * 3 / 2; // 3/2: one YUV420 picture
+    attr.stVencAttr.u32Profile = 0; // 0: baseline for H.264 (no B frames, decoded everywhere), main for H.265
+    attr.stVencAttr.bByFrame = HI_TRUE;
+    VencRcSet(&attr.stRcAttr, level);
+    ret = SAMPLE_COMM_VENC_GetGopAttr(VENC_GOPMODE_NORMALP, &attr.stGopAttr);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "SAMPLE_COMM_VENC_GetGopAttr FAIL, ret=%#x\n", ret);
+
+    ret = HI_MPI_VENC_CreateChn(vencChn, &attr);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_CreateChn(%d) FAIL, ret=%#x\n", vencChn, ret);
+    SAMPLE_PRT("venc chn %d: %s %ux%u gop %us %ukbps\n", vencChn, VENC_PAYLOAD == PT_H265 ? "h265" : "h264",
+        level->width, level->height, VENC_GOP_S, level->kbps / VENC_RC_KBPS_DIV);
+    return HI_SUCCESS;
+}
+
+/*
+ * 中继发现丢帧后请求关键帧，VENC_IDR_HOLD_US内的重复请求合并；JPEG每帧都是关键帧，忽略
+ * The relay asks for a key frame after a loss. Requests within VENC_IDR_HOLD_US are merged,
+ * and ignored with JPEG where every frame is a key frame
+ */
+static HI_VOID VencRequestIdr(void)
+{
+    static HI_U64 lastUs = 0;
+    HI_U64 nowUs = PipeStatsNowUs();
+    HI_S32 ret;
+
+    if(VENC_PAYLOAD == PT_JPEG || (lastUs != 0 && nowUs - lastUs < VENC_IDR_HOLD_US))
+    {
+        return;
+    }
+    lastUs = nowUs;
+    ret = HI_MPI_VENC_RequestIDR(aicMediaInfo.vencChn, HI_TRUE);
+    if(ret != HI_SUCCESS)
+    {
+        SAMPLE_PRT("HI_MPI_VENC_RequestIDR FAIL, ret=%#x\n", ret);
+        return;
+    }
+    PIPE_CNT_INC(g_pipeCnt.idr);
+}
+
+/*
+ * 改VPSS通道和VENC通道尺寸，调用前须已停止接收
+ * Resize both the VPSS channel and the VENC channel, receiving must be stopped before the call
+ */
+static HI_S32 AbrResize(VENC_CHN vencChn, const AbrLevel* to)
+{
+    VPSS_CHN_ATTR_S vpssAttr;
+    VENC_CHN_ATTR_S vencAttr;
+    HI_S32 ret;
+
+    ret = HI_MPI_VPSS_GetChnAttr(aicMediaInfo.vpssGrp, AIC_VPSS_VENC_CHN, &vpssAttr);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VPSS_GetChnAttr FAIL, ret=%#x\n", ret);
+    vpssAttr.u32Width = to->width;
+    vpssAttr.u32Height = to->height;
+    ret = HI_MPI_VPSS_SetChnAttr(aicMediaInfo.vpssGrp, AIC_VPSS_VENC_CHN, &vpssAttr);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VPSS_SetChnAttr FAIL, ret=%#x\n", ret);
+    ret = HI_MPI_VENC_GetChnAttr(vencChn, &vencAttr);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_GetChnAttr FAIL, ret=%#x\n", ret);
+    vencAttr.stVencAttr.u32PicWidth = to->width;
+    vencAttr.stVencAttr.u32PicHeight = to->height;
+    ret = HI_MPI_VENC_SetChnAttr(vencChn, &vencAttr);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_SetChnAttr FAIL, ret=%#x\n", ret);
+    return HI_MPI_VENC_ResetChn(vencChn);
+}
+
+/*
+ * 档位切换的一步：参数与from相同时什么都不做，失败时保持from不变或已尽量恢复
+ * One step of a level switch: does nothing when the parameter equals from's,
+ * on failure from's setting is kept or restored as far as possible
+ */
+typedef HI_S32 (*AbrStepFn)(VENC_CHN vencChn, const AbrLevel* to, const AbrLevel* from);
+
+/*
+ * 尺寸：先停止接收，改尺寸，失败时改回from的尺寸，再恢复接收
+ * Size: stop receiving, resize, resize back to from on failure, then resume receiving
+ */
+static HI_S32 AbrStepSize(VENC_CHN vencChn, const AbrLevel* to, const AbrLevel* from)
+{
+    HI_S32 ret;
+
+    if(to->width == from->width && to->height == from->height)
+    {
+        return HI_SUCCESS;
+    }
+#if VENC_STREAM_MODE == 1
+    VENC_RECV_PIC_PARAM_S stRecvParam;
+    HI_S32 recvRet;
+
+    ret = HI_MPI_VENC_StopRecvFrame(vencChn);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_StopRecvFrame FAIL, ret=%#x\n", ret);
+    ret = AbrResize(vencChn, to);
+    if(ret != HI_SUCCESS)
+    {
+        AbrResize(vencChn, from);
+    }
+    stRecvParam.s32RecvPicNum = -1; // -1: receive continuously until StopRecvFrame
+    recvRet = HI_MPI_VENC_StartRecvFrame(vencChn, &stRecvParam);
+    SAMPLE_CHECK_EXPR_RET(recvRet != HI_SUCCESS, recvRet, "HI_MPI_VENC_StartRecvFrame FAIL, ret=%#x\n", recvRet);
+#else
+    ret = AbrResize(vencChn, to); // Snap mode: called between two snaps, not receiving
+    if(ret != HI_SUCCESS)
+    {
+        AbrResize(vencChn, from);
+    }
+#endif
+    return ret;
+}
+
+/*
+ * 画质：JPEG改QFactor，H.264/H.265按档位设码控
+ * Quality: the QFactor with JPEG, the level's rate control with H.264/H.265
+ */
+static HI_S32 AbrStepQuality(VENC_CHN vencChn, const AbrLevel* to, const AbrLevel* from)
+{
+    VENC_JPEG_PARAM_S jpegParam;
+    VENC_CHN_ATTR_S vencAttr;
+    HI_S32 ret;
+
+    if(VENC_PAYLOAD == PT_JPEG && to->qfactor != from->qfactor)
+    {
+        ret = HI_MPI_VENC_GetJpegParam(vencChn, &jpegParam);
+        SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_GetJpegParam FAIL, ret=%#x\n", ret);
+        jpegParam.u32Qfactor = to->qfactor;
+        ret = HI_MPI_VENC_SetJpegParam(vencChn, &jpegParam);
+        SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_SetJpegParam FAIL, ret=%#x\n", ret);
+    }
+    if(VENC_PAYLOAD != PT_JPEG && (to->kbps != from->kbps || to->fps != from->fps))
+    {
+        ret = HI_MPI_VENC_GetChnAttr(vencChn, &vencAttr);
+        SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_GetChnAttr FAIL, ret=%#x\n", ret);
+        VencRcSet(&vencAttr.stRcAttr, to);
+        ret = HI_MPI_VENC_SetChnAttr(vencChn, &vencAttr);
+        SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_SetChnAttr(rc) FAIL, ret=%#x\n", ret);
+    }
+    return HI_SUCCESS;
+}
+
+/*
+ * 帧率：通道帧率控制只对常驻接收有效；抓拍模式每空出一个环形缓冲槽抓一帧，
+ * 帧率由发送速度决定，不受档位帧率控制
+ * Frame rate: the channel frame rate control only acts on continuous receiving. The snap mode snaps
+ * whenever a ring slot frees up, so its rate follows the sender and the level's frame rate does not apply
+ */
+static HI_S32 AbrStepFps(VENC_CHN vencChn, const AbrLevel* to, const AbrLevel* from)
+{
+#if VENC_STREAM_MODE == 1
+    VENC_CHN_PARAM_S chnParam;
+    HI_S32 ret;
+
+    if(to->fps == from->fps)
+    {
+        return HI_SUCCESS;
+    }
+    ret = HI_MPI_VENC_GetChnParam(vencChn, &chnParam);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_GetChnParam FAIL, ret=%#x\n", ret);
+    chnParam.stFrameRate.s32DstFrameRate = (HI_S32)to->fps;
+    ret = HI_MPI_VENC_SetChnParam(vencChn, &chnParam);
+    SAMPLE_CHECK_EXPR_RET(ret != HI_SUCCESS, ret, "HI_MPI_VENC_SetChnParam FAIL, ret=%#x\n", ret);
+#endif
+    return HI_SUCCESS;
+}
+
+/*
+ * 切换到码率档位to：依次改尺寸、画质和帧率，某一步失败时把已完成的步骤改回from，
+ * 发送限速只在全部成功后改，失败时各处仍是from档。
+ * 只在VENC_StreamTrd中调用，不与取流并发
+ *
+ * Switch to the bitrate level to: size, quality, then frame rate. When a step fails the steps already
+ * done are set back to from, and the pacing rate only changes once all of them succeed, so on failure
+ * everything is still at from. Only called from VENC_StreamTrd, so it never runs while the stream is taken
+ */
+static HI_S32 AbrApplyLevel(const AbrLevel* to, const AbrLevel* from)
+{
+    static const AbrStepFn steps[] = { AbrStepSize, AbrStepQuality, AbrStepFps };
+    VENC_CHN vencChn = aicMediaInfo.vencChn;
+    HI_S32 ret;
+
+    for(HI_U32 i = 0; i < sizeof(steps) / sizeof(steps[0]); i++)
+    {
+        ret = steps[i](vencChn, to, from);
+        if(ret != HI_SUCCESS)
+        {
+            while(i-- > 0)
+            {
+                steps[i](vencChn, from, to);
             }
-            // jpegFlag = 0;
+            return ret;
+        }
+    }
+    UdpPacerSetRate(&g_udpPacer, to->kbps);
+    return HI_SUCCESS;
+}
+
+/*
+ * 在取流线程中应用timerSleep选定的档位，多次选档只应用最新的一次；
+ * 切换失败时仍停在原档，下次选档相对实际生效的档位计算
+ * Apply the level picked by timerSleep on the stream thread, only the latest of several picks is applied.
+ * A failed switch stays on the old level, and the next pick is applied against the level really in effect
+ */
+static HI_VOID AbrApplyPending(HI_VOID)
+{
+    static int applied = 0; // Level 0 is set up at start
+    int level = __atomic_exchange_n(&g_abrPending, -1, __ATOMIC_ACQUIRE);
+    HI_S32 ret;
+
+    if(level < 0 || level == applied)
+    {
+        return;
+    }
+    ret = AbrApplyLevel(&g_abrLadder[level], &g_abrLadder[applied]);
+    if(ret != HI_SUCCESS)
+    {
+        SAMPLE_PRT("abr: switch from level %d to %d FAIL, ret=%#x, staying on %d\n", applied, level, ret, applied);
+        return;
+    }
+    applied = level;
+}
+
+/*
+ * 记录创建成功的线程，退出时只join这些线程；创建失败的pthread_t未定义，不能join
+ * Record the threads that were created, only those are joined at exit.
+ * The pthread_t of a failed create is undefined and must not be joined
+ */
+static pthread_t g_trds[AI_TRD_MAX];
+static HI_U32 g_trdCnt = 0;
+
+static int TrdCreate(pthread_t *tid, HI_VOID* (*fn)(void), const char *name)
+{
+    int ret;
+    HI_ASSERT(g_trdCnt < AI_TRD_MAX);
+    ret = pthread_create(tid, NULL, fn, NULL);
+    if(ret != 0)
+    {
+        printf("%s create fail.\n", name);
+        return ret;
+    }
+    g_trds[g_trdCnt++] = *tid;
+    return 0;
+}
+
+static HI_VOID TrdJoinAll(HI_VOID)
+{
+    for(HI_U32 i = 0; i < g_trdCnt; i++)
+    {
+        pthread_join(g_trds[i], NULL);
+    }
+    g_trdCnt = 0;
+}
+
+/*
+ * 编码级：常驻接收模式下VENC fd可读时把码流放入环形缓冲，
+ * 抓拍模式下每当环中有空槽就抓拍一帧
+ *
+ * Encode stage: in the continuous receive mode, moves the stream into the ring when the VENC fd is readable,
+ * in the snap mode, snaps one picture whenever the ring has a free slot
+ */
+static HI_VOID* VENC_StreamTrd(void)
+{
+    VENC_CHN vencChn = aicMediaInfo.vencChn;
+    HI_U64 t0;
+#if VENC_STREAM_MODE == 1
+    HI_S32 ret;
+    fd_set readFds;
+    HI_S32 maxFd;
+    HI_S32 vencFd = HI_MPI_VENC_GetFd(vencChn);
+    if (vencFd < 0)
+    {
+        SAMPLE_PRT("HI_MPI_VENC_GetFd(%d) FAIL, ret=%#x\n", vencChn, vencFd);
+        pthread_exit(NULL);
+    }
+    maxFd = vencFd > g_stopEvent.fd ? vencFd : g_stopEvent.fd;
+    maxFd = maxFd > g_abrEvent.fd ? maxFd : g_abrEvent.fd;
+
+    while(AI_FLAG_GET(AiProcessStopFlag) == 0)
+    {
+        FD_ZERO(&readFds);
+        FD_SET(vencFd, &readFds);
+        FD_SET(g_stopEvent.fd, &readFds);
+        FD_SET(g_abrEvent.fd, &readFds);
+        ret = select(maxFd + 1, &readFds, NULL, NULL, NULL);
+        if (ret < 0)
+        {
+            SAMPLE_PRT("venc select fail\n");
+            break;
+        }
+        else if (FD_ISSET(g_stopEvent.fd, &readFds))
+        {
+            break;
+        }
+        else if (FD_ISSET(g_abrEvent.fd, &readFds))
+        {
+            AiEventWait(&g_abrEvent, NULL, 0);
+            AbrApplyPending();
+            continue;
+        }
+        else if (!FD_ISSET(vencFd, &readFds))
+        {
+            continue;
+        }
+
+        t0 = PipeStatsNowUs();
+        if(VencRingFill(&g_vencRing, vencChn, 0) == HI_SUCCESS)
+        {
+            PIPE_STATS_SINCE(PIPE_STAGE_VENC, t0);
+            PIPE_CNT_INC(g_pipeCnt.venc);
+            AiEventSignal(&g_sendEvent);
+        }
+    }
+    HI_MPI_VENC_CloseFd(vencChn);
+#else
+    HI_S32 vencMilliSec = 100;
+    VENC_RECV_PIC_PARAM_S stRecv;
+
+    while(AI_FLAG_GET(AiProcessStopFlag) == 0)
+    {
+        AbrApplyPending();
+        if (VencRingWriteSlot(&g_vencRing) == NULL) 
+        {
+            AiEventWait(&g_slotEvent, &g_stopEvent, -1);
+            continue;
+        }
+        stRecv.s32RecvPicNum = 1;
+        HI_MPI_VENC_StartRecvFrame(vencChn, &stRecv);
+        t0 = PipeStatsNowUs();
+        if(VencRingFill(&g_vencRing, vencChn, vencMilliSec) == HI_SUCCESS)
+        {
+            PIPE_STATS_SINCE(PIPE_STAGE_VENC, t0);
+            PIPE_CNT_INC(g_pipeCnt.venc);
+            AiEventSignal(&g_sendEvent);
         }
-        usleep(1000);
+        HI_MPI_VENC_StopRecvFrame(vencChn);
     }
+#endif
     pthread_exit(NULL);
 }
 
+uint8_t VencStreamTrd(pthread_t *vencThreadid)
+{
+    return TrdCreate(vencThreadid, VENC_StreamTrd, "vencThread") == 0 ? 0 : 1;
+}
+
 static HI_VOID* timerSleep(void)
 {
-    while(AiProcessStopFlag == 0)
+    static char statsBuf[1024];
+    HI_U32 tick = 0;
+    ClockSample clockBest;
+    HI_S32 clockDrift;
+    HI_U32 dropFrags, ringFull;
+    HI_U32 dropSum = 0, ringSum = 0;
+    int level;
+
+    while(AiEventWait(NULL, &g_stopEvent, 1000) == AI_EVENT_TIMEOUT)
     {
-        usleep(1000000);
-        printf("FPS:%u\n" ,FPS);
-        FPS = 0;
+        /*
+         * 码率档位每秒按本地丢包调整一次；计数每PIPE_PRINT_S秒打印一次，为该区间的累计值
+         * The bitrate level steps on the local drops every second. The counters are printed every
+         * PIPE_PRINT_S seconds, as totals over that interval
+         */
+        dropFrags = PIPE_CNT_TAKE(g_udpPacer.dropFrags);
+        ringFull = PIPE_CNT_TAKE(g_vencRing.fullCnt);
+        dropSum += dropFrags;
+        ringSum += ringFull;
+        level = AbrCtrlStep(&g_abr, dropFrags + ringFull, PipeStatsNowUs());
+        if(level >= 0)
+        {
+            __atomic_store_n(&g_abrPending, level, __ATOMIC_RELEASE);
+            AiEventSignal(&g_abrEvent);
+        }
+
+        if(++tick % PIPE_STATS_ROLL_S == 0)
+        {
+            PipeStatsRoll();
+            PipeStatsFormat(statsBuf, sizeof(statsBuf));
+            printf("%s", statsBuf);
+        }
+        if(tick % PIPE_PRINT_S != 0)
+        {
+            continue;
+        }
+        printf("capture:%u(drop %u) infer:%u(queued %u/%u) venc:%u(idr %u) send:%u in %us\n",
+            PIPE_CNT_TAKE(g_pipeCnt.capture), PIPE_CNT_TAKE(g_pipeCnt.captureDrop),
+            PIPE_CNT_TAKE(g_pipeCnt.infer), SpscQueueCount(&g_inferQueue), AI_FRM_QUEUE_DEPTH,
+            PIPE_CNT_TAKE(g_pipeCnt.venc), PIPE_CNT_TAKE(g_pipeCnt.idr),
+            PIPE_CNT_TAKE(g_pipeCnt.send), PIPE_PRINT_S);
+        printf("udp:%ukbps pace:%ums sndq:%u(max %u) eagain:%u drop:%u ring full:%u\n",
+            PIPE_CNT_TAKE(g_udpPacer.sentBytes) * 8 / 1000 / PIPE_PRINT_S, PIPE_CNT_TAKE(g_udpPacer.waitUs) / 1000,
+            g_udpPacer.queuedBytes, PIPE_CNT_TAKE(g_udpPacer.queuedMax),
+            PIPE_CNT_TAKE(g_udpPacer.eagainCnt), dropSum, ringSum);
+        dropSum = 0;
+        ringSum = 0;
+        printf("abr: level %u %ux%u@%u q%u loss:%u%% rtt:%uus(base %u) down:%u up:%u\n", g_abr.level,
+            g_abrLadder[g_abr.level].width, g_abrLadder[g_abr.level].height, g_abrLadder[g_abr.level].fps,
+            g_abrLadder[g_abr.level].qfactor, g_abr.lossPermille / 10, g_abr.rttUs, g_abr.minRttUs,
+            PIPE_CNT_TAKE(g_abr.downCnt), PIPE_CNT_TAKE(g_abr.upCnt));
+        printf("servo: sent:%u ack:%u lost:%u rtt:%uus(max %u) applied:%u %u\n",
+            PIPE_CNT_TAKE(servoLink.sentCnt), PIPE_CNT_TAKE(servoLink.ackCnt), PIPE_CNT_TAKE(servoLink.lostCnt),
+            __atomic_load_n(&servoLink.rttUs, __ATOMIC_RELAXED), PIPE_CNT_TAKE(servoLink.rttMaxUs),
+            servoLink.applied[0], servoLink.applied[1]);
+        printf("act: gpio:%u uart:%u coalesced:%u\n", PIPE_CNT_TAKE(actuator.gpioCnt),
+            PIPE_CNT_TAKE(actuator.uartCnt), PIPE_CNT_TAKE(actuator.coalesceCnt));
+        printf("gate: skip %u/%u moved:%u blk\n", PIPE_CNT_TAKE(g_motionGate.skipCnt),
+            PIPE_CNT_TAKE(g_motionGate.checkCnt), __atomic_load_n(&g_motionGate.movedBlk, __ATOMIC_RELAXED));
+        if(ClockSyncGet(&clockSync, &clockBest, &clockDrift))
+        {
+            printf("clock: offset:%lldus delay:%lluus drift:%dppb samples:%u\n",
+                (long long)clockBest.offsetUs, (unsigned long long)clockBest.delayUs, clockDrift,
+                PIPE_CNT_TAKE(clockSync.sampleCnt));
+        }
     }
     pthread_exit(NULL);
 }
 
-uint8_t JpegAndAiTrd(pthread_t *aiThreadid)
+uint8_t CaptureAndAiTrd(pthread_t *captureThreadid, pthread_t *aiThreadid)
 {
-    uint8_t ret;
-    ret = pthread_create(aiThreadid, NULL, GetVpssChnFrameHandDetect, NULL);
-    if(ret < 0)
+    if(TrdCreate(aiThreadid, AI_InferTrd, "aiThread") != 0)
     {
-        printf("aiThread create fail.\n");
         return 1;
     }
-    return ret;
+    if(TrdCreate(captureThreadid, VPSS_CaptureTrd, "captureThread") != 0)
+    {
+        return 1;
+    }
+    return 0;
 }
 
 static HI_VOID* UDP_ReceiverTrd(void)
 {
     int ret = 0;
     uint8_t ackState = 0;
-    while(AiProcessStopFlag == 0)
+    struct pollfd fds[2];
+    fds[0].fd = udpAckFd();
+    fds[0].events = POLLIN;
+    fds[1].fd = g_stopEvent.fd;
+    fds[1].events = POLLIN;
+    while(AI_FLAG_GET(AiProcessStopFlag) == 0)
     {
-        usleep(100000);
+        ret = poll(fds, 2, -1);
+        if(ret < 0 || (fds[1].revents & POLLIN))
+        {
+            break;
+        }
+        else if(!(fds[0].revents & POLLIN))
+        {
+            continue;
+        }
         ackState = udpAckRecv();
-        if(ackState == 0xFF)
+        if(ackState == UDP_ACK_NONE)
         {
             printf("udpAckRecv fail\n");
             continue;
         }
+        else if(ackState == UDP_ACK_SYNC || ackState == UDP_ACK_FB || ackState == UDP_ACK_IDR)
+        {
+            continue;
+        }
+        else if(ackState == UDP_ACK_BAD)
+        {
+            printf("udpRecv: unknown command dropped\n");
+            continue;
+        }
         else
         {
             usleep(2000);
@@ -2004,16 +2623,15 @@ static HI_VOID* UDP_ReceiverTrd(void)
 
             if(ackState == 0)
             {
-                AiFlag = 1;
+                AI_FLAG_SET(AiFlag, 1);
                 changeServoAngle(-10);
-                LED2_ON();
-                LED1_ON();
+                ActuatorSetLeds(&actuator, ACT_LED1 | ACT_LED2, ACT_LED1 | ACT_LED2);
             }
             else if(ackState == 1)
             {
-                AiFlag = 0;
-                LED2_OFF();
-                LED1_OFF();
+                AI_FLAG_SET(AiFlag, 0);
+                AiEventSignal(&g_aiFlagEvent);
+                ActuatorSetLeds(&actuator, ACT_LED1 | ACT_LED2, 0);
             }
             else if(ackState > 1)
             {
@@ -2035,6 +2653,88 @@ static HI_VOID* UDP_ReceiverTrd(void)
     pthread_exit(NULL);
 }
 
+/*
+ * 读取舵机MCU回传的ACK，串口fd与退出事件一起poll，无数据时不醒来
+ * Read the ACKs sent back by the servo MCU. The UART fd is poll()ed together with the stop event,
+ * so the thread sleeps until data arrives
+ */
+static HI_VOID* UART_AckTrd(void)
+{
+    int ret;
+    int len;
+    uint8_t buf[UART_ACK_READ_LEN];
+    struct pollfd fds[2];
+    fds[0].fd = Uart1Fd();
+    fds[0].events = POLLIN;
+    fds[1].fd = g_stopEvent.fd;
+    fds[1].events = POLLIN;
+    if(fds[0].fd < 0)
+    {
+        pthread_exit(NULL);
+    }
+    while(AI_FLAG_GET(AiProcessStopFlag) == 0)
+    {
+        ret = poll(fds, 2, -1);
+        if(ret < 0 || (fds[1].revents & POLLIN))
+        {
+            break;
+        }
+        if(fds[0].revents & (POLLERR | POLLHUP))
+        {
+            SAMPLE_PRT("uart ack poll FAIL, revents=%#x\n", fds[0].revents);
+            break;
+        }
+        while((len = Uart1Read(buf, sizeof(buf))) > 0)
+        {
+            ServoLinkRecv(&servoLink, buf, len);
+        }
+    }
+    pthread_exit(NULL);
+}
+
+/*
+ * 统计端口：任意数据报都回复最近一个窗口的各级耗时，如 echo | nc -u -w1 <board> 8899
+ * Stats port: any datagram is answered with the stage latencies of the latest window,
+ * e.g. echo | nc -u -w1 <board> 8899
+ */
+static HI_VOID* STATS_Trd(void)
+{
+    int ret;
+    struct pollfd fds[2];
+    fds[0].fd = PipeStatsServeOpen(PIPE_STATS_PORT);
+    fds[0].events = POLLIN;
+    fds[1].fd = g_stopEvent.fd;
+    fds[1].events = POLLIN;
+    if(fds[0].fd < 0)
+    {
+        pthread_exit(NULL);
+    }
+    while(AI_FLAG_GET(AiProcessStopFlag) == 0)
+    {
+        ret = poll(fds, 2, -1);
+        if(ret < 0 || (fds[1].revents & POLLIN))
+        {
+            break;
+        }
+        if(fds[0].revents & POLLIN)
+        {
+            PipeStatsServe(fds[0].fd);
+        }
+    }
+    close(fds[0].fd);
+    pthread_exit(NULL);
+}
+
+/*
+ * 执行线程，LED和舵机角度的实际写入都在这里
+ * Actuation thread, the only place LEDs and servo angles are actually written
+ */
+static HI_VOID* ACT_Trd(void)
+{
+    ActuatorRun(&actuator, &g_stopEvent);
+    pthread_exit(NULL);
+}
+
 static HI_S32 PauseDoUnloadYoloModel(HI_VOID)
 {
     HI_S32 s32Ret = HI_SUCCESS;
@@ -2049,9 +2749,8 @@ uint8_t aiVision_Init(void)
 {
     HI_S32 s32Ret;
     VPSS_LDC_ATTR_S ldcdata = {0};
-    VENC_CHN vencChn[1] = {0};
+    VENC_CHN vencChn[1] = {AIC_VENC_CHN};
     SIZE_S picsize;
-    VENC_RECV_PIC_PARAM_S stRecvParam;
 
     /*Config VI parameter*/
     ViPramCfg();
@@ -2083,6 +2782,21 @@ uint8_t aiVision_Init(void)
         return 1;
     }
 
+    picsize.u32Width = g_abrLadder[0].width;
+    picsize.u32Height = g_abrLadder[0].height;
+    AbrCtrlInit(&g_abr, g_abrLadder, sizeof(g_abrLadder) / sizeof(g_abrLadder[0]));
+
+    /* One byte per pixel is well above the JPEG size at the default QFactor, and above an H.264/H.265 I frame */
+    s32Ret = VencRingInit(&g_vencRing, picsize.u32Width * picsize.u32Height, VENC_PAYLOAD);
+    SAMPLE_CHECK_EXPR_GOTO(s32Ret != HI_SUCCESS, EXIT, "venc ring init FAIL, ret=%#x\n", s32Ret);
+    s32Ret = SpscQueueInit(&g_inferQueue, AI_FRM_QUEUE_DEPTH, sizeof(VIDEO_FRAME_INFO_S));
+    SAMPLE_CHECK_EXPR_GOTO(s32Ret != HI_SUCCESS, EXIT0, "infer queue init FAIL, ret=%#x\n", s32Ret);
+    /* Motion gating only saves work, inference runs on every frame when the IVE images can not be allocated */
+    if (MotionGateInit(&g_motionGate, OBSTACLE_FRM_WIDTH, OBSTACLE_FRM_HEIGHT, NULL) != HI_SUCCESS)
+    {
+        printf("motion gate init fail, inference is not gated\n");
+    }
+
 #if DEBUGMODE == 1
     /*Set VO config to MIPI, get MIPI device*/
     system("cd /sys/class/gpio/;echo 55 > export;echo out > gpio55/direction;echo 1 > gpio55/value");
@@ -2096,6 +2810,7 @@ uint8_t aiVision_Init(void)
     SAMPLE_CHECK_EXPR_GOTO(s32Ret != HI_SUCCESS, EXIT1, "ViVpss Sess create FAIL, ret=%#x\n", s32Ret);
     aicMediaInfo.vpssGrp = AIC_VPSS_GRP;
     aicMediaInfo.vpssChn0 = AIC_VPSS_ZOUT_CHN;
+    aicMediaInfo.vpssChn1 = AIC_VPSS_INFER_CHN;
 
 #if DEBUGMODE == 1
    /*Config VO parameter*/
@@ -2109,21 +2824,19 @@ uint8_t aiVision_Init(void)
     SAMPLE_PRT("vpssGrp:%d, vpssChn:%d\n", aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0);
 #endif
 
-    picsize.u32Width = 800;
-    picsize.u32Height = 700;
-    stRecvParam.s32RecvPicNum = 1;
-
-    remove("p1.jpg");
+#if VENC_CODEC == UDP_FRAME_CODEC_JPEG
     SAMPLE_COMM_VENC_SnapStart(vencChn[0], &picsize, HI_FALSE);
+#else
+    s32Ret = VencH26xStart(vencChn[0], &g_abrLadder[0]);
+    SAMPLE_CHECK_EXPR_GOTO(s32Ret != HI_SUCCESS, EXIT1, "venc h26x start FAIL, ret=%#x\n", s32Ret);
+#endif
     usleep(10000);
-    SAMPLE_COMM_VPSS_Bind_VENC(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0, vencChn[0]);
+    SAMPLE_COMM_VPSS_Bind_VENC(aicMediaInfo.vpssGrp, AIC_VPSS_VENC_CHN, vencChn[0]);
     usleep(10000);
-    HI_MPI_VENC_StartRecvFrame(vencChn[0], &stRecvParam);
-    usleep(5000);
-    VENC_GetPic(vencChn[0], "p1.jpg");
-    usleep(5000);
-    HI_MPI_VENC_StopRecvFrame(vencChn[0]);
-    usleep(5000);
+    aicMediaInfo.vencChn = vencChn[0];
+#if VENC_STREAM_MODE == 1
+    VencStreamStart(vencChn[0]);
+#endif
 
     return 0;
 
@@ -2134,6 +2847,10 @@ EXIT1:
     SAMPLE_COMM_VI_UnBind_VPSS(aicMediaInfo.viCfg.astViInfo[0].stPipeInfo.aPipe[0], aicMediaInfo.viCfg.astViInfo[0].stChnInfo.ViChn, aicMediaInfo.vpssGrp);
     ViStop(&aicMediaInfo.viCfg);
     free(aicMediaInfo.viSess);
+    MotionGateDeinit(&g_motionGate);
+    SpscQueueDeinit(&g_inferQueue);
+EXIT0:
+    VencRingDeinit(&g_vencRing);
 EXIT:
     SAMPLE_COMM_SYS_Exit();
     return 1;
@@ -2144,7 +2861,14 @@ void aiVision_DeInit(void)
     PauseDoUnloadYoloModel();
     UDPclient_DeInit();
     Uart1Close();
-    SAMPLE_COMM_VPSS_UnBind_VENC(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0, 0);
+#if VENC_STREAM_MODE == 1
+    HI_MPI_VENC_StopRecvFrame(aicMediaInfo.vencChn);
+#endif
+    SAMPLE_COMM_VPSS_UnBind_VENC(aicMediaInfo.vpssGrp, AIC_VPSS_VENC_CHN, aicMediaInfo.vencChn);
+    VencRingDeinit(&g_vencRing);
+    InferQueueFlush();
+    SpscQueueDeinit(&g_inferQueue);
+    MotionGateDeinit(&g_motionGate);
 #if DEBUGMODE == 1
     SAMPLE_COMM_VPSS_UnBind_VO(aicMediaInfo.vpssGrp, aicMediaInfo.vpssChn0, aicMediaInfo.voCfg.VoDev, 0);
     SAMPLE_VO_DISABLE_MIPITx(ai_fd);
@@ -2159,19 +2883,60 @@ void aiVision_DeInit(void)
     SAMPLE_COMM_SYS_Exit();
 }
 
+/*
+ * 创建线程间通知用的事件
+ * Create the events used for inter-thread notification
+ */
+static int AiEventsInit(void)
+{
+    if (AiEventInit(&g_stopEvent) != HI_SUCCESS || AiEventInit(&g_inferEvent) != HI_SUCCESS ||
+        AiEventInit(&g_sendEvent) != HI_SUCCESS || AiEventInit(&g_slotEvent) != HI_SUCCESS ||
+        AiEventInit(&g_aiFlagEvent) != HI_SUCCESS || AiEventInit(&g_abrEvent) != HI_SUCCESS) {
+        return HI_FAILURE;
+    }
+    return HI_SUCCESS;
+}
+
+static void AiEventsDeinit(void)
+{
+    AiEventDeinit(&g_stopEvent);
+    AiEventDeinit(&g_inferEvent);
+    AiEventDeinit(&g_sendEvent);
+    AiEventDeinit(&g_slotEvent);
+    AiEventDeinit(&g_aiFlagEvent);
+    AiEventDeinit(&g_abrEvent);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
-PIDController servo1, servo2;   //x, y
+ServoLink servoLink;
+Actuator actuator;
+ClockSync clockSync;
 int main(void)
 {
     int ret;
     pthread_t t_aiVision;
+    pthread_t t_vpssCapture;
+    pthread_t t_vencStream;
     pthread_t t_timerSleep;
     pthread_t t_udpTransfer;
     pthread_t t_udpReceiver;
+    pthread_t t_uartAck;
+    pthread_t t_actuator;
+    pthread_t t_stats;
 
     sdk_init();
 
+    /* AiEventsInit */
+    ret = AiEventsInit();
+    if(ret != 0)
+    {
+        printf("events Init fail\n");
+        AiEventsDeinit();
+        sdk_exit();
+        return 0;
+    }
+
     /* GPIO_Init */
     ret = GPIO_Init();
     if(ret != 0)
@@ -2192,6 +2957,16 @@ int main(void)
         sdk_exit();
         return 0;
     }
+    ServoLinkInit(&servoLink);
+    ClockSyncInit(&clockSync);
+    ret = ActuatorInit(&actuator);
+    if(ret != 0)
+    {
+        printf("actuator Init fail\n");
+        SAMPLE_COMM_SYS_Exit();
+        sdk_exit();
+        return 0;
+    }
     usleep(1000);
 
     /* UDPclient_Init */
@@ -2205,34 +2980,21 @@ int main(void)
     }
     usleep(1000);
 
-    /* AudioInit & PID_Init */
-    PID_Init(&servo1, 0.0165f, 0.037f, 0.035f);
-    PID_Init(&servo2, 0.014f, 0.037f, 0.035f);
-    usleep(1000);
-
     /* aiVision_Init */
     aiVision_Init();
     usleep(1000);
 
     /* main trd */
-    JpegAndAiTrd(&t_aiVision);
+    CaptureAndAiTrd(&t_vpssCapture, &t_aiVision);
+    VencStreamTrd(&t_vencStream);
 
     /* other trd */
-    ret = pthread_create(t_timerSleep, NULL, timerSleep, NULL);
-    if(ret < 0)
-    {
-        printf("timerSleep create fail.\n");
-    }
-    ret = pthread_create(t_udpTransfer, NULL, UDP_TransferTrd, NULL);
-    if(ret < 0)
-    {
-        printf("UDP_TransferTrd create fail.\n");
-    }
-    ret = pthread_create(t_udpReceiver, NULL, UDP_ReceiverTrd, NULL);
-    if(ret < 0)
-    {
-        printf("UDP_ReceiverTrd create fail.\n");
-    }
+    TrdCreate(&t_timerSleep, timerSleep, "timerSleep");
+    TrdCreate(&t_udpTransfer, UDP_TransferTrd, "UDP_TransferTrd");
+    TrdCreate(&t_udpReceiver, UDP_ReceiverTrd, "UDP_ReceiverTrd");
+    TrdCreate(&t_uartAck, UART_AckTrd, "UART_AckTrd");
+    TrdCreate(&t_actuator, ACT_Trd, "ACT_Trd");
+    TrdCreate(&t_stats, STATS_Trd, "STATS_Trd");
 
     if(Play_audioFile(30) == 0)
     {
@@ -2245,9 +3007,12 @@ int main(void)
 
     /* stop? */
     Pause();
-    AiProcessStopFlag = 1;
-    pthread_join(t_aiVision, NULL);
+    AI_FLAG_SET(AiProcessStopFlag, 1);
+    AiEventSignal(&g_stopEvent);
+    TrdJoinAll();
     aiVision_DeInit();
+    ActuatorDeinit(&actuator);
+    AiEventsDeinit();
     sdk_exit();
 
     return 0;
@@ -2255,41 +3020,6 @@ int main(void)
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// 初始化PI控制器
-void PID_Init(PIDController* pid, float Kp, float Ki, float Kd) 
-{
-    pid->Kp = Kp;
-    pid->Ki = Ki;
-    pid->Kd = Kd;
-    pid->integral = 0;
-    pid->lastError = 0;
-}
-
-// PI控制计算函数
-short PID_Calculate(PIDController* pid, short setpoint, short feedback) 
-{
-    // 计算误差
-    short error = setpoint - feedback;
-    // 计算积分项（带抗饱和）
-    pid->integral += error;
-    // 防止积分饱和
-    if (pid->integral > 10) 
-    {
-        pid->integral = 10;
-    } 
-    else if (pid->integral < -10)
-    {
-        pid->integral = -10;
-    }
-    // 计算微分项
-    short derivative = error - pid->lastError;
-    // 计算PID输出
-    short output = (short)(round(pid->Kp * error + pid->Ki * pid->integral + pid->Kd * derivative));
-    // 保存当前误差用于下次计算
-    pid->lastError = error;
-    return output;
-}
-
 int sockfd;
 uint16_t serverPort = 8888;
 uint16_t clientPort = 9999;
@@ -2344,34 +3074,158 @@ int UDPclient_Init(void)
         close(sockfd);
         return 1;
     }
+    UdpPacerInit(&g_udpPacer, UDP_PACE_KBPS, UDP_PACE_BURST);
+    UdpPacerSetSndBuf(&g_udpPacer, sockfd, UDP_SNDBUF_MS);
     printf("Server IP: %s - Server Port: %d - ack Port: %d\n", 
                 inet_ntoa(serverAddr.sin_addr), ntohs(serverAddr.sin_port) , ntohs(clientAddr.sin_port));
     
     return 0;
 }
 
-int udpSend(uint32_t pBuffer, uint32_t bufLength)
+static HI_U8 g_udpHdrBuf[UDP_SEND_MSG_MAX][UDP_FRAME_HDR_LEN];
+static struct iovec g_udpIov[UDP_SEND_MSG_MAX][2]; // 2: header + payload
+static struct mmsghdr g_udpMsgs[UDP_SEND_MSG_MAX];
+/*
+ * 校验组可能跨批次，组号取模复用缓冲；一批最多引用UDP_SEND_BATCH个已完成的组加一个累加中的组
+ * Parity groups may span batches, buffers are reused by group number. One batch references at most
+ * UDP_SEND_BATCH finished groups plus the one being accumulated
+ */
+static HI_U8 g_udpParity[UDP_SEND_BATCH + 1][UDP_FRAME_PARITY_LEN];
+
+/*
+ * 在批次的第n个位置填入一个分片，头部来自hdr
+ * Fill message n of the batch with one fragment, the header comes from hdr
+ */
+static HI_U32 UdpBatchAdd(int n, const UdpFrameHdr* hdr, const HI_U8* payload)
 {
-    int ret = 0, i = 0;
-    uint16_t lastPackLength = 0, packCount = 0;
-    if(bufLength <= MTU_USER)
+    UdpFrameHdrPack(hdr, g_udpHdrBuf[n]);
+    g_udpIov[n][0].iov_base = g_udpHdrBuf[n];
+    g_udpIov[n][0].iov_len = UDP_FRAME_HDR_LEN;
+    g_udpIov[n][1].iov_base = (void *)payload;
+    g_udpIov[n][1].iov_len = hdr->payloadLen;
+    memset(&g_udpMsgs[n], 0, sizeof(g_udpMsgs[n]));
+    g_udpMsgs[n].msg_hdr.msg_name = &serverAddr;
+    g_udpMsgs[n].msg_hdr.msg_namelen = sizeof(serverAddr);
+    g_udpMsgs[n].msg_hdr.msg_iov = g_udpIov[n];
+    g_udpMsgs[n].msg_hdr.msg_iovlen = 2; // 2: header + payload
+    return UDP_FRAME_HDR_LEN + hdr->payloadLen;
+}
+
+/*
+ * 限速后用sendmmsg发出一批，可能只发出一部分，剩余的继续发；
+ * 发送缓冲满时短暂等待，仍满则放弃，返回未发出的分片数
+ *
+ * Pace then send a batch with sendmmsg, resuming after partial sends.
+ * When the socket buffer is full wait briefly, then give up. Returns the number of messages not sent
+ */
+static int UdpBatchFlush(int n, HI_U32 batchBytes)
+{
+    struct pollfd pfd;
+    int sent, ret;
+
+    UdpPacerConsume(&g_udpPacer, batchBytes);
+    for(sent = 0; sent < n; sent += ret)
     {
-        ret = sendto(sockfd, pBuffer, bufLength, 0, (const struct sockaddr *)&serverAddr, sizeof(serverAddr));
-        return ret;
+        ret = sendmmsg(sockfd, g_udpMsgs + sent, n - sent, MSG_DONTWAIT);
+        if(ret > 0)
+        {
+            continue;
+        }
+        if(ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            PIPE_CNT_INC(g_udpPacer.eagainCnt);
+            pfd.fd = sockfd;
+            pfd.events = POLLOUT;
+            if(poll(&pfd, 1, UDP_EAGAIN_WAIT_MS) > 0)
+            {
+                ret = 0;
+                continue;
+            }
+        }
+        return n - sent;
     }
-    else
+    UdpPacerSampleQueue(&g_udpPacer, sockfd);
+    return 0;
+}
+
+/*
+ * 按udp_frame.h的协议将一帧切成不超过MTU的分片，每UDP_SEND_BATCH个数据分片一次sendmmsg发出
+ * 分片负载的iovec直接指向帧缓冲，不做拷贝，每批发送前由g_udpPacer限速
+ * UDP_FEC_GROUP非0时每组数据分片后追加一个XOR校验分片；flags为编码格式和关键帧标志，返回已发送的帧数据字节数
+ *
+ * Send one frame as MTU-sized fragments per udp_frame.h, UDP_SEND_BATCH data fragments per sendmmsg call.
+ * The payload iovecs point straight into the frame buffer without a copy, and g_udpPacer paces
+ * every batch. With UDP_FEC_GROUP non-zero an XOR parity fragment follows every group of data fragments.
+ * flags carries the codec and the key frame flag. Returns the frame bytes sent
+ */
+int udpSend(const uint8_t *pBuffer, uint32_t bufLength, HI_U64 pts, HI_U8 flags)
+{
+    static HI_U32 frameId = 0;
+    UdpFrameHdr hdr;
+    UdpFrameHdr parityHdr;
+    HI_U8 *parity = NULL;
+    HI_U16 parityLen = 0;
+    uint32_t offset = 0;
+    uint32_t batchBytes = 0;
+    int n = 0, lost;
+
+    if(bufLength == 0 || UDP_FRAME_FRAG_NUM(bufLength) > 0xFFFF)
+    {
+        return -1;
+    }
+    hdr.magic = UDP_FRAME_MAGIC;
+    hdr.version = UDP_FRAME_VERSION;
+    hdr.flags = flags;
+    hdr.frameId = frameId++;
+    hdr.fragCnt = (HI_U16)UDP_FRAME_FRAG_NUM(bufLength);
+    hdr.fecGroup = UDP_FEC_GROUP;
+    hdr.frameLen = bufLength;
+    hdr.pts = pts;
+    if(HI_MPI_SYS_GetCurPTS(&hdr.sendUs) != HI_SUCCESS)
+    {
+        hdr.sendUs = 0;
+    }
+    parityHdr = hdr;
+    parityHdr.flags = flags | UDP_FRAME_FLAG_PARITY;
+
+    for(hdr.fragIdx = 0; hdr.fragIdx < hdr.fragCnt; hdr.fragIdx++)
     {
-        lastPackLength = bufLength % MTU_USER;
-        packCount = bufLength / MTU_USER;
-        for(i=0; i<packCount; i++)
+        hdr.payloadLen = (HI_U16)((bufLength - offset) < UDP_FRAME_PAYLOAD_MAX ?
+            (bufLength - offset) : UDP_FRAME_PAYLOAD_MAX);
+        batchBytes += UdpBatchAdd(n++, &hdr, pBuffer + offset);
+
+        if(UDP_FEC_GROUP > 0)
         {
-            ret += sendto(sockfd, pBuffer + ret, MTU_USER, 0, (const struct sockaddr *)&serverAddr, sizeof(serverAddr));
-            usleep(50);
+            if(hdr.fragIdx % UDP_FEC_GROUP == 0)
+            {
+                parityHdr.fragIdx = hdr.fragIdx / UDP_FEC_GROUP;
+                parity = g_udpParity[parityHdr.fragIdx % (UDP_SEND_BATCH + 1)];
+                UdpFrameParityReset(parity);
+                parityLen = 0;
+            }
+            parityLen = UdpFrameParityAdd(parity, parityLen, pBuffer + offset, hdr.payloadLen);
+            if(hdr.fragIdx % UDP_FEC_GROUP == UDP_FEC_GROUP - 1 || hdr.fragIdx == hdr.fragCnt - 1)
+            {
+                parityHdr.payloadLen = parityLen;
+                batchBytes += UdpBatchAdd(n++, &parityHdr, parity);
+            }
         }
-        ret += sendto(sockfd, pBuffer + ret, lastPackLength, 0, (const struct sockaddr *)&serverAddr, sizeof(serverAddr));
-        return ret;
-    }
+        offset += hdr.payloadLen;
 
+        if(n >= UDP_SEND_BATCH || hdr.fragIdx == hdr.fragCnt - 1)
+        {
+            lost = UdpBatchFlush(n, batchBytes);
+            if(lost > 0)
+            {
+                __atomic_fetch_add(&g_udpPacer.dropFrags, (HI_U32)(lost + hdr.fragCnt - hdr.fragIdx - 1),
+                    __ATOMIC_RELAXED);
+                return -1;
+            }
+            n = 0;
+            batchBytes = 0;
+        }
+    }
+    return (int)offset;
 }
 
 int udpAckSend(uint8_t ackState)
@@ -2383,16 +3237,54 @@ int udpAckSend(uint8_t ackState)
     return ret;
 }
 
+/*
+ * 应答端口同时承载命令和对时请求，对时请求在此直接应答，收到时刻尽早取以减小误差
+ * The ack port carries both commands and clock sync requests. Sync requests are answered right here,
+ * with the arrival time taken as early as possible to keep the error small
+ */
 uint8_t udpAckRecv(void)
 {
     uint8_t ackState = 0;
-    char recvBuffer[8];
+    char recvBuffer[CLOCK_SYNC_MSG_MAX];
+    char syncReply[CLOCK_SYNC_MSG_MAX];
+    char *end = NULL;
+    unsigned long cmd;
+    HI_U64 rxUs = 0;
+    int len;
     socklen_t clientLen = sizeof(struct sockaddr_in);
-    if(recvfrom(sockfd, recvBuffer, sizeof(recvBuffer), MSG_WAITALL, (const struct sockaddr *)&clientAddr, &clientLen) < 1)
+    len = recvfrom(sockfd, recvBuffer, sizeof(recvBuffer) - 1, MSG_WAITALL, (const struct sockaddr *)&clientAddr, &clientLen);
+    if(len < 1)
     {
-        return 0xFF;
+        return UDP_ACK_NONE;
     }
-    ackState = atoi(recvBuffer);
+    HI_MPI_SYS_GetCurPTS(&rxUs);
+    recvBuffer[len] = '\0';
+    len = ClockSyncHandle(&clockSync, recvBuffer, rxUs, syncReply, sizeof(syncReply));
+    if(len > 0)
+    {
+        sendto(sockfd, syncReply, len, 0, (const struct sockaddr *)&clientAddr, sizeof(clientAddr));
+        return UDP_ACK_SYNC;
+    }
+    if(AbrCtrlFeedback(&g_abr, recvBuffer, PipeStatsNowUs()))
+    {
+        return UDP_ACK_FB;
+    }
+    if(strcmp(recvBuffer, "IDR") == 0)
+    {
+        VencRequestIdr();
+        return UDP_ACK_IDR;
+    }
+    /*
+     * 命令只能是十进制数字且小于保留值；解析失败的对时或反馈报文不能当作命令0去动舵机
+     * A command is decimal digits only and below the reserved values. A sync or feedback message that
+     * failed to parse must not run as command 0 and move the servo
+     */
+    cmd = strtoul(recvBuffer, &end, 10); // 10: decimal
+    if(end == recvBuffer || *end != '\0' || !isdigit((unsigned char)recvBuffer[0]) || cmd >= UDP_ACK_BAD)
+    {
+        return UDP_ACK_BAD;
+    }
+    ackState = (uint8_t)cmd;
     // printf("udpRecv%d: %s-%c-%u\n", ntohs(clientAddr.sin_port), recvBuffer, recvBuffer[0], ackState);
     return ackState;
 }
@@ -2419,6 +3311,11 @@ void getLocalIpPort(void)
     }
 }
 
+int udpAckFd(void)
+{
+    return sockfd;
+}
+
 void UDPclient_DeInit(void) 
 {
     close(sockfd);
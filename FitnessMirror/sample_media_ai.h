@@ -19,6 +19,9 @@
 #include "sample_comm.h"
 #include "list.h"
 #include "osd_img.h"
+#include "servo_link.h"
+#include "actuator.h"
+#include "clock_sync.h"
 
 #ifdef __cplusplus
 #if __cplusplus
@@ -64,7 +67,10 @@ extern "C" {
 
 #define AIC_VPSS_GRP            0 // default use VPSS group
 #define AIC_VPSS_ZIN_CHN        0 // default use VPSS amplification channel
+#define AIC_VPSS_VENC_CHN       0 // VPSS channel feeding VENC, resized at runtime by the bitrate controller
 #define AIC_VPSS_ZOUT_CHN       1 // default use VPSS narrowing channel
+#define AIC_VPSS_INFER_CHN      2 // VPSS narrowing channel scaled to the inference input size
+#define AIC_VENC_CHN            0 // default use VENC snap channel
 
 #define AICSTART_VI_OUTWIDTH    1920
 #define AICSTART_VI_OUTHEIGHT   1080
@@ -195,7 +201,9 @@ extern uint8_t AiProcessStopSignal;
 
 HI_S32 SampleCommVoStartDevMipi(VO_DEV VoDev, VO_PUB_ATTR_S* pstPubAttr);
 
-uint8_t obstacleDetectAiTrd(pthread_t *aiThreadid);
+uint8_t CaptureAndAiTrd(pthread_t *captureThreadid, pthread_t *aiThreadid);
+
+uint8_t VencStreamTrd(pthread_t *vencThreadid);
 
 uint8_t aiVision_Init(void);
 
@@ -203,31 +211,29 @@ void aiVision_DeInit(void);
 
 int UDPclient_Init(void);
 
-int udpSend(uint32_t pBuffer, uint32_t bufLength);
+int udpSend(const uint8_t *pBuffer, uint32_t bufLength, HI_U64 pts, HI_U8 flags);
+
+#define UDP_ACK_NONE    0xFF // udpAckRecv: nothing received
+#define UDP_ACK_SYNC    0xFE // udpAckRecv: a clock sync request, already answered
+#define UDP_ACK_FB      0xFD // udpAckRecv: a bitrate feedback report, already taken
+#define UDP_ACK_IDR     0xFC // udpAckRecv: a key frame request, already passed to VENC
+#define UDP_ACK_BAD     0xFB // udpAckRecv: not a known command, dropped without an ACK
 
 int udpAckSend(uint8_t ackState);
 
 uint8_t udpAckRecv(void);
 
+int udpAckFd(void);
+
 void getLocalIpPort(void);
 
 void UDPclient_DeInit(void);
 
-// PI控制器结构体
-typedef struct {
-    float Kp;    // 比例系数
-    float Ki;    // 积分系数
-    float Kd;    // 微分系数
-    short integral; // 积分项
-    short lastError; // 上一次误差
-} PIDController;
-
-// 初始化PID控制器
-void PID_Init(PIDController* pid, float Kp, float Ki, float Kd);
+extern ServoLink servoLink; // UART link to the servo MCU
 
-short PID_Calculate(PIDController* pid, short setpoint, short feedback);
+extern Actuator actuator; // LEDs and servo setpoints, written by the actuation thread only
 
-extern PIDController servo1, servo2;   //x, y
+extern ClockSync clockSync; // Board PTS clock to relay wall clock, fed over the ack port
 
 /*
  * 初始化vi配置
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件实现定点的舵机跟踪控制，用帧时间戳求实际时间间隔，
+ * 并按目标速度前馈和外推到执行时刻，补偿摄像头->串口->舵机的延迟
+ *
+ * This file implements fixed point servo tracking. Real frame intervals come from the frame timestamps,
+ * and the target velocity is fed forward and extrapolated to actuation time to make up for
+ * the camera -> UART -> servo delay.
+ */
+
+#include <string.h>
+
+#include "sample_media_ai.h"
+#include "servo_ctrl.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define US_PER_S        1000000
+#define DT_DEF_US       33333 // Used for the first update and after gaps
+#define DT_MIN_US       1000
+#define DT_MAX_US       200000
+
+static inline HI_S32 QMul(HI_S32 a, HI_S32 b)
+{
+    return (HI_S32)(((HI_S64)a * b) >> SERVO_Q);
+}
+
+static inline HI_S32 QClamp(HI_S32 x, HI_S32 lo, HI_S32 hi)
+{
+    return x < lo ? lo : (x > hi ? hi : x);
+}
+
+static inline HI_S32 UsToQ16(HI_U64 us)
+{
+    return (HI_S32)(((HI_S64)us << SERVO_Q) / US_PER_S);
+}
+
+void ServoAxisInit(ServoAxis* self, const ServoAxisCfg* cfg, HI_S32 angle)
+{
+    HI_ASSERT(self && cfg);
+    if (memset_s(self, sizeof(*self), 0, sizeof(*self)) != EOK) {
+        HI_ASSERT(0);
+    }
+    self->cfg = *cfg;
+    self->angle = QClamp(angle, cfg->angleMin, cfg->angleMax) << SERVO_Q;
+    for (HI_U32 i = 0; i < SERVO_HIST_NUM; i++) {
+        self->histAngle[i] = self->angle; // Time 0: in effect since before any frame
+    }
+}
+
+/*
+ * 在us时刻生效的指令角度：生效时刻不晚于us的最新记录，记录都更晚时取最早的一条
+ * Commanded angle in effect at us: the newest entry effective no later than us,
+ * or the oldest entry when all of them are later
+ */
+static HI_S32 ServoAxisAngleAt(const ServoAxis* self, HI_U64 us)
+{
+    HI_U32 idx = self->histHead;
+    HI_S32 angle = self->histAngle[idx];
+
+    for (HI_U32 i = 0; i < SERVO_HIST_NUM; i++, idx = (idx + 1) % SERVO_HIST_NUM) {
+        if (self->histUs[idx] > us) {
+            break;
+        }
+        angle = self->histAngle[idx];
+    }
+    return angle;
+}
+
+void ServoAxisReset(ServoAxis* self)
+{
+    self->integ = 0;
+    self->vel = 0;
+    self->lastPts = 0;
+}
+
+HI_S32 ServoAxisUpdate(ServoAxis* self, HI_S32 errPx, HI_U64 pts, HI_U32 leadUs)
+{
+    const ServoAxisCfg *cfg = &self->cfg;
+    HI_S32 rateMax = cfg->rateMax << SERVO_Q;
+    HI_S32 target, err, rate, dt;
+    HI_BOOL gap = HI_TRUE;
+    HI_U64 dtUs = DT_DEF_US;
+
+    if (self->lastPts != 0 && pts > self->lastPts && pts - self->lastPts <= DT_MAX_US) {
+        dtUs = pts - self->lastPts < DT_MIN_US ? DT_MIN_US : pts - self->lastPts;
+        gap = HI_FALSE;
+    }
+    dt = UsToQ16(dtUs);
+    self->lastPts = pts;
+
+    /*
+     * 目标对应的舵机角度(相对采集时刻的角度)，及其角速度的低通估计
+     * Servo angle that centers the target (relative to the angle at capture), and a low pass estimate
+     * of its angular velocity
+     */
+    target = ServoAxisAngleAt(self, pts) + cfg->dir * errPx * cfg->degPerPx;
+    if (!gap) {
+        HI_S64 velNew = ((HI_S64)(target - self->lastTarget) << SERVO_Q) / dt;
+        velNew = velNew > rateMax ? rateMax : (velNew < -rateMax ? -rateMax : velNew);
+        self->vel += QMul(cfg->velAlpha, (HI_S32)velNew - self->vel);
+    } else {
+        self->vel = 0;
+    }
+    self->lastTarget = target;
+
+    err = target + QMul(self->vel, UsToQ16(leadUs)) - self->angle;
+    rate = QMul(cfg->kff, self->vel) + QMul(cfg->kp, err) + QMul(cfg->ki, self->integ);
+
+    /*
+     * 速率饱和或角度已到限位时停止积分，避免积分饱和
+     * Stop integrating while the rate is saturated or the angle sits at a limit, against windup
+     */
+    if (rate > rateMax) {
+        rate = rateMax;
+    } else if (rate < -rateMax) {
+        rate = -rateMax;
+    } else if (!(err > 0 && self->angle >= (cfg->angleMax << SERVO_Q)) &&
+        !(err < 0 && self->angle <= (cfg->angleMin << SERVO_Q))) {
+        self->integ += QMul(err, dt);
+    }
+
+    self->angle = QClamp(self->angle + QMul(rate, dt), cfg->angleMin << SERVO_Q, cfg->angleMax << SERVO_Q);
+    self->histUs[self->histHead] = pts + leadUs;
+    self->histAngle[self->histHead] = self->angle;
+    self->histHead = (self->histHead + 1) % SERVO_HIST_NUM;
+    return SERVO_Q16_INT(self->angle);
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SERVO_CTRL_H
+#define SERVO_CTRL_H
+
+#include "hi_type.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 定点数为Q16.16，角度单位为度，时间单位为秒
+ * Fixed point values are Q16.16, angles are in degrees and times in seconds
+ */
+#define SERVO_Q             16
+#define SERVO_Q16(x)        ((HI_S32)((x) * (1 << SERVO_Q)))
+#define SERVO_Q16_INT(x)    ((HI_S32)(((x) + (1 << (SERVO_Q - 1))) >> SERVO_Q)) // Round to the nearest integer
+#define SERVO_Q16_CDEG(x)   ((HI_S32)(((HI_S64)(x) * 100 + (1 << (SERVO_Q - 1))) >> SERVO_Q)) // To 0.01 degree
+#define SERVO_HIST_NUM      16 // Commanded angles kept, covers the capture to actuation delay at 30 fps
+
+typedef struct ServoAxisCfg {
+    HI_S32 kp; // Q16, angle rate per degree of error, 1/s
+    HI_S32 ki; // Q16, angle rate per degree second of integrated error, 1/s^2
+    HI_S32 kff; // Q16, share of the target angular velocity fed forward, 1.0 = all of it
+    HI_S32 velAlpha; // Q16, low pass weight of a new target velocity sample
+    HI_S32 degPerPx; // Q16, camera angle covered by one pixel
+    HI_S32 dir; // 1 or -1, servo direction that moves the target towards the setpoint
+    HI_S32 angleMin; // Degrees
+    HI_S32 angleMax; // Degrees
+    HI_S32 rateMax; // Slew limit, degrees/s
+} ServoAxisCfg;
+
+/*
+ * 单轴舵机跟踪控制器，输入目标相对画面中心的像素误差和帧时间戳，输出舵机角度
+ * 控制律：速率 = kff*目标角速度 + kp*预测误差 + ki*误差积分，预测误差为执行时刻目标位置与当前角度之差
+ *
+ * Single axis servo tracking controller, takes the pixel error of the target from the picture center
+ * and the frame timestamp, outputs the servo angle.
+ * Control law: rate = kff * target angular velocity + kp * predicted error + ki * integrated error,
+ * the predicted error is the target position at actuation time minus the current angle
+ *
+ * 像素误差是相对采集时刻的舵机角度测得的，因此目标角度以采集时刻生效的指令角度为基准，
+ * 由记录的(生效时刻, 指令角度)查得，采集之后的舵机运动不会被重复计入
+ *
+ * The pixel error is measured against the servo angle at capture time, so the target angle is based on
+ * the commanded angle in effect at capture, looked up in the recorded (effective time, commanded angle)
+ * pairs. Servo motion after the capture is not counted twice
+ */
+typedef struct ServoAxis {
+    ServoAxisCfg cfg;
+    HI_S32 angle; // Q16, commanded angle
+    HI_S32 integ; // Q16, integrated error, degree seconds
+    HI_S32 vel; // Q16, filtered target angular velocity, degrees/s
+    HI_S32 lastTarget; // Q16, target angle of the previous update
+    HI_U64 lastPts; // us, 0 when there is no previous update
+    HI_U64 histUs[SERVO_HIST_NUM]; // us, when each commanded angle reaches the servo
+    HI_S32 histAngle[SERVO_HIST_NUM]; // Q16
+    HI_U32 histHead; // Next slot to write, the oldest entry
+} ServoAxis;
+
+void ServoAxisInit(ServoAxis* self, const ServoAxisCfg* cfg, HI_S32 angle);
+
+/*
+ * 目标丢失时清除积分和速度估计，保持当前角度
+ * Clear the integral and velocity estimate when the target is lost, the angle is kept
+ */
+void ServoAxisReset(ServoAxis* self);
+
+/*
+ * errPx为setpoint-目标位置，pts为帧采集时间(us)，leadUs为采集到舵机到位的总延迟
+ * 返回取整后的舵机角度
+ *
+ * errPx is the setpoint minus the target position, pts the frame capture time (us), leadUs the whole
+ * delay from capture until the servo gets there. Returns the servo angle rounded to whole degrees
+ */
+HI_S32 ServoAxisUpdate(ServoAxis* self, HI_S32 errPx, HI_U64 pts, HI_U32 leadUs);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件实现板端到舵机MCU的串口链路，带序号、时间戳和CRC，
+ * 通过MCU回传的ACK测量执行延迟并发现丢帧
+ *
+ * This file implements the board to servo MCU UART link with sequence numbers, timestamps and CRC,
+ * measuring the actuation delay and spotting drops through the ACKs sent back by the MCU.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "sample_media_ai.h"
+#include "uart_user.h"
+#include "servo_link.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+static uint32_t ServoLinkNowUs(void)
+{
+    HI_U64 now = 0;
+
+    HI_MPI_SYS_GetCurPTS(&now);
+    return (uint32_t)now;
+}
+
+void ServoLinkInit(ServoLink* self)
+{
+    HI_ASSERT(self);
+    if (memset_s(self, sizeof(*self), 0, sizeof(*self)) != EOK) {
+        HI_ASSERT(0);
+    }
+    ServoProtoParserInit(&self->parser);
+}
+
+int ServoLinkSend(ServoLink* self, const ServoSetpoint sp[], uint8_t cnt, HI_BOOL ackReq)
+{
+    uint8_t buf[SERVO_PROTO_FRAME_MAX];
+    ServoMsg msg;
+    int len;
+
+    if (cnt > SERVO_PROTO_SP_MAX) {
+        return HI_FAILURE;
+    }
+    msg.type = SERVO_MSG_SETPOINT;
+    msg.flags = ackReq ? SERVO_FLAG_ACK_REQ : 0;
+    msg.seq = __atomic_fetch_add(&self->seq, 1, __ATOMIC_RELAXED);
+    msg.ts = ServoLinkNowUs();
+    msg.cnt = cnt;
+    if (memcpy_s(msg.sp, sizeof(msg.sp), sp, sizeof(sp[0]) * cnt) != EOK) {
+        return HI_FAILURE;
+    }
+    len = ServoProtoPack(&msg, buf, sizeof(buf));
+    if (len < 0 || Uart1Send(buf, len) != len) {
+        SAMPLE_PRT("servo frame %u send FAIL\n", msg.seq);
+        return HI_FAILURE;
+    }
+    __atomic_fetch_add(&self->sentCnt, 1, __ATOMIC_RELAXED);
+    return HI_SUCCESS;
+}
+
+static void ServoLinkOnAck(ServoLink* self, const ServoMsg* msg)
+{
+    uint32_t rtt = ServoLinkNowUs() - msg->ts;
+    uint16_t gap = (uint16_t)(msg->seq - self->lastAckSeq);
+
+    /*
+     * 序号跳过的SETPOINT没有被确认；序号回退的是迟到的ACK，不计丢失
+     * SETPOINTs skipped over by seq were never acknowledged; a seq going back is a late ACK and not counted
+     */
+    if (self->acked && gap > 1 && gap < 0x8000) {
+        __atomic_fetch_add(&self->lostCnt, gap - 1, __ATOMIC_RELAXED);
+    }
+    if (!self->acked || (gap != 0 && gap < 0x8000)) {
+        self->lastAckSeq = msg->seq;
+    }
+    self->acked = HI_TRUE;
+    for (uint32_t i = 0; i < msg->cnt; i++) {
+        if (msg->sp[i].id < SERVO_PROTO_SP_MAX) {
+            self->applied[msg->sp[i].id] = msg->sp[i].angle;
+        }
+    }
+    __atomic_store_n(&self->rttUs, rtt, __ATOMIC_RELAXED);
+    if (rtt > __atomic_load_n(&self->rttMaxUs, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&self->rttMaxUs, rtt, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&self->ackCnt, 1, __ATOMIC_RELAXED);
+}
+
+void ServoLinkRecv(ServoLink* self, const uint8_t* data, int len)
+{
+    ServoMsg msg;
+
+    for (int i = 0; i < len; i++) {
+        if (ServoProtoParse(&self->parser, data[i], &msg) && msg.type == SERVO_MSG_ACK) {
+            ServoLinkOnAck(self, &msg);
+        }
+    }
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SERVO_LINK_H
+#define SERVO_LINK_H
+
+#include "hi_type.h"
+#include "servo_proto.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 板端串口舵机链路：按servo_proto打包下发角度，解析MCU的ACK，统计往返时间和丢帧
+ * 发送可在多个线程中调用，接收只在一个线程中调用
+ *
+ * Board side UART servo link: sends angles packed with servo_proto, parses the ACKs of the MCU,
+ * and keeps round trip time and drop statistics.
+ * Sending may be called from several threads, receiving from one thread only
+ */
+typedef struct ServoLink {
+    uint16_t seq;
+    ServoProtoParser parser;
+    HI_BOOL acked; // An ACK has been received, lastAckSeq is valid
+    uint16_t lastAckSeq;
+    uint16_t applied[SERVO_PROTO_SP_MAX]; // Angles of the latest ACK, 0.01 degree
+    HI_U32 sentCnt; // Read and cleared by the stats printer
+    HI_U32 ackCnt; // Read and cleared by the stats printer
+    HI_U32 lostCnt; // SETPOINTs never acknowledged, read and cleared by the stats printer
+    HI_U32 rttUs; // Round trip time of the latest ACK
+    HI_U32 rttMaxUs; // Read and cleared by the stats printer
+} ServoLink;
+
+void ServoLinkInit(ServoLink* self);
+
+/*
+ * 下发cnt个角度，ackReq为HI_TRUE时要求MCU回ACK
+ * Send cnt angles, asks the MCU for an ACK when ackReq is HI_TRUE
+ */
+int ServoLinkSend(ServoLink* self, const ServoSetpoint sp[], uint8_t cnt, HI_BOOL ackReq);
+
+/*
+ * 处理从串口读到的字节
+ * Handle bytes read from the UART
+ */
+void ServoLinkRecv(ServoLink* self, const uint8_t* data, int len);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
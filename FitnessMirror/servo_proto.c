@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件实现板端与舵机MCU之间串口帧的打包、校验和流式解析，不依赖任何一端的SDK
+ *
+ * This file implements packing, checking and stream parsing of the UART frames between the board and
+ * the servo MCU, without depending on the SDK of either side.
+ */
+
+#include <string.h>
+
+#include "servo_proto.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define CRC16_POLY      0x1021
+#define CRC16_INIT      0xFFFF
+#define OFF_VER         2
+#define OFF_TYPE        3
+#define OFF_SEQ         4
+#define OFF_TS          6
+#define OFF_CNT         10
+#define OFF_FLAGS       11
+
+#define PARSE_MORE      0
+#define PARSE_DONE      1
+#define PARSE_BAD       (-1)
+
+static void PutLe16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8); // 8: high byte
+}
+
+static uint16_t GetLe16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8)); // 8: high byte
+}
+
+uint16_t ServoProtoCrc16(const uint8_t* buf, uint32_t len)
+{
+    uint16_t crc = CRC16_INIT;
+
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)(buf[i] << 8); // 8: MSB first
+        for (int bit = 0; bit < 8; bit++) { // 8: bits per byte
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ CRC16_POLY) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+int ServoProtoPack(const ServoMsg* msg, uint8_t* buf, uint32_t bufSize)
+{
+    uint32_t len = SERVO_PROTO_HDR_LEN + (uint32_t)msg->cnt * SERVO_PROTO_SP_LEN;
+
+    if (msg->cnt > SERVO_PROTO_SP_MAX || bufSize < len + SERVO_PROTO_CRC_LEN) {
+        return -1;
+    }
+    buf[0] = SERVO_PROTO_SYNC0;
+    buf[1] = SERVO_PROTO_SYNC1;
+    buf[OFF_VER] = SERVO_PROTO_VER;
+    buf[OFF_TYPE] = msg->type;
+    PutLe16(buf + OFF_SEQ, msg->seq);
+    PutLe16(buf + OFF_TS, (uint16_t)msg->ts);
+    PutLe16(buf + OFF_TS + 2, (uint16_t)(msg->ts >> 16)); // 2, 16: high half
+    buf[OFF_CNT] = msg->cnt;
+    buf[OFF_FLAGS] = msg->flags;
+    for (uint32_t i = 0; i < msg->cnt; i++) {
+        uint8_t *sp = buf + SERVO_PROTO_HDR_LEN + i * SERVO_PROTO_SP_LEN;
+        sp[0] = msg->sp[i].id;
+        PutLe16(sp + 1, msg->sp[i].angle);
+    }
+    PutLe16(buf + len, ServoProtoCrc16(buf + OFF_VER, len - OFF_VER));
+    return (int)(len + SERVO_PROTO_CRC_LEN);
+}
+
+/*
+ * 检查buf开头是否为帧：PARSE_DONE为完整合法帧，PARSE_MORE为目前合法但未收齐，PARSE_BAD为非法
+ * Check for a frame at the start of buf: PARSE_DONE for a whole valid frame,
+ * PARSE_MORE for valid so far but incomplete, PARSE_BAD for invalid
+ */
+static int FrameCheck(const uint8_t* buf, uint32_t len, uint32_t* frameLen)
+{
+    uint32_t dataLen;
+
+    if ((len > 0 && buf[0] != SERVO_PROTO_SYNC0) || (len > 1 && buf[1] != SERVO_PROTO_SYNC1) ||
+        (len > OFF_VER && buf[OFF_VER] != SERVO_PROTO_VER)) {
+        return PARSE_BAD;
+    }
+    if (len <= OFF_CNT) {
+        return PARSE_MORE;
+    }
+    if (buf[OFF_CNT] > SERVO_PROTO_SP_MAX) {
+        return PARSE_BAD;
+    }
+    dataLen = SERVO_PROTO_HDR_LEN + (uint32_t)buf[OFF_CNT] * SERVO_PROTO_SP_LEN;
+    if (len < dataLen + SERVO_PROTO_CRC_LEN) {
+        return PARSE_MORE;
+    }
+    if (ServoProtoCrc16(buf + OFF_VER, dataLen - OFF_VER) != GetLe16(buf + dataLen)) {
+        return PARSE_BAD;
+    }
+    *frameLen = dataLen + SERVO_PROTO_CRC_LEN;
+    return PARSE_DONE;
+}
+
+static void FrameDecode(const uint8_t* buf, ServoMsg* msg)
+{
+    msg->type = buf[OFF_TYPE];
+    msg->seq = GetLe16(buf + OFF_SEQ);
+    msg->ts = GetLe16(buf + OFF_TS) | ((uint32_t)GetLe16(buf + OFF_TS + 2) << 16); // 2, 16: high half
+    msg->cnt = buf[OFF_CNT];
+    msg->flags = buf[OFF_FLAGS];
+    for (uint32_t i = 0; i < msg->cnt; i++) {
+        const uint8_t *sp = buf + SERVO_PROTO_HDR_LEN + i * SERVO_PROTO_SP_LEN;
+        msg->sp[i].id = sp[0];
+        msg->sp[i].angle = GetLe16(sp + 1);
+    }
+}
+
+int ServoProtoUnpack(const uint8_t* buf, uint32_t len, ServoMsg* msg)
+{
+    uint32_t frameLen = 0;
+
+    if (FrameCheck(buf, len, &frameLen) != PARSE_DONE) {
+        return -1;
+    }
+    FrameDecode(buf, msg);
+    return (int)frameLen;
+}
+
+void ServoProtoParserInit(ServoProtoParser* self)
+{
+    self->len = 0;
+    self->badCnt = 0;
+}
+
+int ServoProtoParse(ServoProtoParser* self, uint8_t byte, ServoMsg* msg)
+{
+    uint32_t frameLen = 0;
+    uint32_t skip;
+
+    self->buf[self->len++] = byte;
+    for (;;) {
+        int st = FrameCheck(self->buf, self->len, &frameLen);
+        if (st == PARSE_MORE) {
+            return 0;
+        }
+        if (st == PARSE_DONE) {
+            FrameDecode(self->buf, msg);
+            self->len -= frameLen;
+            memmove(self->buf, self->buf + frameLen, self->len);
+            return 1;
+        }
+
+        /*
+         * 丢掉首字节，从下一个同步字节开始重新检查已收到的字节
+         * Drop the first byte and check the bytes already received again from the next sync byte
+         */
+        self->badCnt++;
+        for (skip = 1; skip < self->len && self->buf[skip] != SERVO_PROTO_SYNC0; skip++) {
+        }
+        self->len -= skip;
+        memmove(self->buf, self->buf + skip, self->len);
+        if (self->len == 0) {
+            return 0;
+        }
+    }
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
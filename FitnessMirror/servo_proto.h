@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SERVO_PROTO_H
+#define SERVO_PROTO_H
+
+#include <stdint.h>
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 板端与舵机MCU之间的串口帧，板端和MCU固件共用本文件，多字节字段为小端
+ *
+ *   0  sync0 0xA5     1  sync1 0x5A     2  ver     3  type
+ *   4  seq(2)         6  ts(4), board time in us
+ *  10  cnt            11 flags
+ *  12  cnt x {id(1), angle(2), 0.01 degree}
+ *  ..  crc(2), CRC-16/CCITT-FALSE over ver..last setpoint
+ *
+ * UART frames between the board and the servo MCU. The board and the MCU firmware share this file,
+ * multi-byte fields are little endian.
+ * SETPOINT frames carry the target angles. ACK frames echo seq and ts of the SETPOINT they answer
+ * and carry the angles the MCU applied.
+ */
+#define SERVO_PROTO_SYNC0       0xA5
+#define SERVO_PROTO_SYNC1       0x5A
+#define SERVO_PROTO_VER         1
+#define SERVO_PROTO_HDR_LEN     12
+#define SERVO_PROTO_SP_LEN      3
+#define SERVO_PROTO_CRC_LEN     2
+#define SERVO_PROTO_SP_MAX      4
+#define SERVO_PROTO_FRAME_MAX   (SERVO_PROTO_HDR_LEN + SERVO_PROTO_SP_MAX * SERVO_PROTO_SP_LEN + SERVO_PROTO_CRC_LEN)
+
+#define SERVO_MSG_SETPOINT      1
+#define SERVO_MSG_ACK           2
+
+#define SERVO_FLAG_ACK_REQ      0x01 // SETPOINT: the MCU should answer with an ACK
+
+typedef struct ServoSetpoint {
+    uint8_t id; // Servo index on the MCU
+    uint16_t angle; // 0.01 degree
+} ServoSetpoint;
+
+typedef struct ServoMsg {
+    uint8_t type;
+    uint8_t flags;
+    uint16_t seq;
+    uint32_t ts;
+    uint8_t cnt;
+    ServoSetpoint sp[SERVO_PROTO_SP_MAX];
+} ServoMsg;
+
+/*
+ * 逐字节解析的状态，丢字节、粘包或校验错时从下一个同步字节重新同步
+ * Byte by byte parser state, resynchronizes at the next sync byte after lost bytes, merged frames or bad CRCs
+ */
+typedef struct ServoProtoParser {
+    uint8_t buf[SERVO_PROTO_FRAME_MAX];
+    uint32_t len;
+    uint32_t badCnt; // Frames or bytes thrown away while resynchronizing
+} ServoProtoParser;
+
+uint16_t ServoProtoCrc16(const uint8_t* buf, uint32_t len);
+
+/*
+ * 打包msg，返回帧长，buf不足或cnt过大时返回-1
+ * Pack msg, returns the frame length, -1 when buf is too small or cnt too big
+ */
+int ServoProtoPack(const ServoMsg* msg, uint8_t* buf, uint32_t bufSize);
+
+/*
+ * 解析buf开头的一整帧，成功返回帧长，否则返回-1
+ * Parse one whole frame at the start of buf, returns the frame length on success, otherwise -1
+ */
+int ServoProtoUnpack(const uint8_t* buf, uint32_t len, ServoMsg* msg);
+
+void ServoProtoParserInit(ServoProtoParser* self);
+
+/*
+ * 输入一个字节，凑齐一帧合法帧时写入msg并返回1，否则返回0
+ * Feed one byte, returns 1 with msg filled in when a valid frame is complete, otherwise 0
+ */
+int ServoProtoParse(ServoProtoParser* self, uint8_t byte, ServoMsg* msg);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,172 @@
+#include "pinctrl.h"
+#include "gpio.h"
+#include "timer.h"
+#include "tcxo.h"
+#include "soc_osal.h"
+#include "servo_pwm.h"
+
+/*
+ * 一个硬件定时器按周期内的边沿依次触发：周期开始时锁存新脉宽并把各通道拉高，
+ * 之后按脉宽从短到长依次拉低，最后一个边沿之后定时到下一周期开始。
+ * 每个边沿按绝对时间(tcxo)排定，定时器只计到下一个边沿剩余的时间，中断响应延迟不会在周期内累积。
+ * 任务只写待生效缓冲(两路脉宽打包成一个32位数，读写都是原子的)，中断里不会读到一半更新的值。
+ */
+#define SERVO_PWM_TIMER_INDEX       TIMER_INDEX_1
+#define SERVO_PWM_TIMER_IRQ         TIMER_1_IRQN
+#define SERVO_PWM_TIMER_PRIO        1
+#define PULSE_SHIFT(ch)             ((ch) * 16)
+#define PULSE_MASK                  0xFFFF
+
+typedef struct
+{
+    uint16_t at;        /* 相对周期开始的时间(us) */
+    uint8_t mask;       /* 在该时刻拉低的通道 */
+} PwmEdge;
+
+static pin_t pwmPins[SERVO_PWM_CH_NUM];
+static timer_handle_t pwmTimer = NULL;
+static uint32_t pendingPulse = 0;   /* 通道ch的脉宽在PULSE_SHIFT(ch)处 */
+static PwmEdge edges[SERVO_PWM_CH_NUM];
+static uint8_t edgeNum = 0;
+static uint8_t edgeIdx = 0;
+static uint32_t periodCnt = 0;
+static uint64_t periodStartUs = 0;  /* 本周期开始的绝对时间 */
+static ServoPwmHook periodHook = NULL;
+
+static void servoPwmTimerCb(uintptr_t data);
+
+/* 周期开始：锁存脉宽，拉高各通道，按脉宽排好本周期的下降沿 */
+static uint32_t servoPwmPeriodStart(void)
+{
+    uint32_t pulses;
+
+    if(periodHook != NULL)
+    {
+        periodHook();
+    }
+    pulses = __atomic_load_n(&pendingPulse, __ATOMIC_ACQUIRE);
+
+    edgeNum = 0;
+    for(uint8_t ch = 0; ch < SERVO_PWM_CH_NUM; ch++)
+    {
+        uint16_t pulse = (uint16_t)((pulses >> PULSE_SHIFT(ch)) & PULSE_MASK);
+        uint8_t i;
+        if(pulse == 0)
+        {
+            continue;
+        }
+        uapi_gpio_set_val(pwmPins[ch], GPIO_LEVEL_HIGH);
+        for(i = 0; i < edgeNum && edges[i].at != pulse; i++)
+        {
+        }
+        if(i < edgeNum)
+        {
+            edges[i].mask |= (uint8_t)(1 << ch);
+            continue;
+        }
+        for(i = edgeNum; i > 0 && edges[i - 1].at > pulse; i--)
+        {
+            edges[i] = edges[i - 1];
+        }
+        edges[i].at = pulse;
+        edges[i].mask = (uint8_t)(1 << ch);
+        edgeNum++;
+    }
+    edgeIdx = 0;
+    periodStartUs += SERVO_PWM_PERIOD_US;
+    periodCnt++;
+    return edgeNum > 0 ? edges[0].at : SERVO_PWM_PERIOD_US;
+}
+
+static void servoPwmTimerCb(uintptr_t data)
+{
+    uint32_t next;
+    uint64_t now;
+    unused(data);
+
+    if(edgeIdx >= edgeNum)
+    {
+        next = servoPwmPeriodStart();
+    }
+    else
+    {
+        PwmEdge *e = &edges[edgeIdx];
+        for(uint8_t ch = 0; ch < SERVO_PWM_CH_NUM; ch++)
+        {
+            if(e->mask & (1 << ch))
+            {
+                uapi_gpio_set_val(pwmPins[ch], GPIO_LEVEL_LOW);
+            }
+        }
+        edgeIdx++;
+        next = edgeIdx < edgeNum ? edges[edgeIdx].at : SERVO_PWM_PERIOD_US;
+    }
+    /* 已经晚于下一个边沿时尽快触发 */
+    now = uapi_tcxo_get_us();
+    next = periodStartUs + next > now ? (uint32_t)(periodStartUs + next - now) : 1;
+    uapi_timer_start(pwmTimer, next, servoPwmTimerCb, 0);
+}
+
+int ServoPwmInit(const pin_t pins[SERVO_PWM_CH_NUM])
+{
+    for(uint8_t ch = 0; ch < SERVO_PWM_CH_NUM; ch++)
+    {
+        pwmPins[ch] = pins[ch];
+        uapi_pin_set_mode(pins[ch], PIN_MODE_0);
+        uapi_gpio_set_dir(pins[ch], GPIO_DIRECTION_OUTPUT);
+        uapi_gpio_set_val(pins[ch], GPIO_LEVEL_LOW);
+    }
+
+    uapi_timer_init();
+    uapi_timer_adapter(SERVO_PWM_TIMER_INDEX, SERVO_PWM_TIMER_IRQ, SERVO_PWM_TIMER_PRIO);
+    if(uapi_timer_create(SERVO_PWM_TIMER_INDEX, &pwmTimer) != ERRCODE_SUCC)
+    {
+        osal_printk("servo pwm timer create fail!\r\n");
+        return -1;
+    }
+    edgeNum = 0;
+    edgeIdx = 0;
+    periodStartUs = uapi_tcxo_get_us();     /* 第一个周期从一个周期之后开始 */
+    if(uapi_timer_start(pwmTimer, SERVO_PWM_PERIOD_US, servoPwmTimerCb, 0) != ERRCODE_SUCC)
+    {
+        osal_printk("servo pwm timer start fail!\r\n");
+        return -1;
+    }
+    return 0;
+}
+
+void ServoPwmSet(uint8_t ch, uint16_t pulseUs)
+{
+    uint32_t old, val;
+
+    if(ch >= SERVO_PWM_CH_NUM)
+    {
+        return;
+    }
+    if(pulseUs != 0)
+    {
+        pulseUs = pulseUs < SERVO_PWM_PULSE_MIN_US ? SERVO_PWM_PULSE_MIN_US :
+            (pulseUs > SERVO_PWM_PULSE_MAX_US ? SERVO_PWM_PULSE_MAX_US : pulseUs);
+    }
+    old = __atomic_load_n(&pendingPulse, __ATOMIC_RELAXED);
+    do
+    {
+        val = (old & ~((uint32_t)PULSE_MASK << PULSE_SHIFT(ch))) | ((uint32_t)pulseUs << PULSE_SHIFT(ch));
+    } while(!__atomic_compare_exchange_n(&pendingPulse, &old, val, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+uint16_t ServoPwmAngleToPulse(uint16_t angleCdeg, uint16_t rangeDeg)
+{
+    uint32_t span = SERVO_PWM_PULSE_MAX_US - SERVO_PWM_PULSE_MIN_US;
+    return (uint16_t)(SERVO_PWM_PULSE_MIN_US + (uint32_t)angleCdeg * span / ((uint32_t)rangeDeg * 100));
+}
+
+void ServoPwmSetPeriodHook(ServoPwmHook hook)
+{
+    periodHook = hook;
+}
+
+uint32_t ServoPwmPeriodCnt(void)
+{
+    return __atomic_load_n(&periodCnt, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,29 @@
+#ifndef SERVO_PWM_H
+#define SERVO_PWM_H
+
+#include <stdint.h>
+#include "pinctrl.h"
+
+/* 舵机PWM：硬件定时器中断驱动，两路同时输出，周期固定20ms(50Hz) */
+#define SERVO_PWM_CH_NUM            2
+#define SERVO_PWM_PERIOD_US         20000
+#define SERVO_PWM_PULSE_MIN_US      500
+#define SERVO_PWM_PULSE_MAX_US      2500
+
+/* 初始化引脚和定时器并开始输出，脉宽为0的通道保持低电平 */
+int ServoPwmInit(const pin_t pins[SERVO_PWM_CH_NUM]);
+
+/* 设置通道脉宽(us)，写入待生效缓冲，下一个周期开始时生效，可在任务中随时调用 */
+void ServoPwmSet(uint8_t ch, uint16_t pulseUs);
+
+/* 角度(0.01度)换算为脉宽，rangeDeg为舵机全行程角度 */
+uint16_t ServoPwmAngleToPulse(uint16_t angleCdeg, uint16_t rangeDeg);
+
+/* 每个周期开始、锁存脉宽之前在中断中调用，在钩子里ServoPwmSet的脉宽本周期即生效 */
+typedef void (*ServoPwmHook)(void);
+void ServoPwmSetPeriodHook(ServoPwmHook hook);
+
+/* 已输出的周期数 */
+uint32_t ServoPwmPeriodCnt(void);
+
+#endif
@@ -0,0 +1,152 @@
+#include "servo_pwm.h"
+#include "servo_traj.h"
+
+/*
+ * 位置和速度用Q8定点，单位分别为0.01度和0.01度/周期，加速度为0.01度/周期^2。
+ * 每周期期望速度取 min(velMax, 以acc逐周期减速恰好停在目标的速度)，实际速度向期望速度最多改变acc，
+ * 于是远离目标时按加速度上限加速到velMax，接近目标时沿刹车曲线减速，形成梯形速度曲线。
+ */
+#define TRAJ_Q                      8
+#define TRAJ_PERIOD_US              SERVO_PWM_PERIOD_US
+#define US_PER_S                    1000000ULL
+#define CDEG_PER_DEG                100
+
+typedef struct
+{
+    ServoTrajCfg cfg;
+    int32_t vMax;           /* Q8 0.01度/周期 */
+    int32_t acc;            /* Q8 0.01度/周期^2 */
+    int32_t pos;            /* Q8 0.01度 */
+    int32_t vel;            /* Q8 0.01度/周期 */
+    uint16_t target;        /* 任务写，中断读 */
+    uint16_t out;           /* 中断写，任务读 */
+} TrajAxis;
+
+static TrajAxis axes[SERVO_TRAJ_AXIS_NUM];
+
+static uint32_t trajIsqrt(uint64_t x)
+{
+    uint64_t r = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while(bit > x)
+    {
+        bit >>= 2;
+    }
+    while(bit != 0)
+    {
+        if(x >= r + bit)
+        {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        }
+        else
+        {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+static uint16_t trajClamp(const ServoTrajCfg *cfg, uint16_t cdeg)
+{
+    return cdeg < cfg->minCdeg ? cfg->minCdeg : (cdeg > cfg->maxCdeg ? cfg->maxCdeg : cdeg);
+}
+
+void ServoTrajInit(const ServoTrajCfg cfg[SERVO_TRAJ_AXIS_NUM], const uint16_t pos[SERVO_TRAJ_AXIS_NUM])
+{
+    for(uint8_t i = 0; i < SERVO_TRAJ_AXIS_NUM; i++)
+    {
+        TrajAxis *a = &axes[i];
+        a->cfg = cfg[i];
+        a->vMax = (int32_t)(((uint64_t)cfg[i].velMax * CDEG_PER_DEG * TRAJ_PERIOD_US << TRAJ_Q) / US_PER_S);
+        a->acc = (int32_t)(((uint64_t)cfg[i].accMax * CDEG_PER_DEG * TRAJ_PERIOD_US * TRAJ_PERIOD_US / US_PER_S
+            << TRAJ_Q) / US_PER_S);
+        a->acc = a->acc > 0 ? a->acc : 1;
+        a->target = trajClamp(&cfg[i], pos[i]);
+        a->out = a->target;
+        a->pos = (int32_t)a->target << TRAJ_Q;
+        a->vel = 0;
+        ServoPwmSet(i, ServoPwmAngleToPulse(a->out, cfg[i].rangeDeg));
+    }
+    ServoPwmSetPeriodHook(ServoTrajStep);
+}
+
+uint16_t ServoTrajSetTarget(uint8_t axis, uint16_t cdeg)
+{
+    if(axis >= SERVO_TRAJ_AXIS_NUM)
+    {
+        return 0;
+    }
+    cdeg = trajClamp(&axes[axis].cfg, cdeg);
+    __atomic_store_n(&axes[axis].target, cdeg, __ATOMIC_RELAXED);
+    return cdeg;
+}
+
+uint16_t ServoTrajPos(uint8_t axis)
+{
+    return axis < SERVO_TRAJ_AXIS_NUM ? __atomic_load_n(&axes[axis].out, __ATOMIC_RELAXED) : 0;
+}
+
+static void trajStepAxis(uint8_t ch, TrajAxis *a)
+{
+    int32_t target = (int32_t)__atomic_load_n(&a->target, __ATOMIC_RELAXED) << TRAJ_Q;
+    int32_t err = target - a->pos;
+    int32_t vDes;
+
+    if(err == 0 && a->vel == 0)
+    {
+        return;
+    }
+    /*
+     * 每周期减acc刹车，从速度v到停下走过 v*(v+acc)/(2*acc)，令其等于剩余距离解出v，
+     * 即 (sqrt(acc^2 + 8*acc*|err|) - acc) / 2，结果仍是Q8
+     */
+    vDes = ((int32_t)trajIsqrt((uint64_t)a->acc * (uint64_t)a->acc +
+        8ULL * (uint64_t)a->acc * (uint64_t)(err < 0 ? -err : err)) - a->acc) / 2;
+    vDes = vDes < a->vMax ? vDes : a->vMax;
+    vDes = err < 0 ? -vDes : vDes;
+
+    if(vDes > a->vel + a->acc)
+    {
+        a->vel += a->acc;
+    }
+    else if(vDes < a->vel - a->acc)
+    {
+        a->vel -= a->acc;
+    }
+    else
+    {
+        a->vel = vDes;
+    }
+
+    /* 这一步会越过目标时直接停在目标上 */
+    if((err > 0 && a->vel >= err) || (err < 0 && a->vel <= err))
+    {
+        a->pos = target;
+        a->vel = 0;
+    }
+    else
+    {
+        a->pos += a->vel;
+    }
+    /* 行程限位兜底，定点舍入不会让舵机顶到机械限位 */
+    if(a->pos < ((int32_t)a->cfg.minCdeg << TRAJ_Q) || a->pos > ((int32_t)a->cfg.maxCdeg << TRAJ_Q))
+    {
+        a->pos = a->pos < ((int32_t)a->cfg.minCdeg << TRAJ_Q) ?
+            ((int32_t)a->cfg.minCdeg << TRAJ_Q) : ((int32_t)a->cfg.maxCdeg << TRAJ_Q);
+        a->vel = 0;
+    }
+    uint16_t out = (uint16_t)((a->pos + (1 << (TRAJ_Q - 1))) >> TRAJ_Q);
+    __atomic_store_n(&a->out, out, __ATOMIC_RELAXED);
+    ServoPwmSet(ch, ServoPwmAngleToPulse(out, a->cfg.rangeDeg));
+}
+
+void ServoTrajStep(void)
+{
+    for(uint8_t i = 0; i < SERVO_TRAJ_AXIS_NUM; i++)
+    {
+        trajStepAxis(i, &axes[i]);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef SERVO_TRAJ_H
+#define SERVO_TRAJ_H
+
+#include <stdint.h>
+
+/*
+ * 舵机轨迹：在PWM每个周期开始时(50Hz)把各轴从当前位置向最新目标角度推进一步，
+ * 速度和加速度按轴限幅(梯形速度曲线)，接近目标时按加速度上限刹车，不会冲过目标。
+ */
+#define SERVO_TRAJ_AXIS_NUM         2
+
+typedef struct
+{
+    uint16_t velMax;        /* 最大角速度(度/秒) */
+    uint16_t accMax;        /* 最大角加速度(度/秒^2) */
+    uint16_t minCdeg;       /* 角度范围(0.01度) */
+    uint16_t maxCdeg;
+    uint16_t rangeDeg;      /* 舵机全行程角度，用于换算脉宽 */
+} ServoTrajCfg;
+
+/* 初始化各轴并挂到PWM周期上，pos为起始角度(0.01度)，需在ServoPwmInit之前调用 */
+void ServoTrajInit(const ServoTrajCfg cfg[SERVO_TRAJ_AXIS_NUM], const uint16_t pos[SERVO_TRAJ_AXIS_NUM]);
+
+/* 设置目标角度(0.01度)，超出范围会被限幅，返回限幅后的值，可在任务中随时调用 */
+uint16_t ServoTrajSetTarget(uint8_t axis, uint16_t cdeg);
+
+/* 当前输出的角度(0.01度) */
+uint16_t ServoTrajPos(uint8_t axis);
+
+/* 推进一个PWM周期，由PWM周期钩子在中断中调用 */
+void ServoTrajStep(void);
+
+#endif
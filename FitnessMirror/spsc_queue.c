@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "sample_media_ai.h"
+#include "spsc_queue.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+int SpscQueueInit(SpscQueue* self, HI_U32 capacity, HI_U32 elemSize)
+{
+    HI_ASSERT(self);
+    HI_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+    self->buf = (HI_U8*)malloc((size_t)capacity * elemSize);
+    if (self->buf == NULL) {
+        SAMPLE_PRT("spsc queue malloc %u x %u FAIL\n", capacity, elemSize);
+        return HI_FAILURE;
+    }
+    self->elemSize = elemSize;
+    self->mask = capacity - 1;
+    self->head = 0;
+    self->tail = 0;
+    return HI_SUCCESS;
+}
+
+void SpscQueueDeinit(SpscQueue* self)
+{
+    HI_ASSERT(self);
+    free(self->buf);
+    self->buf = NULL;
+}
+
+int SpscQueuePush(SpscQueue* self, const void* elem)
+{
+    HI_U32 head = self->head;
+    HI_U32 tail = __atomic_load_n(&self->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail > self->mask) {
+        return HI_FAILURE;
+    }
+    memcpy(self->buf + (size_t)(head & self->mask) * self->elemSize, elem, self->elemSize);
+    __atomic_store_n(&self->head, head + 1, __ATOMIC_RELEASE);
+    return HI_SUCCESS;
+}
+
+int SpscQueuePop(SpscQueue* self, void* elem)
+{
+    HI_U32 tail = self->tail;
+    HI_U32 head = __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return HI_FAILURE;
+    }
+    memcpy(elem, self->buf + (size_t)(tail & self->mask) * self->elemSize, self->elemSize);
+    __atomic_store_n(&self->tail, tail + 1, __ATOMIC_RELEASE);
+    return HI_SUCCESS;
+}
+
+HI_U32 SpscQueueCount(const SpscQueue* self)
+{
+    return __atomic_load_n(&self->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&self->tail, __ATOMIC_ACQUIRE);
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
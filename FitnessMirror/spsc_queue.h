@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include "hi_type.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 有界无锁单生产者单消费者队列，元素按值拷贝
+ * head只由生产者推进，tail只由消费者推进
+ *
+ * Bounded lock-free single-producer single-consumer queue, elements are copied by value.
+ * head is only advanced by the producer, tail only by the consumer.
+ */
+typedef struct SpscQueue {
+    HI_U8 *buf;
+    HI_U32 elemSize;
+    HI_U32 mask; // capacity - 1, capacity is a power of two
+    HI_U32 head;
+    HI_U32 tail;
+} SpscQueue;
+
+/*
+ * 创建队列，capacity必须为2的幂
+ * Create the queue, capacity must be a power of two
+ */
+int SpscQueueInit(SpscQueue* self, HI_U32 capacity, HI_U32 elemSize);
+
+/*
+ * 销毁队列
+ * Destroy the queue
+ */
+void SpscQueueDeinit(SpscQueue* self);
+
+/*
+ * 生产者入队，队满时返回HI_FAILURE
+ * Producer side enqueue, HI_FAILURE when the queue is full
+ */
+int SpscQueuePush(SpscQueue* self, const void* elem);
+
+/*
+ * 消费者出队，队空时返回HI_FAILURE
+ * Consumer side dequeue, HI_FAILURE when the queue is empty
+ */
+int SpscQueuePop(SpscQueue* self, void* elem);
+
+/*
+ * 当前队列中的元素个数
+ * Number of elements currently queued
+ */
+HI_U32 SpscQueueCount(const SpscQueue* self);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -3,35 +3,43 @@
 #include "soc_osal.h"
 #include "app_init.h"
 #include "gpio.h"
+#include "servo_proto.h"
+#include "servo_pwm.h"
+#include "servo_traj.h"
 
 /* UART传输线程 */
 #define UART1                       1
 #define UART1_TXD_PIN               (GPIO_15)
 #define UART1_RXD_PIN               (GPIO_16)
 #define UART_BAUDRATE               230400
-#define UART_RX_BUF_SIZE            4
+#define UART_RX_BUF_SIZE            64
+#define UART_RING_SIZE              256     /* 2的幂 */
+#define UART_RING_MASK              (UART_RING_SIZE - 1)
+#define UART_WAIT_MS                1000
+#define UART_LOG_EVERY              50      /* 每50帧打印一次角度 */
 #define UART_TASK_PRIO              16
 #define UART_TASK_STACK_SIZE        0x1200
-#define UART_RX_LENGTH              4
-#define UART_TX_LENGTH              4
 #define LED_PIN                     (GPIO_02)
 
-/* 舵机线程 */
-#define PWM_TASK_STACK_SIZE         0x1200
-#define PWM1_TASK_PRIO              20
-#define PWM2_TASK_PRIO              21
+/* 舵机PWM，由定时器中断输出，见servo_pwm.c */
 #define PWM1_PIN                    (GPIO_10)
 #define PWM2_PIN                    (GPIO_12)
-#define PWM_HIGH(pin)               (uapi_gpio_set_val(pin, GPIO_LEVEL_HIGH))
-#define PWM_LOW(pin)                (uapi_gpio_set_val(pin, GPIO_LEVEL_LOW))
-#define PWM_PERIOD                  (20000)
+#define PWM1_RANGE                  270     /* 舵机全行程角度 */
+#define PWM2_RANGE                  180
+#define TILT_MIN_CDEG               8000
+#define TILT_MAX_CDEG               16000
+#define PAN_VEL_MAX                 300     /* 度/秒 */
+#define PAN_ACC_MAX                 1500    /* 度/秒^2 */
+#define TILT_VEL_MAX                200
+#define TILT_ACC_MAX                1000
+#define SERVO_ID_PAN                0   /* 与板端hand_classify.c一致 */
+#define SERVO_ID_TILT               1
+#define SERVO_CDEG_PER_DEG          100
 
 static void app_uart_read_int_handler(const void *buffer, uint16_t length, bool error);
 void LED_Init(void);
 void LED_BLINK(void);
 void PWM_Init(void);
-uint8_t dataCheck(uint8_t* buf);
-void setAngle(uint8_t angle, uint8_t pwmPin, uint16_t range);
 
 uint8_t uartRcvBuf[UART_RX_BUF_SIZE] = {0};
 static uart_buffer_config_t uartBufferConfig = {
@@ -72,70 +80,143 @@ static void uart1_Init(void)
     }
 }
 
-uint8_t intRcvFlag = 0;
+/*
+ * 接收环形缓冲：中断只往head写，uart_task只从tail读，单生产者单消费者无锁。
+ * 中断不解析，每次回调把收到的字节全部放进环里并唤醒任务，任务逐字节喂给解析器，
+ * 被拆开或粘在一起的帧都能正确拼出，错位时解析器自己找下一个帧头。
+ */
+static uint8_t rxRing[UART_RING_SIZE];
+static uint32_t rxHead = 0;
+static uint32_t rxTail = 0;
+static uint32_t rxOverflow = 0;     /* 环满丢掉的字节数 */
+static osal_semaphore rxSem;
+
 static void app_uart_read_int_handler(const void *buffer, uint16_t length, bool error)
 {
+    const uint8_t *buff = (const uint8_t *)buffer;
+    uint32_t head = rxHead;
+    uint32_t tail = __atomic_load_n(&rxTail, __ATOMIC_ACQUIRE);
+    uint16_t i;
+
     unused(error);
     if (buffer == NULL || length == 0) 
     {
-        osal_printk("uart int mode transfer illegal data!\r\n");
         return;
     }
 
-    uint8_t *buff = (uint8_t *)buffer;
-    uint16_t intRcvLength = length;
-    if(intRcvLength == UART_RX_LENGTH && dataCheck(buff) == 0)
+    for(i = 0; i < length && head - tail < UART_RING_SIZE; i++)
     {
-        if(memcpy_s(uartRcvBuf, length, buff, length) == EOK)
+        rxRing[head & UART_RING_MASK] = buff[i];
+        head++;
+    }
+    rxOverflow += length - i;
+    __atomic_store_n(&rxHead, head, __ATOMIC_RELEASE);
+    osal_sem_up(&rxSem);
+}
+
+uint16_t angle1 = 90 * SERVO_CDEG_PER_DEG;     /* 目标角度，0.01度 */
+uint16_t angle2 = 140 * SERVO_CDEG_PER_DEG;
+static uint16_t lastSeq = 0;
+static uint8_t seqValid = 0;
+static uint32_t lostCnt = 0;
+static ServoProtoParser parser;
+
+/* 应用一帧中的各个角度，作为轨迹目标，由PWM周期按速度/加速度上限平滑逼近 */
+static void applySetpoints(const ServoMsg *msg)
+{
+    for(uint8_t i = 0; i < msg->cnt; i++)
+    {
+        if(msg->sp[i].id == SERVO_ID_PAN)
         {
-            intRcvFlag = 1;
-            osal_printk("recvLength:%u\r\n", intRcvLength);
+            angle1 = ServoTrajSetTarget(0, msg->sp[i].angle);
         }
-        else
+        else if(msg->sp[i].id == SERVO_ID_TILT)
         {
-            osal_printk("memcopy fail!\r\n");
+            angle2 = ServoTrajSetTarget(1, msg->sp[i].angle);
         }
-        return;
     }
-    else
+}
+
+/* 回ACK：回显seq和ts，带上舵机当前输出的角度 */
+static void sendAck(const ServoMsg *msg)
+{
+    uint8_t buf[SERVO_PROTO_FRAME_MAX];
+    ServoMsg ack = {
+        .type = SERVO_MSG_ACK,
+        .flags = 0,
+        .seq = msg->seq,
+        .ts = msg->ts,
+        .cnt = 2,
+        .sp = {
+            { SERVO_ID_PAN, ServoTrajPos(0) },
+            { SERVO_ID_TILT, ServoTrajPos(1) },
+        },
+    };
+    int len = ServoProtoPack(&ack, buf, sizeof(buf));
+    if(len > 0)
     {
-        osal_printk("illegal data!: %u %x\r\n", intRcvLength, buff[0]);
-        return;
+        uapi_uart_write(UART1, buf, (uint32_t)len, 0);
+    }
+}
+
+static uint32_t frameCnt = 0;
+
+/* 处理一帧设定值：统计丢帧，立即写入PWM，按需回ACK */
+static void handleSetpoint(const ServoMsg *msg)
+{
+    if(seqValid && (uint16_t)(msg->seq - lastSeq) != 1)
+    {
+        lostCnt += (uint16_t)(msg->seq - lastSeq) - 1;
+        osal_printk("seq gap: %u -> %u, lost %u\r\n", lastSeq, msg->seq, lostCnt);
+    }
+    lastSeq = msg->seq;
+    seqValid = 1;
+    applySetpoints(msg);
+    if(msg->flags & SERVO_FLAG_ACK_REQ)
+    {
+        sendAck(msg);
+    }
+    if(++frameCnt % UART_LOG_EVERY == 0)
+    {
+        osal_printk("angle: %u %u -> %u %u, bad %u, overflow %u\r\n",
+            ServoTrajPos(0), ServoTrajPos(1), angle1, angle2, parser.badCnt, rxOverflow);
+        LED_BLINK();
     }
 }
 
-uint8_t angle1 = 90;
-uint8_t angle2 = 140;
 static void *uart_task(void)
 {
+    ServoMsg msg;
+
+    ServoProtoParserInit(&parser);
+    if(osal_sem_init(&rxSem, 0) != OSAL_SUCCESS)
+    {
+        osal_printk("uart rx sem init fail!\r\n");
+        return NULL;
+    }
     uart1_PinInit();
     uart1_Init();
 
     while(1) 
     {
-        if(intRcvFlag == 1)
+        /* 超时只是兜底，正常由中断唤醒 */
+        osal_sem_down_timeout(&rxSem, UART_WAIT_MS);
+        uint32_t tail = rxTail;
+        uint32_t head;
+        /* 处理期间中断可能又写入了数据，读空为止 */
+        while((head = __atomic_load_n(&rxHead, __ATOMIC_ACQUIRE)) != tail)
         {
-            angle1 = uartRcvBuf[1];
-            angle2 = uartRcvBuf[2];
-            if(angle2 < 80) angle2 = 80;
-            if(angle2 > 160) angle2 = 160;
-            osal_printk("angle: %u %u\r\n", angle1, angle2);
-            LED_BLINK();
-            intRcvFlag = 0;
+            while(tail != head)
+            {
+                uint8_t byte = rxRing[tail & UART_RING_MASK];
+                tail++;
+                if(ServoProtoParse(&parser, byte, &msg) && msg.type == SERVO_MSG_SETPOINT)
+                {
+                    handleSetpoint(&msg);
+                }
+            }
+            __atomic_store_n(&rxTail, tail, __ATOMIC_RELEASE);
         }
-        osal_msleep(5);
-    }
-    return NULL;
-}
-
-static void *servo_task(void)
-{
-    while(1)
-    {
-        setAngle(angle1, PWM1_PIN, 270);
-        osal_msleep(10);
-        setAngle(angle2, PWM2_PIN, 180);
-        osal_msleep(10);
     }
     return NULL;
 }
@@ -154,77 +235,16 @@ static void uartTaskEntry(void)
     osal_kthread_unlock();
 }
 
-static void servoTaskEntry(void)
-{
-    osal_task *task_handle = NULL;
-    osal_kthread_lock();
-    task_handle = osal_kthread_create((osal_kthread_handler)servo_task, NULL, "servo_task", PWM_TASK_STACK_SIZE);
-    if (task_handle != NULL) {
-        osal_kthread_set_priority(task_handle, PWM1_TASK_PRIO);
-    } else {
-        osal_printk("Create servo_task fail.\r\n");
-    }
-    osal_kfree(task_handle);
-    osal_kthread_unlock();
-}
-
 /* Run the main. */
 static void main_entry(void)
 {
     LED_Init();
     PWM_Init();
     uartTaskEntry();
-    servoTaskEntry();
 }
 app_run(main_entry);
 /* End. */
 
-void setAngle(uint8_t angle, uint8_t pwmPin, uint16_t range)
-{
-    uint8_t i = 0;
-    uint32_t usDelay = 500 + angle * (2000) / range; //us
-
-    PWM_HIGH(pwmPin);
-    osal_udelay(usDelay);
-    PWM_LOW(pwmPin);
-    osal_udelay(PWM_PERIOD - usDelay);
-
-    PWM_HIGH(pwmPin);
-    osal_udelay(usDelay);
-    PWM_LOW(pwmPin);
-    osal_udelay(PWM_PERIOD - usDelay);
-
-    PWM_HIGH(pwmPin);
-    osal_udelay(usDelay);
-    PWM_LOW(pwmPin);
-    osal_udelay(PWM_PERIOD - usDelay);
-
-    PWM_HIGH(pwmPin);
-    osal_udelay(usDelay);
-    PWM_LOW(pwmPin);
-    osal_udelay(PWM_PERIOD - usDelay);
-
-    PWM_HIGH(pwmPin);
-    osal_udelay(usDelay);
-    PWM_LOW(pwmPin);
-    osal_udelay(PWM_PERIOD - usDelay);
-}
-
-// void setAngle(uint8_t angle, uint8_t pwmPin, uint16_t range)
-// {
-//     uint8_t i = 0, msDelay = 0;
-//     uint16_t usDelay2; //us
-//     uint32_t usDelay1 = 500 + angle * (2000) / range; //us
-//     msDelay = (PWM_PERIOD - usDelay1) / 1000;
-//     usDelay2 = PWM_PERIOD - usDelay1 - msDelay * 1000;
-
-//     PWM_HIGH(pwmPin);
-//     osal_udelay(usDelay1);
-//     PWM_LOW(pwmPin);
-//     osal_udelay(usDelay2);
-//     osal_msleep(msDelay);
-// }
-
 void LED_Init(void)
 {
     uapi_pin_set_mode(LED_PIN, PIN_MODE_0);
@@ -239,47 +259,16 @@ void LED_BLINK(void)
 
 void PWM_Init(void)
 {
-    uapi_pin_set_mode(PWM1_PIN, PIN_MODE_0);
-    uapi_gpio_set_dir(PWM1_PIN, GPIO_DIRECTION_OUTPUT);
-    uapi_gpio_set_val(PWM1_PIN, GPIO_LEVEL_LOW);
-
-    uapi_pin_set_mode(PWM2_PIN, PIN_MODE_0);
-    uapi_gpio_set_dir(PWM2_PIN, GPIO_DIRECTION_OUTPUT);
-    uapi_gpio_set_val(PWM2_PIN, GPIO_LEVEL_LOW);
-}
+    const pin_t pins[SERVO_PWM_CH_NUM] = { PWM1_PIN, PWM2_PIN };
+    const ServoTrajCfg cfg[SERVO_TRAJ_AXIS_NUM] = {
+        { PAN_VEL_MAX, PAN_ACC_MAX, 0, PWM1_RANGE * SERVO_CDEG_PER_DEG, PWM1_RANGE },
+        { TILT_VEL_MAX, TILT_ACC_MAX, TILT_MIN_CDEG, TILT_MAX_CDEG, PWM2_RANGE },
+    };
+    const uint16_t pos[SERVO_TRAJ_AXIS_NUM] = { angle1, angle2 };
 
-uint8_t dataCheck(uint8_t* buf)
-{
-    uint8_t data = 0;
-    if(buf[0] == 0xA5)
+    ServoTrajInit(cfg, pos);
+    if(ServoPwmInit(pins) != 0)
     {
-        data = (uint8_t)(buf[0] + buf[1] + buf[2]);
-        if(data == buf[3])
-        {
-            return 0;
-        }
-        else
-        {
-            osal_printk("dataCheck error.\r\n");
-            return 1;
-        }
-    }
-    else
-    {
-        return 1;
+        osal_printk("servo pwm init fail!\r\n");
     }
 }
-
-// void setAngle(uint8_t angle)
-// {
-//     uint8_t i = 0;
-//     uint32_t usDelay = 500 + angle * (2000) / 180; //us
-
-//     for(i=0; i<PWM_COUNT; i++)
-//     {
-//         PWM_HIGH;
-//         osal_udelay(usDelay);
-//         PWM_LOW;
-//         osal_udelay(20000 - usDelay);
-//     }
-// }
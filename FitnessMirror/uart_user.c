@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件实现板端串口1：以原始模式打开/dev/ttyAMA1，供servo_link下发角度、UART_AckTrd读取ACK。
+ *
+ * This file implements UART1 on the board: /dev/ttyAMA1 opened in raw mode, used by servo_link to send
+ * angles and by UART_AckTrd to read the ACKs.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "sample_media_ai.h"
+#include "uart_user.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define UART1_DEV           "/dev/ttyAMA1"
+#define UART1_BAUD          B115200
+#define UART1_TX_WAIT_MS    20 // Wait for room in the TX buffer at most this long per write
+
+static int g_uart1Fd = -1;
+
+int Uart1Init(void)
+{
+    struct termios tio;
+
+    g_uart1Fd = open(UART1_DEV, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (g_uart1Fd < 0) {
+        SAMPLE_PRT("open %s FAIL, errno=%d\n", UART1_DEV, errno);
+        return -1;
+    }
+    if (tcgetattr(g_uart1Fd, &tio) != 0) {
+        SAMPLE_PRT("tcgetattr %s FAIL, errno=%d\n", UART1_DEV, errno);
+        Uart1Close();
+        return -1;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, UART1_BAUD);
+    cfsetospeed(&tio, UART1_BAUD);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    tcflush(g_uart1Fd, TCIOFLUSH);
+    if (tcsetattr(g_uart1Fd, TCSANOW, &tio) != 0) {
+        SAMPLE_PRT("tcsetattr %s FAIL, errno=%d\n", UART1_DEV, errno);
+        Uart1Close();
+        return -1;
+    }
+    return 0;
+}
+
+int Uart1Send(const unsigned char *buf, int len)
+{
+    struct pollfd pfd = { .fd = g_uart1Fd, .events = POLLOUT };
+    int sent = 0;
+
+    while (sent < len) {
+        ssize_t n = write(g_uart1Fd, buf + sent, (size_t)(len - sent));
+        if (n > 0) {
+            sent += (int)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            if (poll(&pfd, 1, UART1_TX_WAIT_MS) <= 0) {
+                break;
+            }
+        } else {
+            return -1;
+        }
+    }
+    return sent;
+}
+
+int Uart1Read(unsigned char *buf, int len)
+{
+    ssize_t n = read(g_uart1Fd, buf, (size_t)len);
+
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    }
+    return (int)n;
+}
+
+int Uart1Fd(void)
+{
+    return g_uart1Fd;
+}
+
+void Uart1Close(void)
+{
+    if (g_uart1Fd >= 0) {
+        close(g_uart1Fd);
+        g_uart1Fd = -1;
+    }
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UART_USER_H
+#define UART_USER_H
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 板端到舵机MCU的串口1(/dev/ttyAMA1)，8N1原始模式，非阻塞
+ * 读线程用Uart1Fd()与其他fd一起poll，可读时再Uart1Read
+ *
+ * UART1 (/dev/ttyAMA1) from the board to the servo MCU, 8N1 raw mode, non-blocking.
+ * The reading thread poll()s Uart1Fd() together with other fds and calls Uart1Read once it is readable
+ */
+int Uart1Init(void);
+
+/*
+ * 写出len字节，返回写出的字节数，出错返回-1
+ * Write len bytes, returns the number written or -1 on error
+ */
+int Uart1Send(const unsigned char *buf, int len);
+
+/*
+ * 读出已到达的字节，不等待；没有数据时返回0，出错返回-1
+ * Read the bytes that have arrived without waiting, returns 0 when there are none and -1 on error
+ */
+int Uart1Read(unsigned char *buf, int len);
+
+/*
+ * 可poll的串口fd，未初始化时为-1
+ * The UART fd to poll, -1 before Uart1Init
+ */
+int Uart1Fd(void);
+
+void Uart1Close(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
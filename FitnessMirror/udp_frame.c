@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件实现视频帧UDP分片协议的头部序列化
+ *
+ * This file implements header serialization of the video frame UDP fragmentation protocol.
+ */
+
+#include <string.h>
+
+#include "misc_util.h"
+#include "udp_frame.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+static HI_U8* PutU16(HI_U8* p, HI_U16 v)
+{
+    p[0] = (HI_U8)(v >> 8); // 8: high byte
+    p[1] = (HI_U8)v;
+    return p + sizeof(v);
+}
+
+static HI_U8* PutU32(HI_U8* p, HI_U32 v)
+{
+    p = PutU16(p, (HI_U16)(v >> 16)); // 16: high half
+    return PutU16(p, (HI_U16)v);
+}
+
+static HI_U8* PutU64(HI_U8* p, HI_U64 v)
+{
+    p = PutU32(p, (HI_U32)(v >> 32)); // 32: high half
+    return PutU32(p, (HI_U32)v);
+}
+
+void UdpFrameHdrPack(const UdpFrameHdr* hdr, HI_U8* buf)
+{
+    HI_U8 *p = buf;
+
+    p = PutU16(p, hdr->magic);
+    *p++ = hdr->version;
+    *p++ = hdr->flags;
+    p = PutU32(p, hdr->frameId);
+    p = PutU16(p, hdr->fragIdx);
+    p = PutU16(p, hdr->fragCnt);
+    p = PutU16(p, hdr->payloadLen);
+    p = PutU16(p, hdr->fecGroup);
+    p = PutU32(p, hdr->frameLen);
+    p = PutU64(p, hdr->pts);
+    p = PutU64(p, hdr->sendUs);
+    HI_ASSERT(p - buf == UDP_FRAME_HDR_LEN);
+}
+
+void UdpFrameParityReset(HI_U8* parity)
+{
+    if (memset_s(parity, UDP_FRAME_PARITY_LEN, 0, UDP_FRAME_PARITY_LEN) != EOK) {
+        HI_ASSERT(0);
+    }
+}
+
+HI_U16 UdpFrameParityAdd(HI_U8* parity, HI_U16 parityLen, const HI_U8* data, HI_U16 len)
+{
+    HI_U8 *dst = parity + sizeof(HI_U16);
+
+    HI_ASSERT(len <= UDP_FRAME_PAYLOAD_MAX);
+    parity[0] ^= (HI_U8)(len >> 8); // 8: high byte
+    parity[1] ^= (HI_U8)len;
+    for (HI_U16 i = 0; i < len; i++) {
+        dst[i] ^= data[i];
+    }
+    len += sizeof(HI_U16);
+    return len > parityLen ? len : parityLen;
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
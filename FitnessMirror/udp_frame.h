@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UDP_FRAME_H
+#define UDP_FRAME_H
+
+#include "hi_type.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 视频帧UDP分片协议，每个数据报 = 固定头 + 一段编码帧(一张JPEG，或H.264/H.265的一个访问单元)
+ * 头部字段均为网络字节序，与 smart-fitness-web/udp_frame.py 保持一致
+ *
+ * Video frame fragmentation over UDP, every datagram = fixed header + one piece of the encoded frame
+ * (a JPEG, or one H.264/H.265 access unit). All header fields are in network byte order and must match
+ * smart-fitness-web/udp_frame.py
+ *
+ *  0       2   3   4       8     10     12     14     16      20      28       36
+ *  | magic |ver|flg|frameId|fragIdx|fragCnt|payLen|fecGrp| frameLen |  pts  | sendUs | payload...
+ *
+ * pts为VI采集时刻，sendUs为本帧开始发送的时刻，二者同为系统PTS时钟(微秒)，
+ * 接收端据此逐帧拆分板端耗时，frameId兼作帧序号，缺号即为丢帧
+ *
+ * pts is the VI capture time and sendUs the time the frame started going out, both on the system
+ * PTS clock in microseconds, so the receiver can split out the on-board latency of every frame.
+ * frameId doubles as the frame sequence number, a gap means a lost frame.
+ *
+ * 开启FEC时，每fecGroup个数据分片后跟一个XOR校验分片(flags带UDP_FRAME_FLAG_PARITY)，
+ * 其fragIdx为组号，负载 = 组内各分片长度的XOR(2字节) + 组内各分片负载补零到最长后的XOR，
+ * 接收端在一组内丢失一个分片时可由校验分片恢复
+ *
+ * With FEC on, every fecGroup data fragments are followed by one XOR parity fragment
+ * (flags has UDP_FRAME_FLAG_PARITY) whose fragIdx is the group number. Its payload is the XOR of
+ * the fragment lengths (2 bytes) followed by the XOR of the group payloads zero-padded to the longest,
+ * which lets the receiver rebuild any single fragment lost within the group.
+ *
+ * flags的第2、3位为编码格式(UDP_FRAME_CODEC_*)；UDP_FRAME_FLAG_KEY表示该帧可独立解码，
+ * 帧间编码时接收端丢帧后应丢弃后续帧直到下一个关键帧
+ *
+ * Bits 2-3 of flags carry the codec (UDP_FRAME_CODEC_*). UDP_FRAME_FLAG_KEY marks a frame that decodes
+ * on its own; with inter-frame coding the receiver drops what follows a lost frame until the next key frame.
+ */
+#define UDP_FRAME_MAGIC         0x464D // "FM"
+#define UDP_FRAME_VERSION       2
+#define UDP_FRAME_HDR_LEN       36
+#define UDP_FRAME_MTU           1400 // Datagram size kept under the Ethernet MTU so IP never fragments
+// Data payload budget; the 2 bytes kept back fit the length XOR, so a parity fragment stays within UDP_FRAME_MTU too
+#define UDP_FRAME_PAYLOAD_MAX   (UDP_FRAME_MTU - UDP_FRAME_HDR_LEN - sizeof(HI_U16))
+#define UDP_FRAME_PARITY_LEN    (UDP_FRAME_PAYLOAD_MAX + sizeof(HI_U16)) // Largest parity payload
+
+#define UDP_FRAME_FLAG_PARITY   0x01
+#define UDP_FRAME_FLAG_KEY      0x02 // Every JPEG, an H.264/H.265 IDR access unit with its parameter sets
+#define UDP_FRAME_CODEC_SHIFT   2
+#define UDP_FRAME_CODEC_MASK    0x0C
+#define UDP_FRAME_CODEC(codec)  (((codec) << UDP_FRAME_CODEC_SHIFT) & UDP_FRAME_CODEC_MASK)
+
+#define UDP_FRAME_CODEC_JPEG    0
+#define UDP_FRAME_CODEC_H264    1
+#define UDP_FRAME_CODEC_H265    2
+
+typedef struct UdpFrameHdr {
+    HI_U16 magic;
+    HI_U8 version;
+    HI_U8 flags;
+    HI_U32 frameId; // Increases by one per frame sent
+    HI_U16 fragIdx;
+    HI_U16 fragCnt;
+    HI_U16 payloadLen; // Bytes of payload in this datagram
+    HI_U16 fecGroup; // Data fragments per parity fragment, 0: no FEC
+    HI_U32 frameLen; // Bytes of the whole frame
+    HI_U64 pts; // Capture PTS of the frame, in microseconds
+    HI_U64 sendUs; // PTS clock when the first fragment was sent, in microseconds
+} UdpFrameHdr;
+
+/*
+ * 计算一帧需要的分片数
+ * Number of fragments needed by a frame of frameLen bytes
+ */
+#define UDP_FRAME_FRAG_NUM(frameLen) \
+    (((frameLen) + UDP_FRAME_PAYLOAD_MAX - 1) / UDP_FRAME_PAYLOAD_MAX)
+
+/*
+ * 将头部按网络字节序写入buf，buf至少UDP_FRAME_HDR_LEN字节
+ * Serialize the header into buf in network byte order, buf holds at least UDP_FRAME_HDR_LEN bytes
+ */
+void UdpFrameHdrPack(const UdpFrameHdr* hdr, HI_U8* buf);
+
+/*
+ * 清空校验负载，开始新的一组
+ * Clear the parity payload to start a new group
+ */
+void UdpFrameParityReset(HI_U8* parity);
+
+/*
+ * 将一个数据分片累加进校验负载，返回当前校验负载长度
+ * Accumulate one data fragment into the parity payload, returns the parity payload length so far
+ */
+HI_U16 UdpFrameParityAdd(HI_U8* parity, HI_U16 parityLen, const HI_U8* data, HI_U16 len);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件实现UDP发送的令牌桶限速及发送队列统计
+ *
+ * This file implements token bucket pacing and send queue accounting for the UDP sender.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include "sample_media_ai.h"
+#include "udp_pacer.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define US_PER_SEC          1000000
+#define PACER_SNDBUF_MIN    (64 * 1024)
+#define PACER_SLEEP_MIN_US  200 // Debts smaller than this are carried instead of slept
+
+static HI_U64 NowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (HI_U64)ts.tv_sec * US_PER_SEC + (HI_U64)ts.tv_nsec / 1000; // 1000: ns per us
+}
+
+void UdpPacerInit(UdpPacer* self, HI_U32 kbps, HI_U32 burstBytes)
+{
+    HI_ASSERT(self);
+    if (memset_s(self, sizeof(*self), 0, sizeof(*self)) != EOK) {
+        HI_ASSERT(0);
+    }
+    self->burstBytes = burstBytes;
+    self->tokens = burstBytes;
+    self->lastUs = NowUs();
+    UdpPacerSetRate(self, kbps);
+}
+
+void UdpPacerSetRate(UdpPacer* self, HI_U32 kbps)
+{
+    __atomic_store_n(&self->rateBytes, kbps * 1000 / 8, __ATOMIC_RELAXED); // 1000/8: kbit to byte
+}
+
+int UdpPacerSetSndBuf(const UdpPacer* self, int fd, HI_U32 latencyMs)
+{
+    int sndBuf = (int)((HI_U64)self->rateBytes * latencyMs / 1000); // 1000: ms per s
+    socklen_t optLen = sizeof(sndBuf);
+
+    if (sndBuf < PACER_SNDBUF_MIN) {
+        sndBuf = PACER_SNDBUF_MIN;
+    }
+    if (setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndBuf, sizeof(sndBuf)) < 0) {
+        SAMPLE_PRT("setsockopt SO_SNDBUF %d FAIL, errno=%d\n", sndBuf, errno);
+        return HI_FAILURE;
+    }
+    if (getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndBuf, &optLen) == 0) {
+        SAMPLE_PRT("udp SO_SNDBUF=%d\n", sndBuf);
+    }
+    return HI_SUCCESS;
+}
+
+void UdpPacerConsume(UdpPacer* self, HI_U32 bytes)
+{
+    HI_U32 rate = __atomic_load_n(&self->rateBytes, __ATOMIC_RELAXED);
+    HI_U64 now = NowUs();
+    HI_U64 elapsed = now - self->lastUs;
+    HI_U64 debtUs;
+
+    __atomic_fetch_add(&self->sentBytes, bytes, __ATOMIC_RELAXED);
+    self->lastUs = now;
+    if (rate == 0) {
+        return;
+    }
+    if (elapsed > US_PER_SEC) {
+        elapsed = US_PER_SEC;
+    }
+    self->tokens += (HI_S64)(elapsed * rate / US_PER_SEC);
+    if (self->tokens > (HI_S64)self->burstBytes) {
+        self->tokens = self->burstBytes;
+    }
+    self->tokens -= bytes;
+    if (self->tokens >= 0) {
+        return;
+    }
+
+    /*
+     * 欠账折算成睡眠时间，醒来后下一次调用按实际流逝时间补回令牌
+     * Turn the debt into sleep time, the next call refills by the time that actually passed
+     */
+    debtUs = (HI_U64)(-self->tokens) * US_PER_SEC / rate;
+    if (debtUs >= PACER_SLEEP_MIN_US) {
+        usleep((useconds_t)debtUs);
+        __atomic_fetch_add(&self->waitUs, (HI_U32)debtUs, __ATOMIC_RELAXED);
+    }
+}
+
+void UdpPacerSampleQueue(UdpPacer* self, int fd)
+{
+    int queued = 0;
+
+    if (ioctl(fd, TIOCOUTQ, &queued) < 0) {
+        return;
+    }
+    __atomic_store_n(&self->queuedBytes, (HI_U32)queued, __ATOMIC_RELAXED);
+    if ((HI_U32)queued > self->queuedMax) {
+        __atomic_store_n(&self->queuedMax, (HI_U32)queued, __ATOMIC_RELAXED);
+    }
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UDP_PACER_H
+#define UDP_PACER_H
+
+#include "hi_type.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UDP发送令牌桶，按目标码率匀速放出数据报，避免整帧突发打满Wi-Fi和socket缓冲
+ * 只由发送线程调用，计数器可被其他线程读取
+ *
+ * Token bucket for the UDP sender, releases datagrams at the target bitrate
+ * so a whole frame is not burst onto Wi-Fi and into the socket buffer at once.
+ * Only called by the sender thread, the counters may be read by other threads.
+ */
+typedef struct UdpPacer {
+    HI_U32 rateBytes; // Bytes per second, 0 means unpaced
+    HI_U32 burstBytes; // Bucket depth
+    HI_S64 tokens; // Bytes that may be sent now, negative while in debt
+    HI_U64 lastUs; // Time of the last refill
+
+    HI_U32 sentBytes; // Bytes handed to the kernel
+    HI_U32 waitUs; // Time spent waiting for tokens
+    HI_U32 queuedBytes; // Bytes in the socket send queue at the last sample
+    HI_U32 queuedMax; // Largest queuedBytes seen
+    HI_U32 eagainCnt; // sendmmsg calls that hit a full socket buffer
+    HI_U32 dropFrags; // Fragments given up after EAGAIN
+} UdpPacer;
+
+/*
+ * 初始化令牌桶，kbps为0表示不限速
+ * Init the token bucket, kbps 0 disables pacing
+ */
+void UdpPacerInit(UdpPacer* self, HI_U32 kbps, HI_U32 burstBytes);
+
+/*
+ * 修改目标码率
+ * Change the target bitrate
+ */
+void UdpPacerSetRate(UdpPacer* self, HI_U32 kbps);
+
+/*
+ * 按目标码率计算socket发送缓冲大小，能容纳latencyMs内的数据，并设置到fd
+ * Size the socket send buffer of fd to hold latencyMs worth of data at the target bitrate
+ */
+int UdpPacerSetSndBuf(const UdpPacer* self, int fd, HI_U32 latencyMs);
+
+/*
+ * 取走bytes字节的令牌，令牌不足时睡眠到够用为止
+ * Take bytes worth of tokens, sleeping until the bucket can cover them
+ */
+void UdpPacerConsume(UdpPacer* self, HI_U32 bytes);
+
+/*
+ * 采样fd发送队列中尚未发出的字节数
+ * Sample the bytes still queued in the send queue of fd
+ */
+void UdpPacerSampleQueue(UdpPacer* self, int fd);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * 该文件提供了VENC到UDP发送线程之间的内存交接。
+ * 编码输出的码流包直接拷贝进预分配的槽位，发送线程从槽位发送，
+ * 不再经过文件系统，也不在每帧malloc。
+ *
+ * This file provides the in-memory hand-off between VENC and the UDP sender thread.
+ * Encoded packs are copied straight into preallocated slots and the sender transmits from them,
+ * without going through the filesystem and without a malloc per frame.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "hi_mpi_venc.h"
+#include "sample_media_ai.h"
+#include "venc_ring.h"
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif /* End of #ifdef __cplusplus */
+
+#define VENC_RING_MASK    (VENC_RING_SLOT_NUM - 1)
+
+static VENC_PACK_S g_vencPacks[VENC_RING_PACK_MAX];
+
+int VencRingInit(VencRing* self, HI_U32 slotSize, PAYLOAD_TYPE_E type)
+{
+    HI_ASSERT(self);
+    HI_ASSERT((VENC_RING_SLOT_NUM & VENC_RING_MASK) == 0);
+
+    if (memset_s(self, sizeof(*self), 0, sizeof(*self)) != EOK) {
+        HI_ASSERT(0);
+    }
+    self->pool = (HI_U8*)malloc((size_t)slotSize * VENC_RING_SLOT_NUM);
+    if (self->pool == NULL) {
+        SAMPLE_PRT("venc ring malloc %u x %u FAIL\n", slotSize, VENC_RING_SLOT_NUM);
+        return HI_FAILURE;
+    }
+    self->slotSize = slotSize;
+    self->type = type;
+    for (int i = 0; i < VENC_RING_SLOT_NUM; i++) {
+        self->slots[i].data = self->pool + (size_t)slotSize * i;
+    }
+    return HI_SUCCESS;
+}
+
+void VencRingDeinit(VencRing* self)
+{
+    HI_ASSERT(self);
+    free(self->pool);
+    self->pool = NULL;
+}
+
+VencFrmSlot* VencRingWriteSlot(VencRing* self)
+{
+    HI_U32 head = self->head;
+    HI_U32 tail = __atomic_load_n(&self->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= VENC_RING_SLOT_NUM) {
+        return NULL;
+    }
+    return &self->slots[head & VENC_RING_MASK];
+}
+
+void VencRingCommit(VencRing* self)
+{
+    __atomic_store_n(&self->head, self->head + 1, __ATOMIC_RELEASE);
+}
+
+VencFrmSlot* VencRingReadSlot(VencRing* self)
+{
+    HI_U32 tail = self->tail;
+    HI_U32 head = __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return NULL;
+    }
+    return &self->slots[tail & VENC_RING_MASK];
+}
+
+void VencRingRelease(VencRing* self)
+{
+    __atomic_store_n(&self->tail, self->tail + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * H.264/H.265中含IDR片的码流包才可独立解码，JPEG每帧都可以
+ * Only H.264/H.265 packs holding an IDR slice decode on their own, every JPEG does
+ */
+static HI_BOOL VencPackIsKey(PAYLOAD_TYPE_E type, const VENC_PACK_S* pack)
+{
+    switch (type) {
+        case PT_H264:
+            return pack->DataType.enH264EType == H264E_NALU_IDRSLICE ? HI_TRUE : HI_FALSE;
+        case PT_H265:
+            return pack->DataType.enH265EType == H265E_NALU_IDRSLICE ? HI_TRUE : HI_FALSE;
+        default:
+            return HI_TRUE;
+    }
+}
+
+HI_S32 VencRingFill(VencRing* self, VENC_CHN vencChn, HI_S32 milliSec)
+{
+    VENC_CHN_STATUS_S stat;
+    VENC_STREAM_S stream;
+    VencFrmSlot *slot = NULL;
+    HI_U32 len = 0;
+    HI_S32 ret;
+
+    ret = HI_MPI_VENC_QueryStatus(vencChn, &stat);
+    if (ret != HI_SUCCESS) {
+        SAMPLE_PRT("HI_MPI_VENC_QueryStatus(%d) FAIL, ret=%#x\n", vencChn, ret);
+        return ret;
+    }
+    if (stat.u32CurPacks == 0 || stat.u32CurPacks > VENC_RING_PACK_MAX) {
+        stat.u32CurPacks = VENC_RING_PACK_MAX;
+    }
+
+    stream.pstPack = g_vencPacks;
+    stream.u32PackCount = stat.u32CurPacks;
+    ret = HI_MPI_VENC_GetStream(vencChn, &stream, milliSec);
+    if (ret != HI_SUCCESS) {
+        SAMPLE_PRT("HI_MPI_VENC_GetStream(%d) FAIL, ret=%#x\n", vencChn, ret);
+        return ret;
+    }
+
+    /*
+     * 环满时仍需取走码流，否则VENC缓冲会被占满
+     * Still drain the stream when the ring is full, otherwise the VENC buffer fills up
+     */
+    slot = VencRingWriteSlot(self);
+    if (slot == NULL) {
+        self->fullCnt++;
+        ret = HI_FAILURE;
+        goto RELEASE;
+    }
+
+    slot->key = HI_FALSE;
+    for (HI_U32 i = 0; i < stream.u32PackCount; i++) {
+        HI_U32 packLen = stream.pstPack[i].u32Len - stream.pstPack[i].u32Offset;
+        if (len + packLen > self->slotSize) {
+            self->truncCnt++;
+            ret = HI_FAILURE;
+            goto RELEASE;
+        }
+        if (memcpy_s(slot->data + len, self->slotSize - len,
+            stream.pstPack[i].pu8Addr + stream.pstPack[i].u32Offset, packLen) != EOK) {
+            ret = HI_FAILURE;
+            goto RELEASE;
+        }
+        len += packLen;
+        slot->key = slot->key || VencPackIsKey(self->type, &stream.pstPack[i]) ? HI_TRUE : HI_FALSE;
+    }
+    slot->len = len;
+    slot->pts = stream.pstPack[0].u64PTS;
+    slot->seq = stream.u32Seq;
+    VencRingCommit(self);
+
+RELEASE:
+    if (HI_MPI_VENC_ReleaseStream(vencChn, &stream) != HI_SUCCESS) {
+        SAMPLE_PRT("HI_MPI_VENC_ReleaseStream(%d) FAIL\n", vencChn);
+    }
+    return ret;
+}
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif
+#endif /* End of #ifdef __cplusplus */
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022 HiSilicon (Shanghai) Technologies CO., LIMITED.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VENC_RING_H
+#define VENC_RING_H
+
+#include "hi_type.h"
+#include "hi_comm_venc.h"
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#define VENC_RING_SLOT_NUM      4   // 必须为2的幂 / Must be a power of two
+#define VENC_RING_PACK_MAX      8   // Max packs of one encoded picture
+
+/*
+ * 编码帧槽位，data在初始化时一次性分配
+ * Encoded frame slot, data is allocated once at init
+ */
+typedef struct VencFrmSlot {
+    HI_U8 *data;
+    HI_U32 len;
+    HI_U64 pts; // PTS of the source frame, in microseconds
+    HI_U32 seq; // VENC stream sequence number
+    HI_BOOL key; // Decodes on its own, always true for JPEG
+} VencFrmSlot;
+
+/*
+ * 单生产者(编码)单消费者(UDP发送)的编码帧环形缓冲
+ * head只由生产者推进，tail只由消费者推进
+ *
+ * Single-producer (encoder) single-consumer (UDP sender) ring of encoded frames.
+ * head is only advanced by the producer, tail only by the consumer.
+ */
+typedef struct VencRing {
+    VencFrmSlot slots[VENC_RING_SLOT_NUM];
+    HI_U8 *pool;
+    HI_U32 slotSize;
+    PAYLOAD_TYPE_E type; // Payload of the VENC channel, tells key frames apart
+    HI_U32 head;
+    HI_U32 tail;
+    HI_U32 fullCnt; // Times the producer found no free slot
+    HI_U32 truncCnt; // Pictures dropped for being larger than slotSize
+} VencRing;
+
+/*
+ * 分配环形缓冲的全部槽位，type为VENC通道的编码格式
+ * Allocate all slots of the ring, type is the payload of the VENC channel
+ */
+int VencRingInit(VencRing* self, HI_U32 slotSize, PAYLOAD_TYPE_E type);
+
+/*
+ * 释放环形缓冲
+ * Free the ring
+ */
+void VencRingDeinit(VencRing* self);
+
+/*
+ * 获取下一个可写槽位，环满时返回NULL
+ * Get the next writable slot, NULL when the ring is full
+ */
+VencFrmSlot* VencRingWriteSlot(VencRing* self);
+
+/*
+ * 提交VencRingWriteSlot返回的槽位
+ * Publish the slot returned by VencRingWriteSlot
+ */
+void VencRingCommit(VencRing* self);
+
+/*
+ * 获取下一个可读槽位，环空时返回NULL
+ * Get the next readable slot, NULL when the ring is empty
+ */
+VencFrmSlot* VencRingReadSlot(VencRing* self);
+
+/*
+ * 归还VencRingReadSlot返回的槽位
+ * Give back the slot returned by VencRingReadSlot
+ */
+void VencRingRelease(VencRing* self);
+
+/*
+ * 从VENC通道取一帧码流，直接拷贝到下一个可写槽位并提交
+ * Get one stream from the VENC channel, copy its packs straight into the next writable slot and publish it
+ */
+HI_S32 VencRingFill(VencRing* self, VENC_CHN vencChn, HI_S32 milliSec);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+板子与中继之间的 NTP 式对时，走板子的应答端口 9999，与 FitnessMirror/clock_sync.h 保持一致
+
+中继发起 "SYNC t1 p1 p2 p3 p4"，板子应答 "SYNCR t1 t2 t3"
+t1/t4 为中继墙钟，t2/t3 为板子 PTS 时钟，单位微秒；p1..p4 为上一轮完整的四个时间戳（没有则为 0），
+这样板子也拿到全部时间戳，两端用同一个滤波器各自维护偏移估计
+
+滤波：最近 FILTER_NUM 个样本中取往返时延最小者作为当前偏移，再对最近 DRIFT_NUM 个选中样本
+做最小二乘得到漂移；偏移方向为 中继时钟 - 板子时钟
+"""
+
+import asyncio
+import logging
+from collections import deque
+from typing import Callable, NamedTuple, Optional
+
+from udp_frame import now_us
+
+SYNC_PORT        = 9999     # 板子的应答端口
+SYNC_PERIOD      = 1.0      # 对时间隔秒数
+FILTER_NUM       = 8
+DRIFT_NUM        = 32
+DRIFT_MIN_PICKS  = 4
+DRIFT_MIN_SPAN   = 10_000_000   # 至少 10 秒的样本才拟合漂移
+
+
+class ClockSample(NamedTuple):
+    board_us: int       # 取样时刻，t2 与 t3 的中点
+    offset_us: int      # 中继 - 板子
+    delay_us: int       # 往返时延，不含板子处理时间
+
+
+class ClockSync:
+    """板子 PTS 时钟到中继墙钟的偏移与漂移估计"""
+
+    def __init__(self):
+        self.filt = deque(maxlen=FILTER_NUM)
+        self.picked = deque(maxlen=DRIFT_NUM)
+        self.best: Optional[ClockSample] = None
+        self.drift_ppb = 0
+        self.samples = 0
+        self.last_delay_us = 0      # 最近一次对时的往返时延，供码率控制判断排队
+        self._pending = 0           # 已发出、尚未应答的 t1
+        self._last = (0, 0, 0, 0)   # 上一轮完整的 t1..t4
+
+    @property
+    def synced(self) -> bool:
+        return self.best is not None
+
+    def add(self, t1: int, t2: int, t3: int, t4: int):
+        if t4 < t1 or t3 < t2 or t4 - t1 < t3 - t2:
+            return
+        sample = ClockSample(t2 + (t3 - t2) // 2, ((t1 - t2) + (t4 - t3)) // 2, (t4 - t1) - (t3 - t2))
+        self.filt.append(sample)
+        self.samples += 1
+        self.last_delay_us = sample.delay_us
+        best = min(self.filt, key=lambda s: s.delay_us)
+        if best is not self.best:
+            self.best = best
+            self.picked.append(best)
+            self.drift_ppb = self._fit_drift()
+
+    def _fit_drift(self) -> int:
+        pts = list(self.picked)
+        if len(pts) < DRIFT_MIN_PICKS:
+            return 0
+        x0 = min(s.board_us for s in pts)
+        if max(s.board_us for s in pts) - x0 < DRIFT_MIN_SPAN:
+            return 0
+        xs = [s.board_us - x0 for s in pts]
+        ys = [s.offset_us - pts[0].offset_us for s in pts]
+        mx, my = sum(xs) / len(xs), sum(ys) / len(ys)
+        sxx = sum((x - mx) ** 2 for x in xs)
+        sxy = sum((x - mx) * (y - my) for x, y in zip(xs, ys))
+        return int(sxy / sxx * 1e9) if sxx else 0
+
+    def offset_at(self, board_us: int) -> int:
+        """板子时刻 board_us 处的偏移，板子时钟 + 偏移 = 中继墙钟"""
+        if self.best is None:
+            return 0
+        return self.best.offset_us + (board_us - self.best.board_us) * self.drift_ppb // 1_000_000_000
+
+    def to_relay(self, board_us: int) -> int:
+        return board_us + self.offset_at(board_us)
+
+    def ping(self) -> bytes:
+        """生成一次对时请求，附带上一轮的时间戳"""
+        self._pending = now_us()
+        msg = ("SYNC %d %d %d %d %d" % ((self._pending,) + self._last)).encode("ascii")
+        self._last = (0, 0, 0, 0)   # 每轮只转交一次，避免板子重复计入
+        return msg
+
+    def on_reply(self, data: bytes, t4: int):
+        try:
+            tag, t1, t2, t3 = data.decode("ascii").split()
+            t1, t2, t3 = int(t1), int(t2), int(t3)
+        except ValueError:
+            return
+        if tag != "SYNCR" or t1 != self._pending:
+            return      # 非对时应答，或是迟到的旧应答
+        self._pending = 0
+        self._last = (t1, t2, t3, t4)
+        self.add(t1, t2, t3, t4)
+
+    def log_stats(self):
+        if self.best is None:
+            logging.info("🕒 对时: 尚未同步")
+            return
+        logging.info(f"🕒 对时: 偏移 {self.best.offset_us} us, 往返 {self.best.delay_us} us, "
+                     f"漂移 {self.drift_ppb / 1000:.1f} ppm, 样本 {self.samples}")
+
+
+class _SyncProtocol(asyncio.DatagramProtocol):
+    def __init__(self, sync: ClockSync):
+        self.sync = sync
+
+    def datagram_received(self, data: bytes, addr):
+        self.sync.on_reply(data, now_us())     # 收到即打 t4
+
+
+async def clock_sync_pinger(sync: ClockSync, board_ip: Callable[[], Optional[str]], period: float = SYNC_PERIOD,
+                            feedback: Optional[Callable[[], bytes]] = None):
+    """
+    周期向板子发对时请求；board_ip() 返回 None 时（尚未发现板子）跳过本轮
+    给出 feedback 时同一周期顺带发送它生成的码率反馈（FB 消息）
+    """
+    loop = asyncio.get_running_loop()
+    transport, _ = await loop.create_datagram_endpoint(lambda: _SyncProtocol(sync), local_addr=("0.0.0.0", 0))
+    tick = 0
+    try:
+        while True:
+            ip = board_ip()
+            if ip:
+                transport.sendto(sync.ping(), (ip, SYNC_PORT))
+                if feedback is not None:
+                    transport.sendto(feedback(), (ip, SYNC_PORT))
+                tick += 1
+                if tick % 60 == 0:
+                    sync.log_stats()
+            await asyncio.sleep(period)
+    finally:
+        transport.close()
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+板子视频帧的解码，编码格式取自帧头 flags，与 FitnessMirror/udp_frame.h 保持一致
+
+JPEG 每帧独立解码；H.264/H.265 用 PyAV 按帧序连续解码，必须在中继出队丢帧之前逐帧送入。
+frameId 缺号（含重组失败丢弃的帧）或解码出错后，丢弃后续帧直到关键帧，
+并经板子的应答端口发 "IDR" 请求关键帧，不必等下一个 GOP
+"""
+
+import logging
+import socket
+import time
+from typing import Callable, Optional
+
+import av
+import cv2
+import numpy as np
+
+from udp_frame import CODEC_H264, CODEC_H265, CODEC_JPEG, Frame
+
+IDR_PORT        = 9999      # 板子的应答端口
+IDR_RETRY       = 0.5       # 等关键帧期间重复请求的间隔秒数
+JPEG_QUALITY    = 85        # 转发给浏览器时重新编码 JPEG 的质量
+
+_AV_CODEC = {CODEC_H264: "h264", CODEC_H265: "hevc"}
+
+
+class FrameDecoder:
+    """把板子的帧解成 BGR 图像；board_ip() 返回 None 时（尚未发现板子）不发关键帧请求"""
+
+    def __init__(self, board_ip: Callable[[], Optional[str]]):
+        self.board_ip = board_ip
+        self.skipped = 0            # 等关键帧期间丢弃的帧
+        self.errors = 0             # 解码出错的帧
+        self.idr_requests = 0
+        self._codec = None
+        self._ctx = None
+        self._last_seq = None
+        self._need_key = True
+        self._last_request = 0.0
+        self._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self._sock.setblocking(False)
+
+    def decode(self, frame: Frame) -> Optional[np.ndarray]:
+        """返回 BGR 图像；帧不可解（等关键帧、解码出错、解码器尚无输出）时返回 None"""
+        if frame.codec == CODEC_JPEG:
+            return cv2.imdecode(np.frombuffer(frame.data, dtype=np.uint8), cv2.IMREAD_COLOR)
+        if frame.codec not in _AV_CODEC:
+            self.errors += 1
+            return None
+
+        if frame.codec != self._codec:
+            self._codec = frame.codec
+            self._ctx = av.CodecContext.create(_AV_CODEC[frame.codec], "r")
+            self._need_key = True
+            logging.info(f"🎞️ 码流格式: {_AV_CODEC[frame.codec]}")
+        if self._last_seq is not None and ((frame.seq - self._last_seq) & 0xFFFFFFFF) != 1:
+            self._need_key = True   # 中间有帧丢失，参考链已断
+        self._last_seq = frame.seq
+
+        if self._need_key:
+            if not frame.key:
+                self.skipped += 1
+                self._request_key()
+                return None
+            self._need_key = False
+        try:
+            images = self._ctx.decode(av.Packet(frame.data))
+        except Exception as e:
+            logging.warning(f"解码 {_AV_CODEC[frame.codec]} 失败，等待关键帧: {e}")
+            self.errors += 1
+            self._need_key = True
+            self._request_key()
+            return None
+        return images[-1].to_ndarray(format="bgr24") if images else None
+
+    def to_jpeg(self, frame: Frame) -> Optional[bytes]:
+        """WebSocket 转发用：JPEG 原样返回，H.264/H.265 解码后重新编码成 JPEG"""
+        if frame.codec == CODEC_JPEG:
+            return frame.data
+        bgr = self.decode(frame)
+        if bgr is None:
+            return None
+        ok, jpeg = cv2.imencode(".jpg", bgr, [cv2.IMWRITE_JPEG_QUALITY, JPEG_QUALITY])
+        return jpeg.tobytes() if ok else None
+
+    def _request_key(self):
+        ip = self.board_ip()
+        now = time.monotonic()
+        if ip is None or now - self._last_request < IDR_RETRY:
+            return
+        self._last_request = now
+        try:
+            self._sock.sendto(b"IDR", (ip, IDR_PORT))
+            self.idr_requests += 1
+        except OSError as e:
+            logging.warning(f"关键帧请求发送失败: {e}")
+
+    def log_stats(self):
+        if self._codec is not None:
+            logging.info(f"🎞️ 解码: 等关键帧丢弃 {self.skipped} 帧, 出错 {self.errors} 帧, "
+                         f"请求关键帧 {self.idr_requests} 次")
@@ -0,0 +1,79 @@
+import { defineStore } from 'pinia';
+import { ref } from 'vue';
+import { frameTiming, type FrameMeta, type FrameTiming } from '@/utils/frameMeta';
+
+// 各段时延的 p50 / p95（毫秒）
+export type LatencySummary = Record<Exclude<keyof FrameTiming, 'seq'>, { p50: number; p95: number }>;
+
+const HOPS = ['board', 'net', 'relay', 'link', 'browser', 'glass'] as const;
+
+// 中继与板子的对时状态，synced 为 false 时偏移是按帧估计的
+export interface ClockState {
+  synced: boolean;
+  offsetUs: number;
+  driftPpm: number;
+  rttUs: number;
+}
+
+export const useLatencyStore = defineStore('latency', () => {
+  const MAX_FRAMES = 300;     // 保留最近 300 帧的逐帧时延
+  const SUMMARY_EVERY = 30;   // 每 30 帧刷新一次统计，避免每帧触发界面更新
+
+  // 逐帧记录不做响应式，只在刷新统计时对外可见
+  const frames: FrameTiming[] = [];
+  const latest = ref<FrameTiming | null>(null);
+  const summary = ref<LatencySummary | null>(null);
+  const lost = ref(0);        // 按 seq 缺号统计的丢帧
+  const clock = ref<ClockState | null>(null);
+  let lastMeta: FrameMeta | null = null;
+  let lastSeq: number | null = null;
+  let sinceSummary = 0;
+
+  const percentile = (sorted: number[], p: number) =>
+    sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+
+  const refresh = () => {
+    const s = {} as LatencySummary;
+    for (const hop of HOPS) {
+      const v = frames.map((f) => f[hop]).sort((a, b) => a - b);
+      s[hop] = { p50: percentile(v, 0.5), p95: percentile(v, 0.95) };
+    }
+    summary.value = s;
+    latest.value = frames[frames.length - 1];
+    if (lastMeta) {
+      clock.value = {
+        synced: lastMeta.syncRttUs > 0,
+        offsetUs: lastMeta.offsetUs,
+        driftPpm: lastMeta.driftPpb / 1000,
+        rttUs: lastMeta.syncRttUs,
+      };
+    }
+  };
+
+  /**
+   * 记录一帧；arriveUs / shownUs 为浏览器收到和绘制完成的墙钟微秒
+   */
+  const record = (meta: FrameMeta, arriveUs: number, shownUs: number) => {
+    if (lastSeq !== null) {
+      const gap = (meta.seq - lastSeq) >>> 0;
+      if (gap > 1 && gap < 0x80000000) {
+        lost.value += gap - 1;
+      }
+    }
+    lastSeq = meta.seq;
+    lastMeta = meta;
+
+    frames.push(frameTiming(meta, arriveUs, shownUs));
+    if (frames.length > MAX_FRAMES) {
+      frames.shift();
+    }
+    if (++sinceSummary >= SUMMARY_EVERY) {
+      sinceSummary = 0;
+      refresh();
+    }
+  };
+
+  const recent = (): readonly FrameTiming[] => frames;
+
+  return { latest, summary, lost, clock, record, recent };
+});
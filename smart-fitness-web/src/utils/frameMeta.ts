@@ -0,0 +1,110 @@
+// src/utils/frameMeta.ts
+
+/**
+ * 中继随每帧转发的时间元数据，与 udp_frame.py 中的 FrameMeta 保持一致
+ * 时间单位均为微秒：pts / sendUs 为板子 PTS 时钟，recvUs / relayUs 为中继墙钟，
+ * 板子时钟 + offsetUs ≈ 中继墙钟（offsetUs 已按漂移修正到该帧的 pts 时刻）
+ */
+export interface FrameMeta {
+  seq: number;
+  pts: number;      // 采集时刻
+  sendUs: number;   // 板子开始发送
+  recvUs: number;   // 中继收齐
+  relayUs: number;  // 中继转发
+  offsetUs: number;
+  driftPpb: number; // 对时得到的漂移
+  syncRttUs: number; // 对时往返时延，0 表示中继尚未与板子对时，offsetUs 为按帧估计
+}
+
+/**
+ * 单帧各段时延（毫秒）
+ * board: 采集 -> 板子发送，net: 板子 -> 中继，relay: 中继内部，
+ * link: 中继 -> 浏览器收到，browser: 收到 -> 绘制完成，glass: 采集 -> 绘制完成
+ */
+export interface FrameTiming {
+  seq: number;
+  board: number;
+  net: number;
+  relay: number;
+  link: number;
+  browser: number;
+  glass: number;
+}
+
+const META_MAGIC = 0x4654; // "FT"
+const META_VERSION = 1;
+const META_LEN = 56;
+
+/**
+ * 当前墙钟（微秒），与中继的 time.time_ns() 同一时钟
+ */
+export const nowUs = (): number => (performance.timeOrigin + performance.now()) * 1000;
+
+/**
+ * 把 performance.now() 体系的时间戳（毫秒）换算成墙钟微秒
+ */
+export const perfToUs = (t: number): number => (performance.timeOrigin + t) * 1000;
+
+/**
+ * 拆分 WebSocket 二进制消息：元数据（版本见第 3 字节，长度见第 4 字节）+ JPEG
+ * 没有元数据前缀（旧中继直接发 JPEG）或版本不认识时 meta 为 null
+ */
+export const parseWsFrame = (buf: ArrayBuffer): { meta: FrameMeta | null; jpeg: Blob } => {
+  const view = new DataView(buf);
+  if (buf.byteLength < META_LEN || view.getUint16(0) !== META_MAGIC) {
+    return { meta: null, jpeg: new Blob([buf], { type: 'image/jpeg' }) };
+  }
+  const hdrLen = view.getUint8(3);
+  if (view.getUint8(2) !== META_VERSION || hdrLen < META_LEN) {
+    return { meta: null, jpeg: new Blob([new Uint8Array(buf, hdrLen)], { type: 'image/jpeg' }) };
+  }
+  const meta: FrameMeta = {
+    seq: view.getUint32(4),
+    pts: Number(view.getBigUint64(8)),
+    sendUs: Number(view.getBigUint64(16)),
+    recvUs: Number(view.getBigUint64(24)),
+    relayUs: Number(view.getBigUint64(32)),
+    offsetUs: Number(view.getBigInt64(40)),
+    driftPpb: view.getInt32(48),
+    syncRttUs: view.getUint32(52),
+  };
+  return { meta, jpeg: new Blob([new Uint8Array(buf, hdrLen)], { type: 'image/jpeg' }) };
+};
+
+/**
+ * WebRTC 数据通道里的 JSON 元数据
+ */
+export const metaFromJson = (obj: Record<string, number>): FrameMeta => ({
+  seq: obj.seq,
+  pts: obj.pts,
+  sendUs: obj.sendUs,
+  recvUs: obj.recvUs,
+  relayUs: obj.relayUs,
+  offsetUs: obj.offsetUs,
+  driftPpb: obj.driftPpb ?? 0,
+  syncRttUs: obj.syncRttUs ?? 0,
+});
+
+/**
+ * 板子 PTS 时钟换算到墙钟（中继与浏览器共用）
+ */
+export const boardToWallUs = (meta: FrameMeta, boardUs: number): number =>
+  boardUs + meta.offsetUs + ((boardUs - meta.pts) * meta.driftPpb) / 1e9;
+
+/**
+ * 由元数据和浏览器侧的收到/绘制时刻（墙钟微秒）计算各段时延
+ * 板子时钟经 offsetUs 换算到中继墙钟；link 段假定浏览器与中继墙钟一致（通常在同一台机器上）
+ */
+export const frameTiming = (meta: FrameMeta, arriveUs: number, shownUs: number): FrameTiming => {
+  const captureUs = boardToWallUs(meta, meta.pts);
+  const ms = (us: number) => us / 1000;
+  return {
+    seq: meta.seq,
+    board: ms(meta.sendUs - meta.pts),
+    net: ms(meta.recvUs - boardToWallUs(meta, meta.sendUs)),
+    relay: ms(meta.relayUs - meta.recvUs),
+    link: ms(arriveUs - meta.relayUs),
+    browser: ms(shownUs - arriveUs),
+    glass: ms(shownUs - captureUs),
+  };
+};
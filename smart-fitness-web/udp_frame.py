@@ -0,0 +1,311 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+板子视频帧 UDP 分片协议的解析与重组，与 FitnessMirror/udp_frame.h 保持一致
+
+每个数据报 = 36 字节头 + 一段编码帧（一张 JPEG，或 H.264/H.265 的一个访问单元），头部字段为网络字节序：
+    magic(H) ver(B) flags(B) frameId(I) fragIdx(H) fragCnt(H) payloadLen(H) fecGroup(H) frameLen(I) pts(Q) sendUs(Q)
+pts 为采集时刻、sendUs 为板子开始发送该帧的时刻，均为板子 PTS 时钟（微秒）；frameId 即帧序号
+除最后一片外，每片 payload 长度相同，因此分片偏移 = fragIdx * payloadLen
+
+fecGroup 非 0 时，每 fecGroup 个数据分片跟一个 XOR 校验分片（flags & FLAG_PARITY，fragIdx 为组号），
+校验负载 = 组内长度 XOR(H) + 组内负载补零后的 XOR，一组内丢一片可以恢复
+
+flags 第 2、3 位为编码格式（CODEC_*），FLAG_KEY 表示该帧可独立解码（JPEG 每帧都是）
+
+中继转发给浏览器时，每帧带上时间元数据（WebSocket 为二进制前缀，WebRTC 为数据通道 JSON），
+字段见 FrameMeta；浏览器据此逐帧计算端到端（glass-to-glass）与各段时延
+"""
+
+import asyncio
+import logging
+import struct
+import time
+from collections import deque
+from typing import NamedTuple
+
+FRAME_MAGIC    = 0x464D     # "FM"
+FRAME_VERSION  = 2
+FLAG_PARITY    = 0x01
+FLAG_KEY       = 0x02       # 可独立解码：JPEG，或带参数集的 H.264/H.265 IDR
+CODEC_SHIFT    = 2
+CODEC_MASK     = 0x0C
+CODEC_JPEG     = 0
+CODEC_H264     = 1
+CODEC_H265     = 2
+HDR            = struct.Struct("!HBBIHHHHIQQ")
+HDR_LEN        = HDR.size   # 36
+
+META_MAGIC     = 0x4654     # "FT"，WebSocket 消息的元数据前缀
+META_VERSION   = 1
+META           = struct.Struct("!HBBIQQQQqiI")
+META_LEN       = META.size  # 56
+
+CLOCK_WINDOW   = 300        # 未对时时，板子时钟偏移取最近多少帧的最小值
+
+MAX_PENDING    = 4          # 同时重组中的帧数上限
+PENDING_TTL    = 0.5        # 未完成帧的最长等待秒数
+RESTART_GAP    = 300        # frameId 前后跳变超过这么多帧视为板子重启后的新码流
+
+
+def now_us() -> int:
+    """中继本机的墙钟时间（微秒），浏览器用 performance.timeOrigin 对齐到同一时钟"""
+    return time.time_ns() // 1000
+
+
+class Frame(NamedTuple):
+    seq: int            # frameId
+    pts: int            # 采集时刻，板子时钟
+    send_us: int        # 板子发送时刻，板子时钟
+    recv_us: int        # 中继收齐时刻，中继时钟
+    data: bytes
+    flags: int = 0      # 编码格式与 FLAG_KEY
+
+    @property
+    def codec(self) -> int:
+        return (self.flags & CODEC_MASK) >> CODEC_SHIFT
+
+    @property
+    def key(self) -> bool:
+        return bool(self.flags & FLAG_KEY)
+
+
+class FrameMeta(NamedTuple):
+    """随帧转发给浏览器的时间元数据，时间单位均为微秒"""
+    seq: int
+    pts: int            # 板子时钟
+    send_us: int        # 板子时钟
+    recv_us: int        # 中继时钟
+    relay_us: int       # 中继转发时刻，中继时钟
+    offset_us: int      # 板子时钟 + offset_us ≈ 中继时钟
+    drift_ppb: int      # 对时得到的漂移，未对时为 0
+    sync_rtt_us: int    # 对时往返时延，0 表示未对时、offset_us 为按帧估计
+
+    def pack(self) -> bytes:
+        """WebSocket 二进制消息的前缀，后接 JPEG（H.264/H.265 由中继解码后转成 JPEG）"""
+        return META.pack(META_MAGIC, META_VERSION, META_LEN, self.seq & 0xFFFFFFFF,
+                         self.pts, self.send_us, self.recv_us, self.relay_us, self.offset_us,
+                         self.drift_ppb, self.sync_rtt_us)
+
+    def to_json(self) -> dict:
+        return {"seq": self.seq, "pts": self.pts, "sendUs": self.send_us, "recvUs": self.recv_us,
+                "relayUs": self.relay_us, "offsetUs": self.offset_us, "driftPpb": self.drift_ppb,
+                "syncRttUs": self.sync_rtt_us}
+
+
+class BoardClock:
+    """
+    板子 PTS 时钟到中继时钟的偏移：有对时（clock_sync.ClockSync）时用对时结果，
+    否则取最近 CLOCK_WINDOW 帧 (recv_us - send_us) 的最小值，即把最小单向时延计入偏移，
+    此时网络段时延反映的是超出最小时延的部分
+    """
+
+    def __init__(self, sync=None):
+        self.sync = sync
+        self.samples = deque(maxlen=CLOCK_WINDOW)
+        self.offset_us = 0
+
+    def update(self, frame: Frame) -> int:
+        if self.sync is not None and self.sync.synced:
+            self.offset_us = self.sync.offset_at(frame.pts)
+        elif frame.send_us:
+            self.samples.append(frame.recv_us - frame.send_us)
+            self.offset_us = min(self.samples)
+        return self.offset_us
+
+    def meta(self, frame: Frame) -> FrameMeta:
+        """中继转发前调用，relay_us 取当前时刻"""
+        if self.sync is not None and self.sync.synced:
+            return FrameMeta(frame.seq, frame.pts, frame.send_us, frame.recv_us, now_us(),
+                             self.sync.offset_at(frame.pts), self.sync.drift_ppb, self.sync.best.delay_us)
+        return FrameMeta(frame.seq, frame.pts, frame.send_us, frame.recv_us, now_us(), self.offset_us, 0, 0)
+
+
+def _newer(a: int, b: int) -> bool:
+    """32 位帧号比较，允许回绕"""
+    return a != b and ((a - b) & 0xFFFFFFFF) < 0x80000000
+
+
+def _xor(a: bytes, b: bytes) -> bytes:
+    """按较长者补零后逐字节 XOR"""
+    n = max(len(a), len(b))
+    return (int.from_bytes(a.ljust(n, b"\0"), "big") ^ int.from_bytes(b.ljust(n, b"\0"), "big")).to_bytes(n, "big")
+
+
+class _Partial:
+    __slots__ = ("buf", "got", "lens", "remaining", "pts", "send_us", "flags", "born", "group", "parity")
+
+    def __init__(self, frame_len: int, frag_cnt: int, group: int, pts: int, send_us: int, flags: int):
+        self.buf = bytearray(frame_len)
+        self.got = bytearray(frag_cnt)
+        self.lens = [0] * frag_cnt
+        self.remaining = frag_cnt
+        self.pts = pts
+        self.send_us = send_us
+        self.flags = flags & ~FLAG_PARITY
+        self.born = time.monotonic()
+        self.group = group
+        self.parity = {}        # 组号 -> 校验负载
+
+    def put(self, idx: int, payload: bytes) -> bool:
+        cnt, flen, plen = len(self.got), len(self.buf), len(payload)
+        off = flen - plen if idx == cnt - 1 else idx * plen
+        if off < 0 or off + plen > flen:
+            return False
+        self.buf[off:off + plen] = payload
+        self.got[idx] = 1
+        self.lens[idx] = plen
+        self.remaining -= 1
+        return True
+
+    def payload(self, idx: int) -> bytes:
+        plen = self.lens[idx]
+        off = len(self.buf) - plen if idx == len(self.got) - 1 else idx * plen
+        return bytes(self.buf[off:off + plen])
+
+    def recover(self, g: int) -> bool:
+        """组 g 恰好缺一片且有校验分片时恢复该片"""
+        parity = self.parity.get(g)
+        if parity is None:
+            return False
+        members = range(g * self.group, min((g + 1) * self.group, len(self.got)))
+        missing = [i for i in members if not self.got[i]]
+        if len(missing) != 1:
+            return False
+        plen = int.from_bytes(parity[:2], "big")
+        data = parity[2:]
+        for i in members:
+            if self.got[i]:
+                plen ^= self.lens[i]
+                data = _xor(data, self.payload(i))
+        del self.parity[g]
+        return 0 < plen <= len(data) and self.put(missing[0], data[:plen])
+
+
+class FrameReassembler:
+    """
+    按 frameId 重组分片；一帧完整后，比它旧的未完成帧全部丢弃
+    feed() 返回 Frame 或 None
+    """
+
+    def __init__(self):
+        self.pending = {}
+        self.last_done = None
+        self.completed = 0
+        self.dropped = 0        # 未收齐被丢弃的帧
+        self.recovered = 0      # 由校验分片恢复的分片
+        self.bad = 0            # 头部非法的数据报
+        self.lost = 0           # 完成帧之间 frameId 的缺号，含整帧未到达的
+        self.restarts = 0       # 检测到的码流重新开始（板子重启）次数
+        self._done_at = 0.0     # 最近完成一帧的时刻
+        self._fb_last = (0, 0, 0)   # 上次反馈时的 completed / lost / recovered
+
+    def feed(self, packet: bytes):
+        if len(packet) < HDR_LEN:
+            self.bad += 1
+            return None
+        magic, ver, flags, fid, idx, cnt, plen, group, flen, pts, send_us = HDR.unpack_from(packet)
+        parity = bool(flags & FLAG_PARITY)
+        if (magic != FRAME_MAGIC or ver != FRAME_VERSION or len(packet) < HDR_LEN + plen
+                or plen == 0 or flen == 0 or (parity and group == 0)
+                or idx >= ((cnt + group - 1) // group if parity else cnt)):
+            self.bad += 1
+            return None
+        if self.last_done is not None and not _newer(fid, self.last_done):
+            if not self._restarted(fid):
+                return None     # 迟到的分片，所属帧已输出或已丢弃
+
+        part = self.pending.get(fid)
+        if part is None:
+            self._expire()
+            part = self.pending[fid] = _Partial(flen, cnt, group, pts, send_us, flags)
+        if len(part.got) != cnt or len(part.buf) != flen or part.group != group:
+            self.bad += 1
+            return None
+
+        payload = packet[HDR_LEN:HDR_LEN + plen]
+        if parity:
+            g = idx
+            part.parity[g] = payload
+        else:
+            if part.got[idx]:
+                return None
+            if not part.put(idx, payload):
+                self.bad += 1
+                return None
+            g = idx // group if group else None
+        if g is not None and part.remaining and part.recover(g):
+            self.recovered += 1
+        if part.remaining:
+            return None
+
+        del self.pending[fid]
+        for old in [k for k in self.pending if _newer(fid, k)]:
+            del self.pending[old]
+            self.dropped += 1
+        if self.last_done is not None:
+            gap = ((fid - self.last_done) & 0xFFFFFFFF) - 1
+            if gap < RESTART_GAP:   # 更大的跳变是新码流，不计入丢帧，免得码率控制误判
+                self.lost += gap
+        self.last_done = fid
+        self._done_at = time.monotonic()
+        self.completed += 1
+        return Frame(fid, part.pts, part.send_us, now_us(), bytes(part.buf), part.flags)
+
+    def _restarted(self, fid: int) -> bool:
+        """
+        旧帧号的分片：大幅回退，或已超过 PENDING_TTL 没有完成帧，视为板子重启后 frameId 从头开始，
+        清空重组状态重新同步；否则只是迟到的分片
+        """
+        back = (self.last_done - fid) & 0xFFFFFFFF
+        if back < RESTART_GAP and time.monotonic() - self._done_at <= PENDING_TTL:
+            return False
+        logging.info(f"🔄 frameId {self.last_done} -> {fid}，码流重新开始")
+        self.restarts += 1
+        self.dropped += len(self.pending)
+        self.pending.clear()
+        self.last_done = None
+        return True
+
+    def _expire(self):
+        now = time.monotonic()
+        for fid in [k for k, p in self.pending.items() if now - p.born > PENDING_TTL]:
+            del self.pending[fid]
+            self.dropped += 1
+        while len(self.pending) >= MAX_PENDING:
+            oldest = min(self.pending, key=lambda k: self.pending[k].born)
+            del self.pending[oldest]
+            self.dropped += 1
+
+    def feedback(self, rtt_us: int) -> bytes:
+        """
+        生成给板子码率控制的反馈 "FB frames lost recovered rttUs"，前三项为上次反馈以来的增量，
+        与 FitnessMirror/abr_ctrl.h 保持一致
+        """
+        cur = (self.completed, self.lost, self.recovered)
+        frames, lost, recovered = (c - l for c, l in zip(cur, self._fb_last))
+        self._fb_last = cur
+        return ("FB %d %d %d %d" % (frames, lost, recovered, rtt_us)).encode("ascii")
+
+    def log_stats(self):
+        logging.info(f"📊 重组: 完成 {self.completed} 帧, 丢失 {self.lost} 帧 (其中未收齐丢弃 {self.dropped}), "
+                     f"FEC 恢复 {self.recovered} 片, 非法包 {self.bad}, 码流重启 {self.restarts} 次")
+
+
+class FrameProtocol(asyncio.DatagramProtocol):
+    """
+    在事件循环上按数据报到达即重组，不占着循环等包，对时回包的收包时刻 t4 因而不被推迟；
+    收齐一帧回调 on_frame(frame, addr)，解码等耗时工作由调用方交给执行器
+    """
+
+    def __init__(self, reasm: FrameReassembler, on_frame):
+        self.reasm = reasm
+        self.on_frame = on_frame
+
+    def datagram_received(self, data, addr):
+        done = self.reasm.feed(data)
+        if done is not None:
+            self.on_frame(done, addr)
+
+    def error_received(self, exc):
+        logging.warning(f"UDP接收错误: {exc}")
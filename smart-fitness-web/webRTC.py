@@ -5,7 +5,7 @@ import json
 import logging
 import os
 import socket
-import time
+from concurrent.futures import ThreadPoolExecutor
 from fractions import Fraction
 
 import cv2
@@ -16,6 +16,10 @@ import aiohttp_cors
 from aiortc import MediaStreamTrack, RTCPeerConnection, RTCSessionDescription
 from av import VideoFrame
 
+from clock_sync import ClockSync, clock_sync_pinger
+from frame_decode import FrameDecoder
+from udp_frame import CODEC_JPEG, BoardClock, FrameProtocol, FrameReassembler
+
 # =================================================================
 # 全局资源区
 # =================================================================
@@ -69,89 +73,112 @@ async def broadcast_presence(host_ip, broadcast_port=9999):
 # =================================================================
 # UDP推流接收逻辑
 # =================================================================
-async def udp_video_receiver(queue: janus.Queue, ready_event: asyncio.Event, udp_ip="0.0.0.0", udp_port=8888):
-    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
-    sock.bind((udp_ip, udp_port))
-    sock.settimeout(0.01)
+async def udp_video_receiver(queue: janus.Queue, ready_event: asyncio.Event, sync: ClockSync, board: dict,
+                             reasm: FrameReassembler, udp_ip="0.0.0.0", udp_port=8888):
+    loop = asyncio.get_running_loop()
     logging.info(f"🚀 异步UDP视频接收器启动 | 正在监听 {udp_ip}:{udp_port}...")
     logging.info("🚦 WebRTC服务将等待首次数据到达后再接受连接。")
 
-    jpg_start = b'\xff\xd8'
-    jpg_end = b'\xff\xd9'
-    data_buffer = b""
-
-    while True:
-        try:
-            packet, _ = sock.recvfrom(65536)
-            data_buffer += packet
-        except socket.timeout:
-            await asyncio.sleep(0.001)
-            continue
-        except Exception as e:
-            logging.warning(f"UDP接收错误: {e}")
-            continue
-
-        start = data_buffer.find(jpg_start)
-        if start != -1:
-            end = data_buffer.find(jpg_end, start)
-            if end != -1:
-                end += 2
-                frame_data = data_buffer[start:end]
-                data_buffer = data_buffer[end:]
-
-                if queue.sync_q.full():
-                    try:
-                        queue.sync_q.get_nowait()
-                    except Exception:
-                        pass
-                queue.sync_q.put(frame_data)
-
-                # --- 修复2：重新加入“绿灯”信号逻辑 ---
-                if not ready_event.is_set():
-                    logging.info("✅ 首次接收到有效视频帧，WebRTC服务现已开放连接！")
-                    ready_event.set()
-                # # 通知 ready
-                # app = queue._loop._current_handle.app  # hack to get app? Instead, pass event separately
+    # reasm 按帧头重组分片，收不齐的帧直接丢弃
+    clock = BoardClock(sync)
+    # 帧间编码须按序逐帧解码，所以在这里解码，而不是在队满会丢帧的 recv() 中；
+    # 单线程执行器按提交顺序逐帧解码，不占事件循环。JPEG 每帧独立，留到 recv() 再解
+    decoder = FrameDecoder(lambda: board.get("ip"))
+    decode_pool = ThreadPoolExecutor(max_workers=1)
+
+    def put(done, bgr):
+        if queue.sync_q.full():
+            try:
+                queue.sync_q.get_nowait()
+            except Exception:
+                pass
+        queue.sync_q.put((done, bgr, clock))
+
+        # --- 修复2：重新加入“绿灯”信号逻辑 ---
+        if not ready_event.is_set():
+            logging.info("✅ 首次接收到有效视频帧，WebRTC服务现已开放连接！")
+            ready_event.set()
+
+    def decoded(done, fut):
+        if fut.cancelled():
+            return
+        if fut.exception() is not None:
+            logging.warning(f"解码错误: {fut.exception()}")
+            return
+        if fut.result() is not None:
+            put(done, fut.result())
+
+    def on_frame(done, addr):
+        board["ip"] = addr[0]   # 对时请求发往视频的来源地址
+        clock.update(done)
+        if reasm.completed % 300 == 0:
+            reasm.log_stats()
+            decoder.log_stats()
+        if done.codec == CODEC_JPEG:
+            put(done, None)
+        else:
+            fut = loop.run_in_executor(decode_pool, decoder.decode, done)
+            fut.add_done_callback(lambda f: decoded(done, f))
+
+    transport, _ = await loop.create_datagram_endpoint(lambda: FrameProtocol(reasm, on_frame),
+                                                       local_addr=(udp_ip, udp_port))
+    try:
+        await loop.create_future()  # 收包全在回调里，这里只守着传输直到任务被取消
+    finally:
+        transport.close()
+        decode_pool.shutdown(wait=False)
 
 
 # =================================================================
 # WebRTC 视频轨道
 # =================================================================
 class UdpVideoStreamTrack(MediaStreamTrack):
+    """
+    视频帧的 pts 直接取板子采集 PTS（换算到 90kHz），浏览器由 rtpTimestamp 对上帧；
+    每帧的时间元数据经数据通道 "frame-meta" 以 JSON 发出
+    """
     kind = "video"
 
     def __init__(self, queue: janus.Queue):
         super().__init__()
         self.queue = queue
+        self.meta_channel = None
         # 定义我们希望输出给浏览器的标准视频尺寸
         self.TARGET_WIDTH = 1280
         self.TARGET_HEIGHT = 720
-        self._start_time = time.time()
 
     async def recv(self):
-        frame_data = await self.queue.async_q.get()
-
-        np_arr = np.frombuffer(frame_data, dtype=np.uint8)
-        bgr = cv2.imdecode(np_arr, cv2.IMREAD_COLOR)
-        if bgr is None:
+        frame, bgr, clock = await self.queue.async_q.get()
+        # 解码、缩放与转 YUV 都放到执行器，事件循环只负责收发
+        video_frame = await asyncio.get_running_loop().run_in_executor(None, self._to_video_frame, frame, bgr)
+        if video_frame is None:
             logging.warning("解码 JPEG 失败，跳过此帧")
             return await self.recv()
 
+        if self.meta_channel is not None and self.meta_channel.readyState == "open":
+            meta = clock.meta(frame).to_json()
+            meta["rtp"] = video_frame.pts & 0xFFFFFFFF
+            self.meta_channel.send(json.dumps(meta))
+        return video_frame
+
+    @staticmethod
+    def _to_video_frame(frame, bgr):
+        if bgr is None:
+            bgr = cv2.imdecode(np.frombuffer(frame.data, dtype=np.uint8), cv2.IMREAD_COLOR)
+            if bgr is None:
+                return None
+
         h, w = bgr.shape[:2]
         bgr = cv2.resize(bgr, (w // 2, h // 2), interpolation=cv2.INTER_LINEAR)
 
-        elapsed = time.time() - self._start_time
-        pts = int(elapsed * 90000)
-
         video_frame = VideoFrame.from_ndarray(bgr, format="bgr24")
         video_frame = video_frame.reformat(
             width=bgr.shape[1],
             height=bgr.shape[0],
             format="yuv420p"
         )
-        video_frame.pts = pts
+        video_frame.pts = frame.pts * 9 // 100     # 微秒 -> 90kHz
         video_frame.time_base = Fraction(1, 90000)
-
         return video_frame
 
 # =================================================================
@@ -183,6 +210,11 @@ async def offer(request):
     video_track = UdpVideoStreamTrack(frame_queue)
     pc.addTrack(video_track)
 
+    @pc.on("datachannel")
+    def on_datachannel(channel):
+        if channel.label == "frame-meta":
+            video_track.meta_channel = channel
+
     await pc.setRemoteDescription(offer)
     answer = await pc.createAnswer()
     await pc.setLocalDescription(answer)
@@ -210,8 +242,16 @@ async def start_background_tasks(app):
     logging.info("后台任务启动：正在创建UDP接收器和广播器...")
 
     # 现在从 app 上下文中获取资源并传递给任务
+    app['clock_sync'] = ClockSync()
+    app['board'] = {}
+    app['reasm'] = FrameReassembler()   # 重组统计同时用作板子码率控制的反馈
     app['udp_receiver'] = asyncio.create_task(
-        udp_video_receiver(app['frame_queue'], app['udp_source_ready'])
+        udp_video_receiver(app['frame_queue'], app['udp_source_ready'], app['clock_sync'], app['board'],
+                           app['reasm'])
+    )
+    app['clock_pinger'] = asyncio.create_task(
+        clock_sync_pinger(app['clock_sync'], lambda: app['board'].get('ip'),
+                          feedback=lambda: app['reasm'].feedback(app['clock_sync'].last_delay_us))
     )
     host_ip = get_local_ip()
     app['udp_broadcaster'] = asyncio.create_task(broadcast_presence(host_ip))
@@ -221,8 +261,10 @@ async def cleanup_background_tasks(app):
     logging.info("正在清理后台任务...")
     app['udp_receiver'].cancel()
     app['udp_broadcaster'].cancel()
+    app['clock_pinger'].cancel()
     await app['udp_receiver']
     await app['udp_broadcaster']
+    await app['clock_pinger']
 
 
 if __name__ == "__main__":
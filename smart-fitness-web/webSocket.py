@@ -5,8 +5,13 @@
 import asyncio
 import logging
 import socket
+from concurrent.futures import ThreadPoolExecutor
 import websockets
 import json
+
+from clock_sync import ClockSync, clock_sync_pinger
+from frame_decode import FrameDecoder
+from udp_frame import CODEC_JPEG, BoardClock, FrameProtocol, FrameReassembler
 # =================================================================
 # 全局配置
 # =================================================================
@@ -29,6 +34,10 @@ MAX_RETRIES    = 3          # 最多重试次数
 CONNECTED      = set()      # 活跃的 WebSocket 客户端
 board_addr     = None       # 板子的 (ip, port)
 first_frame_event: asyncio.Event
+clock_sync     = ClockSync()  # 与板子对时（应答端口上的 SYNC/SYNCR）
+board_clock    = BoardClock(clock_sync) # 板子 PTS 时钟到本机时钟的换算
+reasm          = FrameReassembler()     # 分片重组，统计同时用作码率反馈
+decoder        = FrameDecoder(lambda: board_addr[0] if board_addr else None) # H.264/H.265 转成 JPEG
 command_queue: asyncio.Queue  # 存 bytes 命令
 
 # =================================================================
@@ -71,37 +80,54 @@ async def broadcast_presence(host_ip, broadcast_port=BROADCAST_PORT):
 # UDP 帧生产者
 # =================================================================
 async def udp_frame_producer(queue: asyncio.Queue):
-    global board_addr
-    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
-    sock.bind((UDP_IP, UDP_PORT))
-    sock.settimeout(0.01)
+    loop = asyncio.get_running_loop()
+    # 帧间编码须逐帧按序解码，所以在入队（队满丢帧）之前；单线程执行器保序且不占事件循环
+    decode_pool = ThreadPoolExecutor(max_workers=1)
+    first = True
+
+    def put(done, jpeg):
+        nonlocal first
+        done = done._replace(data=jpeg)
+        if first:
+            first = False
+            first_frame_event.set()
+            logging.info("✅ 首帧接收成功，WS 推送就绪")
+        elif reasm.completed % 300 == 0:
+            reasm.log_stats()
+            decoder.log_stats()
+        if queue.full():
+            _ = queue.get_nowait()
+        queue.put_nowait(done)
+
+    def encoded(done, fut):
+        if fut.cancelled():
+            return
+        if fut.exception() is not None:
+            logging.warning(f"转码错误: {fut.exception()}")
+            return
+        if fut.result() is not None:
+            put(done, fut.result())
+
+    def on_frame(done, addr):
+        global board_addr
+        if board_addr is None:
+            board_addr = (addr[0], CMD_PORT)
+            logging.info(f"🔗 发现板子地址: {board_addr}")
+        board_clock.update(done)
+        if done.codec == CODEC_JPEG:
+            put(done, done.data)
+        else:
+            fut = loop.run_in_executor(decode_pool, decoder.to_jpeg, done)
+            fut.add_done_callback(lambda f: encoded(done, f))
+
+    transport, _ = await loop.create_datagram_endpoint(lambda: FrameProtocol(reasm, on_frame),
+                                                       local_addr=(UDP_IP, UDP_PORT))
     logging.info(f"🚀 UDP 启动: 监听 {UDP_IP}:{UDP_PORT}")
-    jpg_start, jpg_end = b'\xff\xd8', b'\xff\xd9'
-    buf, first = b"", True
-    while True:
-        try:
-            packet, addr = sock.recvfrom(65536)
-            buf += packet
-            if board_addr is None:
-                board_addr = (addr[0], CMD_PORT)
-                logging.info(f"🔗 发现板子地址: {board_addr}")
-        except socket.timeout:
-            await asyncio.sleep(0.001)
-            continue
-        i = buf.find(jpg_start)
-        if i != -1:
-            j = buf.find(jpg_end, i+2)
-            if j != -1:
-                j += 2
-                frame = buf[i:j]
-                buf = buf[j:]
-                if first:
-                    first = False
-                    first_frame_event.set()
-                    logging.info("✅ 首帧接收成功，WS 推送就绪")
-                if queue.full():
-                    _ = queue.get_nowait()
-                await queue.put(frame)
+    try:
+        await loop.create_future()  # 收包全在回调里，这里只守着传输
+    finally:
+        transport.close()
+        decode_pool.shutdown(wait=False)
 
 # =================================================================
 # 命令发送协程（直接转发收到的 bytes，并校验 ACK0/ACK1/ACK2）
@@ -179,14 +205,15 @@ async def ws_handler(ws: websockets.WebSocketServerProtocol):
         logging.info(f"🔌 WS 客户端断开: {ws.remote_address}")
 
 # =================================================================
-# 帧广播协程
+# 帧广播协程（每帧 = 56 字节时间元数据 + JPEG，格式见 udp_frame.FrameMeta）
 # =================================================================
 async def broadcaster(queue: asyncio.Queue):
     logging.info("📢 广播协程启动")
     while True:
         frame = await queue.get()
         if CONNECTED:
-            await asyncio.gather(*[ws.send(frame) for ws in CONNECTED], return_exceptions=True)
+            msg = board_clock.meta(frame).pack() + frame.data
+            await asyncio.gather(*[ws.send(msg) for ws in CONNECTED], return_exceptions=True)
         queue.task_done()
 
 # =================================================================
@@ -202,6 +229,8 @@ async def main():
     asyncio.create_task(broadcaster(frame_queue))
     asyncio.create_task(broadcast_presence(host_ip))
     asyncio.create_task(command_sender())
+    asyncio.create_task(clock_sync_pinger(clock_sync, lambda: board_addr[0] if board_addr else None,
+                                          feedback=lambda: reasm.feedback(clock_sync.last_delay_us)))
     ws_srv = await websockets.serve(ws_handler, WS_HOST, WS_PORT)
     logging.info(f"✅ WS 服务启动: ws://{WS_HOST}:{WS_PORT} (本机 IP: {host_ip})")
     await ws_srv.wait_closed()